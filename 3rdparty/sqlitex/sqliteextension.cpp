@@ -25,10 +25,20 @@
 #include <QDebug>
 
 #include <sqlite3.h>
-#include <qzregexp.h>
+#include <string.h>
+#include <QRegularExpression>
+
+static inline ushort asciiToLower( ushort c )
+{
+  return ( ( c >= 'A' ) && ( c <= 'Z' ) ) ? ( c + ( 'a' - 'A' ) ) : c;
+}
 
 static int localeCompare( void* /*arg*/, int len1, const void* data1, int len2, const void* data2 )
 {
+  // identical strings are equal in every locale
+  if ( ( len1 == len2 ) && ( memcmp( data1, data2, len1 ) == 0 ) )
+    return 0;
+
   QString string1 = QString::fromRawData( reinterpret_cast<const QChar*>( data1 ), len1 / sizeof( QChar ) );
   QString string2 = QString::fromRawData( reinterpret_cast<const QChar*>( data2 ), len2 / sizeof( QChar ) );
 
@@ -37,30 +47,69 @@ static int localeCompare( void* /*arg*/, int len1, const void* data1, int len2,
 
 static int nocaseCompare( void* /*arg*/, int len1, const void* data1, int len2, const void* data2 )
 {
-  QString string1 = QString::fromRawData( reinterpret_cast<const QChar*>( data1 ), len1 / sizeof( QChar ) );
-  QString string2 = QString::fromRawData( reinterpret_cast<const QChar*>( data2 ), len2 / sizeof( QChar ) );
+  const ushort* chars1 = reinterpret_cast<const ushort*>( data1 );
+  const ushort* chars2 = reinterpret_cast<const ushort*>( data2 );
+  int size1 = len1 / sizeof( QChar );
+  int size2 = len2 / sizeof( QChar );
+
+  // compare ASCII prefix without Unicode case folding, it gives the same order
+  int i = 0;
+  for ( ; ( i < size1 ) && ( i < size2 ); ++i ) {
+    ushort c1 = chars1[ i ];
+    ushort c2 = chars2[ i ];
+    if ( ( c1 >= 0x80 ) || ( c2 >= 0x80 ) )
+      break;
+    c1 = asciiToLower( c1 );
+    c2 = asciiToLower( c2 );
+    if ( c1 != c2 )
+      return c1 - c2;
+  }
+  if ( ( i == size1 ) || ( i == size2 ) )
+    return size1 - size2;
+
+  QString string1 = QString::fromRawData( reinterpret_cast<const QChar*>( chars1 + i ), size1 - i );
+  QString string2 = QString::fromRawData( reinterpret_cast<const QChar*>( chars2 + i ), size2 - i );
 
   return QString::compare( string1, string2, Qt::CaseInsensitive );
 }
 
+static void deleteRegExp( void* data )
+{
+  delete static_cast<QRegularExpression*>( data );
+}
+
 static void regexpFunction( sqlite3_context* context, int /*argc*/, sqlite3_value** argv )
 {
-  int len1 = sqlite3_value_bytes16( argv[ 0 ] );
-  const void* data1 = sqlite3_value_text16( argv[ 0 ] );
   int len2 = sqlite3_value_bytes16( argv[ 1 ] );
   const void* data2 = sqlite3_value_text16( argv[ 1 ] );
 
-  if ( !data1 || !data2 )
+  if ( !sqlite3_value_text16( argv[ 0 ] ) || !data2 )
     return;
 
-  // do not use fromRawData for pattern string because it may be cached internally by the regexp engine
-  QString string1 = QString::fromRawData( reinterpret_cast<const QChar*>( data1 ), len1 / sizeof( QChar ) );
+  // compiled pattern is kept by SQLite while the pattern argument stays constant
+  QRegularExpression* pattern = static_cast<QRegularExpression*>( sqlite3_get_auxdata( context, 0 ) );
+  QRegularExpression* newPattern = NULL;
+  if ( !pattern ) {
+    int len1 = sqlite3_value_bytes16( argv[ 0 ] );
+    const void* data1 = sqlite3_value_text16( argv[ 0 ] );
+
+    // do not use fromRawData for pattern string because it may be cached internally by the regexp engine
+    QString string1( reinterpret_cast<const QChar*>( data1 ), len1 / sizeof( QChar ) );
+    newPattern = new QRegularExpression( string1, QRegularExpression::DotMatchesEverythingOption |
+                                         QRegularExpression::CaseInsensitiveOption );
+    // compile and JIT the pattern at once, it is used for many rows
+    newPattern->optimize();
+    pattern = newPattern;
+  }
+
   QString string2 = QString::fromRawData( reinterpret_cast<const QChar*>( data2 ), len2 / sizeof( QChar ) );
+  bool match = pattern->match( string2 ).hasMatch();
 
-  QzRegExp pattern( string1, Qt::CaseInsensitive);
-  int pos = pattern.indexIn( string2 );
+  // SQLite may delete pattern right away, so it is not used after this call
+  if ( newPattern )
+    sqlite3_set_auxdata( context, 0, newPattern, &deleteRegExp );
 
-  sqlite3_result_int( context, (pos > -1) ? 1 : 0 );
+  sqlite3_result_int( context, match ? 1 : 0 );
 }
 
 static void upperFunction(sqlite3_context* context, int /*argc*/, sqlite3_value** argv)
@@ -70,10 +119,44 @@ static void upperFunction(sqlite3_context* context, int /*argc*/, sqlite3_value*
 
   if (!data) return;
 
-  QString string = QString::fromRawData(reinterpret_cast<const QChar*>(data), len/sizeof(QChar));
+  const ushort* chars = reinterpret_cast<const ushort*>(data);
+  int size = len/sizeof(QChar);
+
+  // ASCII text is converted without QString, Unicode text is left to Qt
+  bool ascii = true;
+  bool hasLower = false;
+  for (int i = 0; i < size; ++i) {
+    if (chars[i] >= 0x80) {
+      ascii = false;
+      break;
+    }
+    if ((chars[i] >= 'a') && (chars[i] <= 'z'))
+      hasLower = true;
+  }
+
+  if (ascii) {
+    if (!hasLower && (sqlite3_value_type(argv[0]) == SQLITE_TEXT)) {
+      sqlite3_result_value(context, argv[0]);
+      return;
+    }
+
+    ushort* upper = static_cast<ushort*>(sqlite3_malloc(len > 0 ? len : 1));
+    if (!upper) {
+      sqlite3_result_error_nomem(context);
+      return;
+    }
+    for (int i = 0; i < size; ++i) {
+      ushort c = chars[i];
+      upper[i] = ((c >= 'a') && (c <= 'z')) ? (c - ('a' - 'A')) : c;
+    }
+    sqlite3_result_text16(context, upper, len, sqlite3_free);
+    return;
+  }
+
+  QString string = QString::fromRawData(reinterpret_cast<const QChar*>(data), size);
   string = string.toUpper();
 
-  sqlite3_result_text16(context, string.data(), -1, SQLITE_TRANSIENT);
+  sqlite3_result_text16(context, string.constData(), string.size()*sizeof(QChar), SQLITE_TRANSIENT);
 }
 
 void installSQLiteExtension( sqlite3* db )
@@ -0,0 +1,153 @@
+/**************************************************************************
+* Extensible SQLite driver for Qt4/Qt5
+* Copyright (C) 2011-2021 QuiteRSS Team <quiterssteam@gmail.com>
+*
+* This library is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License version 2.1
+* as published by the Free Software Foundation.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library.  If not, see <https://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include "sqliteextension.h"
+
+#include <QtTest>
+
+#include <sqlite3.h>
+
+const int kRowsCount = 20000;
+
+/**
+* Benchmark of UPPER, NOCASE and LOCALE of SQLite extension.
+* Table news_ascii goes through ASCII fast paths, table news_unicode
+* (Cyrillic titles) through Qt.
+*/
+class SQLiteXBench : public QObject
+{
+  Q_OBJECT
+private slots:
+  void initTestCase();
+  void cleanupTestCase();
+  void function_data();
+  void function();
+
+private:
+  bool exec(const QString &query);
+  bool fillTable(const QString &table, const QStringList &words);
+
+  sqlite3 *db_;
+};
+
+void SQLiteXBench::initTestCase()
+{
+  QCOMPARE(sqlite3_open(":memory:", &db_), SQLITE_OK);
+  installSQLiteExtension(db_);
+
+  QStringList asciiWords;
+  asciiWords << "Release" << "of" << "Qt" << "Linux" << "kernel" << "desktop"
+             << "update" << "news" << "feed" << "reader";
+  QVERIFY(fillTable("news_ascii", asciiWords));
+
+  QStringList unicodeWords;
+  unicodeWords << QString::fromUtf8("Выпуск") << QString::fromUtf8("новой")
+               << QString::fromUtf8("версии") << QString::fromUtf8("ядра")
+               << QString::fromUtf8("Линукс") << QString::fromUtf8("обновление")
+               << QString::fromUtf8("рабочего") << QString::fromUtf8("стола")
+               << QString::fromUtf8("новости") << QString::fromUtf8("ленты");
+  QVERIFY(fillTable("news_unicode", unicodeWords));
+}
+
+void SQLiteXBench::cleanupTestCase()
+{
+  sqlite3_close(db_);
+}
+
+void SQLiteXBench::function_data()
+{
+  QTest::addColumn<QString>("query");
+
+  QStringList tables;
+  tables << "news_ascii" << "news_unicode";
+  foreach (const QString &table, tables) {
+    QTest::newRow(qPrintable("UPPER " + table))
+        << QString("SELECT UPPER(title) FROM %1").arg(table);
+    QTest::newRow(qPrintable("NOCASE " + table))
+        << QString("SELECT title FROM %1 ORDER BY title COLLATE NOCASE").arg(table);
+    QTest::newRow(qPrintable("LOCALE " + table))
+        << QString("SELECT title FROM %1 ORDER BY title COLLATE LOCALE").arg(table);
+  }
+}
+
+void SQLiteXBench::function()
+{
+  QFETCH(QString, query);
+
+  sqlite3_stmt *stmt = NULL;
+  QCOMPARE(sqlite3_prepare16_v2(db_, query.utf16(), -1, &stmt, NULL), SQLITE_OK);
+
+  int rows = 0;
+  QBENCHMARK {
+    rows = 0;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+      // text16 is read as the application does, so UTF-16 results are not converted
+      sqlite3_column_text16(stmt, 0);
+      ++rows;
+    }
+    sqlite3_reset(stmt);
+  }
+  sqlite3_finalize(stmt);
+
+  QCOMPARE(rows, kRowsCount);
+}
+
+bool SQLiteXBench::exec(const QString &query)
+{
+  char *errmsg = NULL;
+  if (sqlite3_exec(db_, query.toUtf8().constData(), NULL, NULL, &errmsg) != SQLITE_OK) {
+    qWarning() << __PRETTY_FUNCTION__ << __LINE__ << errmsg;
+    sqlite3_free(errmsg);
+    return false;
+  }
+  return true;
+}
+
+/** Fill table with news-like titles of 8 words and a version number */
+bool SQLiteXBench::fillTable(const QString &table, const QStringList &words)
+{
+  if (!exec(QString("CREATE TABLE %1(title varchar)").arg(table)) ||
+      !exec("BEGIN"))
+    return false;
+
+  sqlite3_stmt *stmt = NULL;
+  QString query = QString("INSERT INTO %1(title) VALUES (?)").arg(table);
+  if (sqlite3_prepare16_v2(db_, query.utf16(), -1, &stmt, NULL) != SQLITE_OK)
+    return false;
+
+  bool ok = true;
+  for (int i = 0; ok && (i < kRowsCount); ++i) {
+    QString title;
+    for (int j = 0; j < 8; ++j) {
+      QString word = words.at((i + j * 7) % words.count());
+      // mix letter case as titles of feeds do
+      title.append((i + j) % 3 ? word : word.toLower()).append(' ');
+    }
+    title.append(QString("%1.%2").arg(i % 7).arg(i % 13));
+
+    sqlite3_bind_text16(stmt, 1, title.utf16(), title.size()*sizeof(QChar),
+                        SQLITE_TRANSIENT);
+    ok = (sqlite3_step(stmt) == SQLITE_DONE);
+    sqlite3_reset(stmt);
+  }
+  sqlite3_finalize(stmt);
+
+  return exec("COMMIT") && ok;
+}
+
+QTEST_GUILESS_MAIN(SQLiteXBench)
+#include "sqlitexbench.moc"
@@ -87,6 +87,9 @@ HEADERS += \
     src/cleanupwizard.h \
     src/updatefeeds.h \
     src/requestfeed.h \
+    src/feedparser.h \
+    src/feedsanitizer.h \
+    src/feedscheduler.h \
     src/notifications/notificationsfeeditem.h \
     src/notifications/notificationsnewsitem.h \
     src/notifications/notificationswidget.h \
@@ -96,7 +99,7 @@ HEADERS += \
     src/application/mainwindow.h \
     src/adblock/adblocktreewidget.h \
     src/adblock/adblocksubscription.h \
-    src/adblock/adblocksearchtree.h \
+    src/adblock/adblockruleindex.h \
     src/adblock/adblockrule.h \
     src/adblock/adblockmanager.h \
     src/adblock/adblockicon.h \
@@ -106,13 +109,16 @@ HEADERS += \
     src/adblock/followredirectreply.h \
     src/application/splashscreen.h \
     src/network/authenticationdialog.h \
+    src/network/contentdecoder.h \
     src/network/cookiejar.h \
+    src/network/networkdiskcache.h \
     src/network/networkmanager.h \
     src/webview/locationbar.h \
     src/webview/rssdetectionwidget.h \
     src/webview/webpage.h \
     src/webview/webview.h \
     src/database/database.h \
+    src/database/databaseschema.h \
     src/common/common.h \
     src/common/delegatewithoutfocus.h \
     src/common/dialog.h \
@@ -122,6 +128,7 @@ HEADERS += \
     src/newsfilters/newsfiltersdialog.h \
     src/newsfilters/itemcondition.h \
     src/newsfilters/itemaction.h \
+    src/newsfilters/userfilters.h \
     src/network/sslerrordialog.h \
     src/network/networkmanagerproxy.h \
     src/adblock/adblockmatcher.h \
@@ -154,6 +161,9 @@ SOURCES += \
     src/cleanupwizard.cpp \
     src/updatefeeds.cpp \
     src/requestfeed.cpp \
+    src/feedparser.cpp \
+    src/feedsanitizer.cpp \
+    src/feedscheduler.cpp \
     src/notifications/notificationsfeeditem.cpp \
     src/notifications/notificationsnewsitem.cpp \
     src/notifications/notificationswidget.cpp \
@@ -165,7 +175,7 @@ SOURCES += \
     src/main/main.cpp \
     src/adblock/adblocktreewidget.cpp \
     src/adblock/adblocksubscription.cpp \
-    src/adblock/adblocksearchtree.cpp \
+    src/adblock/adblockruleindex.cpp \
     src/adblock/adblockrule.cpp \
     src/adblock/adblockmanager.cpp \
     src/adblock/adblockicon.cpp \
@@ -175,7 +185,9 @@ SOURCES += \
     src/adblock/followredirectreply.cpp \
     src/application/splashscreen.cpp \
     src/network/authenticationdialog.cpp \
+    src/network/contentdecoder.cpp \
     src/network/cookiejar.cpp \
+    src/network/networkdiskcache.cpp \
     src/network/networkmanager.cpp \
     src/webview/locationbar.cpp \
     src/webview/rssdetectionwidget.cpp \
@@ -191,6 +203,7 @@ SOURCES += \
     src/newsfilters/newsfiltersdialog.cpp \
     src/newsfilters/itemcondition.cpp \
     src/newsfilters/itemaction.cpp \
+    src/newsfilters/userfilters.cpp \
     src/network/sslerrordialog.cpp \
     src/network/networkmanagerproxy.cpp \
     src/adblock/adblockmatcher.cpp \
@@ -240,6 +253,18 @@ os2|win32|mac {
   TARGET = QuiteRSS
 }
 
+# Decoding of compressed feeds
+unix:!mac {
+  CONFIG += link_pkgconfig
+  PKGCONFIG += zlib
+  packagesExist(libbrotlidec) {
+    PKGCONFIG += libbrotlidec
+    DEFINES += HAVE_BROTLI
+  }
+} else {
+  LIBS += -lz
+}
+
 win32 {
   RC_FILE = QuiteRSSApp.rc
 }
@@ -131,19 +131,19 @@ QNetworkReply* AdBlockManager::block(const QNetworkRequest &request)
   return 0;
 }
 
-QStringList AdBlockManager::disabledRules() const
+QSet<QString> AdBlockManager::disabledRules() const
 {
   return m_disabledRules;
 }
 
 void AdBlockManager::addDisabledRule(const QString &filter)
 {
-  m_disabledRules.append(filter);
+  m_disabledRules.insert(filter);
 }
 
 void AdBlockManager::removeDisabledRule(const QString &filter)
 {
-  m_disabledRules.removeOne(filter);
+  m_disabledRules.remove(filter);
 }
 
 AdBlockSubscription* AdBlockManager::addSubscription(const QString &title, const QString &url)
@@ -183,6 +183,7 @@ bool AdBlockManager::removeSubscription(AdBlockSubscription* subscription)
   }
 
   QFile(subscription->filePath()).remove();
+  QFile(subscription->cacheFilePath()).remove();
   m_subscriptions.removeOne(subscription);
 
   delete subscription;
@@ -217,7 +218,8 @@ void AdBlockManager::load()
   settings.beginGroup("AdBlock");
   m_enabled = settings.value("enabled", m_enabled).toBool();
   m_useLimitedEasyList = settings.value("useLimitedEasyList", m_useLimitedEasyList).toBool();
-  m_disabledRules = settings.value("disabledRules", QStringList()).toStringList();
+  const QStringList disabledRules = settings.value("disabledRules", QStringList()).toStringList();
+  m_disabledRules = QSet<QString>(disabledRules.begin(), disabledRules.end());
   QDateTime lastUpdate = settings.value("lastUpdate", QDateTime()).toDateTime();
   settings.endGroup();
 
@@ -319,7 +321,7 @@ void AdBlockManager::save()
   settings.beginGroup("AdBlock");
   settings.setValue("enabled", m_enabled);
   settings.setValue("useLimitedEasyList", m_useLimitedEasyList);
-  settings.setValue("disabledRules", m_disabledRules);
+  settings.setValue("disabledRules", QStringList(m_disabledRules.values()));
   settings.endGroup();
 }
 
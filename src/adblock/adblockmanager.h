@@ -19,6 +19,7 @@
 #define ADBLOCKMANAGER_H
 
 #include <QObject>
+#include <QSet>
 #include <QStringList>
 #include <QPointer>
 
@@ -59,7 +60,7 @@ public:
 
   QNetworkReply* block(const QNetworkRequest &request);
 
-  QStringList disabledRules() const;
+  QSet<QString> disabledRules() const;
   void addDisabledRule(const QString &filter);
   void removeDisabledRule(const QString &filter);
 
@@ -89,7 +90,7 @@ private:
   QList<AdBlockSubscription*> m_subscriptions;
   static AdBlockManager* s_adBlockManager;
   AdBlockMatcher* m_matcher;
-  QStringList m_disabledRules;
+  QSet<QString> m_disabledRules;
 
   QPointer<AdBlockDialog> m_adBlockDialog;
 };
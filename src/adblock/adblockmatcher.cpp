@@ -21,10 +21,15 @@
 #include "adblocksubscription.h"
 #include "common.h"
 
+#include <algorithm>
+
+#define DOMAIN_CSS_CACHE_SIZE 32
+
 AdBlockMatcher::AdBlockMatcher(AdBlockManager* manager)
   : QObject(manager)
   , m_manager(manager)
 {
+  m_domainCssCache.setMaxCost(DOMAIN_CSS_CACHE_SIZE);
   connect(manager, SIGNAL(enabledChanged(bool)), this, SLOT(enabledChanged(bool)));
 }
 
@@ -36,28 +41,11 @@ AdBlockMatcher::~AdBlockMatcher()
 const AdBlockRule* AdBlockMatcher::match(const QNetworkRequest &request, const QString &urlDomain, const QString &urlString) const
 {
   // Exception rules
-  if (m_networkExceptionTree.find(request, urlDomain, urlString))
+  if (m_networkExceptionIndex.find(request, urlDomain, urlString))
     return 0;
 
-  int count = m_networkExceptionRules.count();
-  for (int i = 0; i < count; ++i) {
-    const AdBlockRule* rule = m_networkExceptionRules.at(i);
-    if (rule->networkMatch(request, urlDomain, urlString))
-      return 0;
-  }
-
   // Block rules
-  if (const AdBlockRule* rule = m_networkBlockTree.find(request, urlDomain, urlString))
-    return rule;
-
-  count = m_networkBlockRules.count();
-  for (int i = 0; i < count; ++i) {
-    const AdBlockRule* rule = m_networkBlockRules.at(i);
-    if (rule->networkMatch(request, urlDomain, urlString))
-      return rule;
-  }
-
-  return 0;
+  return m_networkBlockIndex.find(request, urlDomain, urlString);
 }
 
 bool AdBlockMatcher::adBlockDisabledForUrl(const QUrl &url) const
@@ -92,12 +80,31 @@ QString AdBlockMatcher::elementHidingRules() const
 
 QString AdBlockMatcher::elementHidingRulesForDomain(const QString &domain) const
 {
+  if (const QString* cachedRules = m_domainCssCache.object(domain))
+    return *cachedRules;
+
+  // Rule with allowed domains can match only domain itself or its parent domains
+  QVector<int> indexes = m_otherDomainCssRules;
+  QString suffix = domain;
+  forever {
+    QHash<QString, QVector<int> >::const_iterator it = m_domainCssRulesIndex.constFind(suffix);
+    if (it != m_domainCssRulesIndex.constEnd())
+      indexes += it.value();
+
+    int pos = suffix.indexOf(QLatin1Char('.'));
+    if (pos == -1)
+      break;
+    suffix = suffix.mid(pos + 1);
+  }
+
+  std::sort(indexes.begin(), indexes.end());
+  indexes.erase(std::unique(indexes.begin(), indexes.end()), indexes.end());
+
   QString rules;
   int addedRulesCount = 0;
-  int count = m_domainRestrictedCssRules.count();
 
-  for (int i = 0; i < count; ++i) {
-    const AdBlockRule* rule = m_domainRestrictedCssRules.at(i);
+  foreach (int index, indexes) {
+    const AdBlockRule* rule = m_domainRestrictedCssRules.at(index);
     if (!rule->matchDomain(domain))
       continue;
 
@@ -117,6 +124,7 @@ QString AdBlockMatcher::elementHidingRulesForDomain(const QString &domain) const
     rules.append(QLatin1String("{display:none !important;}\n"));
   }
 
+  m_domainCssCache.insert(domain, new QString(rules));
   return rules;
 }
 
@@ -151,12 +159,10 @@ void AdBlockMatcher::update()
         m_elemhideRules.append(rule);
       }
       else if (rule->isException()) {
-        if (!m_networkExceptionTree.add(rule))
-          m_networkExceptionRules.append(rule);
+        m_networkExceptionIndex.add(rule);
       }
       else {
-        if (!m_networkBlockTree.add(rule))
-          m_networkBlockRules.append(rule);
+        m_networkBlockIndex.add(rule);
       }
     }
   }
@@ -204,15 +210,30 @@ void AdBlockMatcher::update()
     m_elementHidingRules = m_elementHidingRules.left(m_elementHidingRules.size() - 1);
     m_elementHidingRules.append(QLatin1String("{display:none !important;} "));
   }
+
+  int count = m_domainRestrictedCssRules.count();
+  for (int i = 0; i < count; ++i) {
+    const AdBlockRule* rule = m_domainRestrictedCssRules.at(i);
+
+    if (rule->m_allowedDomains.isEmpty()) {
+      m_otherDomainCssRules.append(i);
+      continue;
+    }
+
+    foreach (const QString &allowedDomain, rule->m_allowedDomains) {
+      m_domainCssRulesIndex[allowedDomain].append(i);
+    }
+  }
 }
 
 void AdBlockMatcher::clear()
 {
-  m_networkExceptionTree.clear();
-  m_networkExceptionRules.clear();
-  m_networkBlockTree.clear();
-  m_networkBlockRules.clear();
+  m_networkExceptionIndex.clear();
+  m_networkBlockIndex.clear();
   m_domainRestrictedCssRules.clear();
+  m_domainCssRulesIndex.clear();
+  m_otherDomainCssRules.clear();
+  m_domainCssCache.clear();
   m_elementHidingRules.clear();
   m_documentRules.clear();
   m_elemhideRules.clear();
@@ -19,10 +19,12 @@
 #define ADBLOCKMATCHER_H
 
 #include <QUrl>
+#include <QCache>
+#include <QHash>
 #include <QObject>
 #include <QVector>
 
-#include "adblocksearchtree.h"
+#include "adblockruleindex.h"
 
 class AdBlockManager;
 class AdBlockRule;
@@ -54,15 +56,19 @@ private:
   AdBlockManager* m_manager;
 
   QVector<AdBlockRule*> m_createdRules;
-  QVector<const AdBlockRule*> m_networkExceptionRules;
-  QVector<const AdBlockRule*> m_networkBlockRules;
   QVector<const AdBlockRule*> m_domainRestrictedCssRules;
+  // Allowed domain -> positions of its rules in m_domainRestrictedCssRules
+  QHash<QString, QVector<int> > m_domainCssRulesIndex;
+  // Positions of rules without allowed domains (only ~domain)
+  QVector<int> m_otherDomainCssRules;
+  // Domain -> its rules stylesheet, least recently used are dropped
+  mutable QCache<QString, QString> m_domainCssCache;
   QVector<const AdBlockRule*> m_documentRules;
   QVector<const AdBlockRule*> m_elemhideRules;
 
   QString m_elementHidingRules;
-  AdBlockSearchTree m_networkBlockTree;
-  AdBlockSearchTree m_networkExceptionTree;
+  AdBlockRuleIndex m_networkBlockIndex;
+  AdBlockRuleIndex m_networkExceptionIndex;
 };
 
 #endif // ADBLOCKMATCHER_H
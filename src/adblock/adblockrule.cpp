@@ -32,6 +32,7 @@
 #include "webpage.h"
 #include "common.h"
 
+#include <QDataStream>
 #include <QDebug>
 #include <QUrl>
 #include <QString>
@@ -124,6 +125,62 @@ AdBlockRule* AdBlockRule::copy() const
   return rule;
 }
 
+// Write parsed rule, except enabled state, for AdBlockSubscription cache
+void AdBlockRule::saveCache(QDataStream &stream) const
+{
+  stream << qint8(m_type) << qint32(m_options) << qint32(m_exceptions)
+         << m_filter << m_matchString << qint8(m_caseSensitivity)
+         << m_isException << m_isInternalDisabled
+         << m_allowedDomains << m_blockedDomains << bool(m_regExp);
+
+  if (m_regExp) {
+    QStringList patterns;
+    foreach (const QStringMatcher &matcher, m_regExp->matchers) {
+      patterns.append(matcher.pattern());
+    }
+    stream << m_regExp->regExp.pattern() << patterns;
+  }
+}
+
+// Read rule written by saveCache() instead of parsing filter
+bool AdBlockRule::loadCache(QDataStream &stream)
+{
+  qint8 type;
+  qint32 options;
+  qint32 exceptions;
+  qint8 caseSensitivity;
+  bool hasRegExp;
+
+  stream >> type >> options >> exceptions
+         >> m_filter >> m_matchString >> caseSensitivity
+         >> m_isException >> m_isInternalDisabled
+         >> m_allowedDomains >> m_blockedDomains >> hasRegExp;
+
+  if (stream.status() != QDataStream::Ok || type < CssRule || type > Invalid) {
+    return false;
+  }
+
+  m_type = static_cast<RuleType>(type);
+  m_options = RuleOptions(QFlag(options));
+  m_exceptions = RuleOptions(QFlag(exceptions));
+  m_caseSensitivity = caseSensitivity ? Qt::CaseSensitive : Qt::CaseInsensitive;
+
+  delete m_regExp;
+  m_regExp = 0;
+
+  if (hasRegExp) {
+    QString pattern;
+    QStringList patterns;
+    stream >> pattern >> patterns;
+
+    m_regExp = new RegExp;
+    m_regExp->regExp = QzRegExp(pattern, m_caseSensitivity);
+    m_regExp->matchers = createStringMatchers(patterns);
+  }
+
+  return stream.status() == QDataStream::Ok;
+}
+
 AdBlockSubscription* AdBlockRule::subscription() const
 {
   return m_subscription;
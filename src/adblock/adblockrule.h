@@ -50,6 +50,7 @@
 #include <QStringList>
 #include <qzregexp.h>
 
+class QDataStream;
 class QNetworkRequest;
 class QUrl;
 
@@ -63,6 +64,9 @@ public:
 
   AdBlockRule* copy() const;
 
+  void saveCache(QDataStream &stream) const;
+  bool loadCache(QDataStream &stream);
+
   AdBlockSubscription* subscription() const;
   void setSubscription(AdBlockSubscription* subscription);
 
@@ -167,7 +171,7 @@ private:
   RegExp* m_regExp;
 
   friend class AdBlockMatcher;
-  friend class AdBlockSearchTree;
+  friend class AdBlockRuleIndex;
   friend class AdBlockSubscription;
 };
 
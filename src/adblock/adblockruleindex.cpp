@@ -0,0 +1,157 @@
+#include "adblockruleindex.h"
+#include "adblockrule.h"
+
+#include <QStringMatcher>
+
+#define KEYWORD_LENGTH_MIN 3
+
+namespace {
+
+inline bool isKeywordChar(ushort c)
+{
+  return ((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')) ||
+      ((c >= '0') && (c <= '9')) || (c == '%');
+}
+
+/** @brief Lowercased keywords which string always contains as a whole
+ * @param startBounded - run at start of string is not continued in URL
+ * @param endBounded - run at end of string is not continued in URL
+ *----------------------------------------------------------------------------*/
+QStringList keywords(const QString &string, bool startBounded, bool endBounded)
+{
+  QStringList list;
+  const QChar* data = string.constData();
+  int size = string.size();
+
+  int i = 0;
+  while (i < size) {
+    if (!isKeywordChar(data[i].unicode())) {
+      ++i;
+      continue;
+    }
+
+    int start = i;
+    while ((i < size) && isKeywordChar(data[i].unicode()))
+      ++i;
+
+    if ((i - start < KEYWORD_LENGTH_MIN) ||
+        ((start == 0) && !startBounded) || ((i == size) && !endBounded))
+      continue;
+    list.append(string.mid(start, i - start).toLower());
+  }
+
+  return list;
+}
+
+} // namespace
+
+AdBlockRuleIndex::AdBlockRuleIndex()
+{
+}
+
+void AdBlockRuleIndex::clear()
+{
+  m_keywordRules.clear();
+  m_otherRules.clear();
+}
+
+void AdBlockRuleIndex::add(const AdBlockRule* rule)
+{
+  QString keyword = ruleKeyword(rule);
+  if (keyword.isEmpty())
+    m_otherRules.append(rule);
+  else
+    m_keywordRules[keyword].append(rule);
+}
+
+const AdBlockRule* AdBlockRuleIndex::find(const QNetworkRequest &request, const QString &domain, const QString &urlString) const
+{
+  if (!m_keywordRules.isEmpty()) {
+    QSet<QString> checkedKeywords;
+    if (const AdBlockRule* rule = findByKeywords(request, domain, urlString, urlString, checkedKeywords))
+      return rule;
+
+    // Domain rules are matched to domain, which may be written other way in URL
+    if (const AdBlockRule* rule = findByKeywords(request, domain, urlString, domain, checkedKeywords))
+      return rule;
+  }
+
+  int count = m_otherRules.count();
+  for (int i = 0; i < count; ++i) {
+    const AdBlockRule* rule = m_otherRules.at(i);
+    if (rule->networkMatch(request, domain, urlString))
+      return rule;
+  }
+
+  return 0;
+}
+
+/** @brief Test rules stored under keywords of \a string
+ *----------------------------------------------------------------------------*/
+const AdBlockRule* AdBlockRuleIndex::findByKeywords(const QNetworkRequest &request, const QString &domain,
+                                                    const QString &urlString, const QString &string,
+                                                    QSet<QString> &checkedKeywords) const
+{
+  foreach (const QString &keyword, keywords(string, true, true)) {
+    if (checkedKeywords.contains(keyword))
+      continue;
+    checkedKeywords.insert(keyword);
+
+    QHash<QString, QVector<const AdBlockRule*> >::const_iterator it = m_keywordRules.constFind(keyword);
+    if (it == m_keywordRules.constEnd())
+      continue;
+
+    const QVector<const AdBlockRule*> &rules = it.value();
+    int count = rules.count();
+    for (int i = 0; i < count; ++i) {
+      const AdBlockRule* rule = rules.at(i);
+      if (rule->networkMatch(request, domain, urlString))
+        return rule;
+    }
+  }
+
+  return 0;
+}
+
+/** @brief Keyword of rule, the one with fewest rules stored under it
+ * @return empty string if rule can match URL without any keyword
+ *----------------------------------------------------------------------------*/
+QString AdBlockRuleIndex::ruleKeyword(const AdBlockRule* rule) const
+{
+  QStringList candidates;
+
+  switch (rule->m_type) {
+  case AdBlockRule::StringContainsMatchRule:
+    candidates = keywords(rule->m_matchString, false, false);
+    break;
+  case AdBlockRule::StringEndsMatchRule:
+    candidates = keywords(rule->m_matchString, false, true);
+    break;
+  case AdBlockRule::DomainMatchRule:
+    candidates = keywords(rule->m_matchString, true, true);
+    break;
+  case AdBlockRule::RegExpMatchRule:
+    // URL has to contain all string parts of filter before regexp is tried
+    if (rule->m_regExp) {
+      foreach (const QStringMatcher &matcher, rule->m_regExp->matchers) {
+        candidates.append(keywords(matcher.pattern(), false, false));
+      }
+    }
+    break;
+  default:
+    break;
+  }
+
+  QString keyword;
+  int keywordCount = 0;
+  foreach (const QString &candidate, candidates) {
+    int count = m_keywordRules.value(candidate).count();
+    if (keyword.isEmpty() || (count < keywordCount) ||
+        ((count == keywordCount) && (candidate.size() > keyword.size()))) {
+      keyword = candidate;
+      keywordCount = count;
+    }
+  }
+
+  return keyword;
+}
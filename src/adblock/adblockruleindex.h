@@ -0,0 +1,40 @@
+#ifndef ADBLOCKRULEINDEX_H
+#define ADBLOCKRULEINDEX_H
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+class QNetworkRequest;
+
+class AdBlockRule;
+
+/** @brief Network rules indexed by shortcut keyword
+ *
+ * Every rule is stored under one keyword of its filter: a run of [a-z0-9%]
+ * that matching URL has to contain as a whole. URL is split into keywords
+ * the same way, so only rules stored under them and the few rules without
+ * keyword are tested for it.
+ *----------------------------------------------------------------------------*/
+class AdBlockRuleIndex
+{
+public:
+  explicit AdBlockRuleIndex();
+
+  void clear();
+
+  void add(const AdBlockRule* rule);
+  const AdBlockRule* find(const QNetworkRequest &request, const QString &domain, const QString &urlString) const;
+
+private:
+  QString ruleKeyword(const AdBlockRule* rule) const;
+  const AdBlockRule* findByKeywords(const QNetworkRequest &request, const QString &domain,
+                                    const QString &urlString, const QString &string,
+                                    QSet<QString> &checkedKeywords) const;
+
+  QHash<QString, QVector<const AdBlockRule*> > m_keywordRules;
+  QVector<const AdBlockRule*> m_otherRules;
+};
+
+#endif // ADBLOCKRULEINDEX_H
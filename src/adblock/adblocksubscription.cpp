@@ -27,18 +27,25 @@
  */
 #include "adblocksubscription.h"
 #include "adblockmanager.h"
-#include "adblocksearchtree.h"
 #include "followredirectreply.h"
 #include "mainapplication.h"
 #include "networkmanager.h"
 #include "common.h"
 
+#include <QCryptographicHash>
+#include <QDataStream>
 #include <QFile>
+#include <QSaveFile>
 #include <QTimer>
 #include <QNetworkReply>
 #include <QDebug>
 #include <QWebPage>
 
+// Parsed rules are cached in binary file next to subscription,
+// bump version when cached fields of AdBlockRule change
+#define ADBLOCK_CACHE_MAGIC 0x41424331
+#define ADBLOCK_CACHE_VERSION 1
+
 AdBlockSubscription::AdBlockSubscription(const QString &title, QObject* parent)
   : QObject(parent)
   , m_reply(0)
@@ -77,7 +84,12 @@ void AdBlockSubscription::setUrl(const QUrl &url)
   m_url = url;
 }
 
-void AdBlockSubscription::loadSubscription(const QStringList &disabledRules)
+QString AdBlockSubscription::cacheFilePath() const
+{
+  return m_filePath + QLatin1String(".cache");
+}
+
+void AdBlockSubscription::loadSubscription(const QSet<QString> &disabledRules)
 {
   QFile file(m_filePath);
 
@@ -92,7 +104,10 @@ void AdBlockSubscription::loadSubscription(const QStringList &disabledRules)
     return;
   }
 
-  QTextStream textStream(&file);
+  const QByteArray data = file.readAll();
+  file.close();
+
+  QTextStream textStream(data);
   textStream.setCodec("UTF-8");
   // Header is on 3rd line
   textStream.readLine(1024);
@@ -107,14 +122,20 @@ void AdBlockSubscription::loadSubscription(const QStringList &disabledRules)
 
   m_rules.clear();
 
-  while (!textStream.atEnd()) {
-    AdBlockRule* rule = new AdBlockRule(textStream.readLine(), this);
+  // Rules are parsed only when file has changed since cache was written
+  const QByteArray hash = QCryptographicHash::hash(data, QCryptographicHash::Sha1);
+  if (!loadCache(hash)) {
+    while (!textStream.atEnd()) {
+      m_rules.append(new AdBlockRule(textStream.readLine(), this));
+    }
+
+    saveCache(hash);
+  }
 
+  foreach (AdBlockRule* rule, m_rules) {
     if (disabledRules.contains(rule->filter())) {
       rule->setEnabled(false);
     }
-
-    m_rules.append(rule);
   }
 
   // Initial update
@@ -123,6 +144,79 @@ void AdBlockSubscription::loadSubscription(const QStringList &disabledRules)
   }
 }
 
+// Read rules from cache mapped into memory
+// Returns false if cache is missing, broken or made for other file contents
+bool AdBlockSubscription::loadCache(const QByteArray &hash)
+{
+  QFile file(cacheFilePath());
+
+  if (!file.open(QFile::ReadOnly)) {
+    return false;
+  }
+
+  uchar* map = file.map(0, file.size());
+  if (!map) {
+    return false;
+  }
+
+  const QByteArray data = QByteArray::fromRawData(reinterpret_cast<const char*>(map), file.size());
+  QDataStream stream(data);
+  stream.setVersion(QDataStream::Qt_5_0);
+
+  quint32 magic;
+  quint32 version;
+  QByteArray cacheHash;
+  qint32 count;
+  stream >> magic >> version;
+
+  if (magic != ADBLOCK_CACHE_MAGIC || version != ADBLOCK_CACHE_VERSION) {
+    return false;
+  }
+
+  stream >> cacheHash >> count;
+
+  if (stream.status() != QDataStream::Ok || cacheHash != hash || count < 0) {
+    return false;
+  }
+
+  QVector<AdBlockRule*> rules;
+
+  for (int i = 0; i < count; ++i) {
+    AdBlockRule* rule = new AdBlockRule(QString(), this);
+    rules.append(rule);
+
+    if (!rule->loadCache(stream)) {
+      qWarning() << "AdBlockSubscription::" << __FUNCTION__ << "broken adblock cache" << cacheFilePath();
+      qDeleteAll(rules);
+      return false;
+    }
+  }
+
+  m_rules = rules;
+  return true;
+}
+
+void AdBlockSubscription::saveCache(const QByteArray &hash) const
+{
+  QSaveFile file(cacheFilePath());
+
+  if (!file.open(QFile::WriteOnly)) {
+    qWarning() << "AdBlockSubscription::" << __FUNCTION__ << "Unable to open adblock cache for writing:" << cacheFilePath();
+    return;
+  }
+
+  QDataStream stream(&file);
+  stream.setVersion(QDataStream::Qt_5_0);
+  stream << quint32(ADBLOCK_CACHE_MAGIC) << quint32(ADBLOCK_CACHE_VERSION)
+         << hash << qint32(m_rules.count());
+
+  foreach (const AdBlockRule* rule, m_rules) {
+    rule->saveCache(stream);
+  }
+
+  file.commit();
+}
+
 void AdBlockSubscription::saveSubscription()
 {
 }
@@ -296,7 +390,7 @@ void AdBlockCustomList::retranslateStrings()
   setTitle(tr("Custom Rules"));
 }
 
-void AdBlockCustomList::loadSubscription(const QStringList &disabledRules)
+void AdBlockCustomList::loadSubscription(const QSet<QString> &disabledRules)
 {
   // DuckDuckGo ad whitelist rules
   // They cannot be removed, but can be disabled.
@@ -46,11 +46,11 @@
 #ifndef ADBLOCKSUBSCRIPTION_H
 #define ADBLOCKSUBSCRIPTION_H
 
+#include <QSet>
 #include <QVector>
 #include <QUrl>
 
 #include "adblockrule.h"
-#include "adblocksearchtree.h"
 
 class QNetworkRequest;
 class QNetworkReply;
@@ -70,11 +70,12 @@ public:
 
   QString filePath() const;
   void setFilePath(const QString &path);
+  QString cacheFilePath() const;
 
   QUrl url() const;
   void setUrl(const QUrl &url);
 
-  virtual void loadSubscription(const QStringList &disabledRules);
+  virtual void loadSubscription(const QSet<QString> &disabledRules);
   virtual void saveSubscription();
 
   const AdBlockRule* rule(int offset) const;
@@ -104,6 +105,9 @@ protected slots:
 protected:
   virtual bool saveDownloadedData(const QByteArray &data);
 
+  bool loadCache(const QByteArray &hash);
+  void saveCache(const QByteArray &hash) const;
+
   FollowRedirectReply* m_reply;
 
   QVector<AdBlockRule*> m_rules;
@@ -124,7 +128,7 @@ public:
 
   void retranslateStrings();
 
-  void loadSubscription(const QStringList &disabledRules);
+  void loadSubscription(const QSet<QString> &disabledRules);
   void saveSubscription();
 
   bool canEditRules() const;
@@ -5,6 +5,7 @@
 #include "database.h"
 #include "globals.h"
 #include "networkmanager.h"
+#include "networkdiskcache.h"
 #include "adblockmanager.h"
 #include "settings.h"
 #include "splashscreen.h"
@@ -421,6 +422,14 @@ NetworkManager *MainApplication::networkManager()
   return networkManager_;
 }
 
+/** @brief Disk cache shared by all network managers, NULL if not created
+ * @details Other threads read it under NetworkDiskCache::mutex().
+ *----------------------------------------------------------------------------*/
+QNetworkDiskCache *MainApplication::diskCache() const
+{
+  return diskCache_;
+}
+
 CookieJar *MainApplication::cookieJar()
 {
   if (!cookieJar_) {
@@ -434,6 +443,9 @@ void MainApplication::setDiskCache()
   Settings settings;
   settings.beginGroup("Settings");
 
+  // Disk cache may be in use by network managers of other threads
+  QMutexLocker locker(NetworkDiskCache::mutex());
+
   bool useDiskCache = settings.value("useDiskCache", true).toBool();
   if (useDiskCache) {
     if (!diskCache_) {
@@ -453,8 +465,6 @@ void MainApplication::setDiskCache()
     diskCache_->setCacheDirectory(diskCacheDirPath);
     int maxDiskCache = settings.value("maxDiskCache", 50).toInt();
     diskCache_->setMaximumCacheSize(maxDiskCache*1024*1024);
-
-    networkManager()->setCache(diskCache_);
   } else {
     if (diskCache_) {
       diskCache_->setMaximumCacheSize(0);
@@ -51,6 +51,7 @@ public:
   MainWindow *mainWindow();
   NetworkManager *networkManager();
   CookieJar *cookieJar();
+  QNetworkDiskCache *diskCache() const;
   void setDiskCache();
   UpdateFeeds *updateFeeds();
   void runUserFilter(int feedId, int filterId);
@@ -11,6 +11,7 @@
 #include "cleanupwizard.h"
 #include "customizetoolbardialog.h"
 #include "feedpropertiesdialog.h"
+#include "feedscheduler.h"
 #include "filterrulesdialog.h"
 #include "newsfiltersdialog.h"
 #include "webpage.h"
@@ -37,7 +38,6 @@ MainWindow::MainWindow(QWidget *parent)
   , feedsFilterAction_(NULL)
   , newsFilterAction_(NULL)
   , newsView_(NULL)
-  , updateTimeCount_(0)
   , mediaPlayer_(NULL)
   , notificationWidget(NULL)
   , feedIdOld_(-2)
@@ -2464,12 +2464,11 @@ void MainWindow::addFolder()
   q.bindValue(":parentId", parentId);
   q.bindValue(":rowToParent", rowToParent);
   q.exec();
+  int folderId = q.lastInsertId().toInt();
 
   delete addFolderDialog;
 
-  QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
-  feedsModelReload();
-  QApplication::restoreOverrideCursor();
+  feedsModel_->insertItem(folderId);
 }
 
 /** @brief Delete feed list item with confirmation
@@ -2570,7 +2569,9 @@ void MainWindow::deleteItemFeedsTree()
   }
 
   recountFeedCategories(parentIdList);
-  feedsModelReload();
+  foreach (int feedId, idList) {
+    feedsModel_->removeItem(feedId);
+  }
   currentIndex = feedsProxyModel_->mapFromSource(feedIdCur);
   feedsView_->setCurrentIndex(currentIndex);
   slotFeedClicked(currentIndex);
@@ -2731,47 +2732,38 @@ void MainWindow::slotFeedCountsUpdate(FeedCountStruct counts)
   }
 }
 
-/** @brief Recalculate counters for specified categories
- * @details Processing DB data. Model "reselect()" needed.
+/** @brief Update counters of specified categories in model
+ * @details Counters are kept in DB by triggers, here they are only read
+ *   for categories and their parents.
  * @param categoriesList - categories identifiers list for processing
  *---------------------------------------------------------------------------*/
 void MainWindow::recountFeedCategories(const QList<int> &categoriesList)
 {
   QSqlQuery q;
-  QString qStr;
+  QList<int> processedList;
 
   foreach (int categoryIdStart, categoriesList) {
-    if (categoryIdStart < 1) continue;
-
     int categoryId = categoryIdStart;
     // Process all parents
-    while (0 < categoryId) {
-      int unreadCount = -1;
-      int undeleteCount = -1;
-      int newCount = -1;
-
-      // Calculate sum of all feeds with same parent
-      qStr = QString("SELECT sum(unread), sum(undeleteCount), sum(newCount) "
-                     "FROM feeds WHERE parentId=='%1'").arg(categoryId);
-      q.exec(qStr);
-      if (q.next()) {
-        unreadCount   = q.value(0).toInt();
-        undeleteCount = q.value(1).toInt();
-        newCount = q.value(2).toInt();
-      }
+    while ((0 < categoryId) && !processedList.contains(categoryId)) {
+      processedList.append(categoryId);
 
-      if (unreadCount != -1) {
-        qStr = QString("UPDATE feeds SET unread='%1', undeleteCount='%2', newCount='%3' WHERE id=='%4'").
-            arg(unreadCount).arg(undeleteCount).arg(newCount).arg(categoryId);
-        q.exec(qStr);
-      }
+      q.prepare("SELECT unread, newCount, undeleteCount, parentId "
+                "FROM feeds WHERE id==?");
+      q.addBindValue(categoryId);
+      q.exec();
+      if (!q.next())
+        break;
+
+      FeedCountStruct counts;
+      counts.feedId = categoryId;
+      counts.unreadCount = q.value(0).toInt();
+      counts.newCount = q.value(1).toInt();
+      counts.undeleteCount = q.value(2).toInt();
+      slotFeedCountsUpdate(counts);
 
       // go to next parent's parent
-      qStr = QString("SELECT parentId FROM feeds WHERE id=='%1'").
-          arg(categoryId);
-      categoryId = 0;
-      q.exec(qStr);
-      if (q.next()) categoryId = q.value(0).toInt();
+      categoryId = q.value(3).toInt();
     }
   }
 }
@@ -2901,6 +2893,8 @@ void MainWindow::slotRecountCategoryCounts(QList<int> deletedList, QList<int> st
  *---------------------------------------------------------------------------*/
 void MainWindow::slotUpdateFeed(int feedId, bool changed, int newCount, bool finish)
 {
+  feedScheduler_->updateFeed(feedId);
+
   if (finish) {
     emit signalShowNotification();
     progressBar_->hide();
@@ -3092,16 +3086,10 @@ void MainWindow::slotFeedSelected(QModelIndex index, bool createTab)
   bool isFeed = (index.isValid() && feedsModel_->isFolder(index)) ? false : true;
 
   QPixmap iconTab;
-  QByteArray byteArray = feedsModel_->dataField(index, "image").toByteArray();
-  if (!isFeed) {
-    iconTab.load(":/images/folder");
-  } else {
-    if (byteArray.isNull() || defaultIconFeeds_) {
-      iconTab.load(":/images/feed");
-    } else if (isFeed) {
-      iconTab.loadFromData(QByteArray::fromBase64(byteArray));
-    }
-  }
+  if (!index.isValid() || (isFeed && defaultIconFeeds_))
+    iconTab.load(":/images/feed");
+  else
+    iconTab = feedsModel_->iconById(feedsModel_->idByIndex(index));
   currentNewsTab->newsIconTitle_->setPixmap(iconTab);
 
   // Set title for tab has opened
@@ -3202,9 +3190,14 @@ void MainWindow::showOptionDlg(int index)
   int timeoutRequest = settings.value("Settings/timeoutRequest", 15).toInt();
   int numberRequests = settings.value("Settings/numberRequest", 10).toInt();
   int numberRepeats = settings.value("Settings/numberRepeats", 2).toInt();
+  int numberRequestsPerHost = settings.value("Settings/numberRequestsPerHost", 2).toInt();
+  int numberParseThreads = settings.value("Settings/numberParseThreads",
+                                          qBound(1, QThread::idealThreadCount(), 4)).toInt();
   optionsDialog_->timeoutRequest_->setValue(timeoutRequest);
   optionsDialog_->numberRequests_->setValue(numberRequests);
+  optionsDialog_->numberRequestsPerHost_->setValue(numberRequestsPerHost);
   optionsDialog_->numberRepeats_->setValue(numberRepeats);
+  optionsDialog_->numberParseThreads_->setValue(numberParseThreads);
 
   optionsDialog_->embeddedBrowserOn_->setChecked(externalBrowserOn_);
   optionsDialog_->externalBrowserOn_->setChecked(!externalBrowserOn_);
@@ -3616,10 +3609,14 @@ void MainWindow::showOptionDlg(int index)
 
   timeoutRequest = optionsDialog_->timeoutRequest_->value();
   numberRequests = optionsDialog_->numberRequests_->value();
+  numberRequestsPerHost = optionsDialog_->numberRequestsPerHost_->value();
   numberRepeats = optionsDialog_->numberRepeats_->value();
+  numberParseThreads = optionsDialog_->numberParseThreads_->value();
   settings.setValue("Settings/timeoutRequest", timeoutRequest);
   settings.setValue("Settings/numberRequest", numberRequests);
+  settings.setValue("Settings/numberRequestsPerHost", numberRequestsPerHost);
   settings.setValue("Settings/numberRepeats", numberRepeats);
+  settings.setValue("Settings/numberParseThreads", numberParseThreads);
 
   QString userAgent = optionsDialog_->editUserAgent_->text();
   if (userAgent.size() == 0)
@@ -3683,12 +3680,9 @@ void MainWindow::showOptionDlg(int index)
   updateFeedsInterval_ = optionsDialog_->updateFeedsInterval_->value();
   updateFeedsIntervalType_ = optionsDialog_->updateIntervalType_->currentIndex()-1;
 
-  int updateInterval = updateFeedsInterval_;
-  if (updateFeedsIntervalType_ == 0)
-    updateInterval = updateInterval*60;
-  else if (updateFeedsIntervalType_ == 1)
-    updateInterval = updateInterval*60*60;
-  updateIntervalSec_ = updateInterval;
+  feedScheduler_->setCommonInterval(
+        updateFeedsEnable_,
+        FeedScheduler::intervalSec(updateFeedsInterval_, updateFeedsIntervalType_));
 
   openingFeedAction_ = optionsDialog_->getOpeningFeed();
   openNewsWebViewOn_ = optionsDialog_->openNewsWebViewOn_->isChecked();
@@ -3922,56 +3916,12 @@ void MainWindow::initUpdateFeeds()
     }
   }
 
-  q.exec("SELECT id, updateInterval, updateIntervalType FROM feeds WHERE xmlUrl != '' AND updateIntervalEnable == 1");
-  while (q.next()) {
-    int updateInterval = q.value(1).toInt();
-    int updateIntervalType = q.value(2).toInt();
-    if (updateIntervalType == 0)
-      updateInterval = updateInterval*60;
-    else if (updateIntervalType == 1)
-      updateInterval = updateInterval*60*60;
-
-    updateFeedsIntervalSec_.insert(q.value(0).toInt(), updateInterval);
-    updateFeedsTimeCount_.insert(q.value(0).toInt(), 0);
-  }
-
-  int updateInterval = updateFeedsInterval_;
-  if (updateFeedsIntervalType_ == 0)
-    updateInterval = updateInterval*60;
-  else if (updateFeedsIntervalType_ == 1)
-    updateInterval = updateInterval*60*60;
-  updateIntervalSec_ = updateInterval;
-
-  updateFeedsTimer_ = new QTimer(this);
-  connect(updateFeedsTimer_, SIGNAL(timeout()),
-          this, SLOT(slotGetFeedsTimer()));
-  updateFeedsTimer_->start(1000);
-}
-// ----------------------------------------------------------------------------
-void MainWindow::slotGetFeedsTimer()
-{
-  if (updateFeedsEnable_) {
-    updateTimeCount_++;
-    if (updateTimeCount_ >= updateIntervalSec_) {
-      updateTimeCount_ = 0;
-
-      emit signalGetAllFeedsTimer();
-    }
-  } else {
-    updateTimeCount_ = 0;
-  }
-
-  QMapIterator<int, int> iterator(updateFeedsTimeCount_);
-  while (iterator.hasNext()) {
-    iterator.next();
-    int feedId = iterator.key();
-    updateFeedsTimeCount_[feedId]++;
-    if (updateFeedsTimeCount_[feedId] >= updateFeedsIntervalSec_[feedId]) {
-      updateFeedsTimeCount_[feedId] = 0;
-
-      emit signalGetFeedTimer(feedId);
-    }
-  }
+  feedScheduler_ = new FeedScheduler(this);
+  connect(feedScheduler_, SIGNAL(signalGetFeed(int)),
+          this, SIGNAL(signalGetFeedTimer(int)));
+  feedScheduler_->setCommonInterval(
+        updateFeedsEnable_,
+        FeedScheduler::intervalSec(updateFeedsInterval_, updateFeedsIntervalType_));
 }
 /** @brief Process update feed action
  *---------------------------------------------------------------------------*/
@@ -5068,17 +5018,9 @@ void MainWindow::showFeedPropertiesDlg()
   FEED_PROPERTIES properties;
   FEED_PROPERTIES properties_tmp;
 
-  QByteArray byteArray = feedsModel_->dataField(index, "image").toByteArray();
-  if (!byteArray.isNull()) {
-    QPixmap icon;
-    icon.loadFromData(QByteArray::fromBase64(byteArray));
-    feedPropertiesDialog->setWindowIcon(icon);
-  } else if (isFeed) {
-    feedPropertiesDialog->setWindowIcon(QPixmap(":/images/feed"));
-  } else {
-    feedPropertiesDialog->setWindowIcon(QPixmap(":/images/folder"));
-  }
-  properties.general.image = QByteArray::fromBase64(byteArray);
+  feedPropertiesDialog->setWindowIcon(feedsModel_->iconById(feedId));
+  if (isFeed)
+    properties.general.image = feedsModel_->iconDataById(feedId);
 
   QString str(feedPropertiesDialog->windowTitle() +
               " '" +
@@ -5430,13 +5372,6 @@ void MainWindow::showFeedPropertiesDlg()
     feedsModel_->setData(indexUpdateInterval, properties.general.updateInterval);
     feedsModel_->setData(indexIntervalType, properties.general.intervalType);
 
-    int updateInterval = properties.general.updateInterval;
-    int updateIntervalType = properties.general.intervalType;
-    if (updateIntervalType == 0)
-      updateInterval = updateInterval*60;
-    else if (updateIntervalType == 1)
-      updateInterval = updateInterval*60*60;
-
     if (!isFeed) {
       QQueue<int> parentIds;
       parentIds.enqueue(feedId);
@@ -5466,26 +5401,14 @@ void MainWindow::showFeedPropertiesDlg()
           feedsModel_->setData(indexIntervalType, properties.general.intervalType);
 
           if (!xmlUrl.isEmpty()) {
-            if (properties.general.updateEnable) {
-              updateFeedsIntervalSec_.insert(id, updateInterval);
-              updateFeedsTimeCount_.insert(id, 0);
-            } else {
-              updateFeedsIntervalSec_.remove(id);
-              updateFeedsTimeCount_.remove(id);
-            }
+            feedScheduler_->updateFeed(id);
           } else {
             parentIds.enqueue(id);
           }
         }
       }
     } else {
-      if (properties.general.updateEnable) {
-        updateFeedsIntervalSec_.insert(feedId, updateInterval);
-        updateFeedsTimeCount_.insert(feedId, 0);
-      } else {
-        updateFeedsIntervalSec_.remove(feedId);
-        updateFeedsTimeCount_.remove(feedId);
-      }
+      feedScheduler_->updateFeed(feedId);
     }
   } else {
     q.prepare("UPDATE feeds SET updateIntervalEnable = -1 WHERE id == ?");
@@ -5495,16 +5418,28 @@ void MainWindow::showFeedPropertiesDlg()
     QPersistentModelIndex indexUpdateEnable = feedsModel_->indexSibling(index, "updateIntervalEnable");
     feedsModel_->setData(indexUpdateEnable, "-1");
 
-    updateFeedsIntervalSec_.remove(feedId);
-    updateFeedsTimeCount_.remove(feedId);
+    feedScheduler_->updateFeed(feedId);
   }
 
   if (properties.general.image != properties_tmp.general.image) {
+    // Favicon of site is kept in icons table, feed keeps only icon chosen by user
+    q.prepare("SELECT 1 FROM feeds "
+              "JOIN favicons ON favicons.site == feeds.faviconSite "
+              "JOIN icons ON icons.hash == favicons.iconHash "
+              "WHERE feeds.id == ? AND icons.data == ?");
+    q.addBindValue(feedId);
+    q.addBindValue(properties.general.image);
+    q.exec();
+    bool siteIcon = q.first();
+
     q.prepare("UPDATE feeds SET image = ? WHERE id == ?");
-    q.addBindValue(properties.general.image.toBase64());
+    if (siteIcon)
+      q.addBindValue(QVariant(QVariant::String));
+    else
+      q.addBindValue(properties.general.image.toBase64());
     q.addBindValue(feedId);
     q.exec();
-    slotIconFeedUpdate(feedId, properties.general.image);
+    slotIconFeedUpdate(feedId);
   }
 
   if ((properties.display.layoutDirection  != properties_tmp.display.layoutDirection) &&
@@ -5676,6 +5611,7 @@ void MainWindow::slotIconFeedPreparing(QString feedUrl, QByteArray byteArray,
     buffer.open(QIODevice::WriteOnly);
     if (icon.save(&buffer, "ICO")) {
       emit signalIconFeedReady(feedUrl, faviconData);
+      return;
     }
   } else if (icon.loadFromData(byteArray, format.toUtf8().data())) {
     icon = icon.scaled(16, 16, Qt::IgnoreAspectRatio,
@@ -5685,34 +5621,43 @@ void MainWindow::slotIconFeedPreparing(QString feedUrl, QByteArray byteArray,
     buffer.open(QIODevice::WriteOnly);
     if (icon.save(&buffer, "ICO")) {
       emit signalIconFeedReady(feedUrl, faviconData);
+      return;
     }
   }
+  emit signalIconFeedFailed(feedUrl);
 }
 
-/** @brief Update feed icon in model and view
+/** @brief Update icon of feed chosen by user in model and view
  *---------------------------------------------------------------------------*/
-void MainWindow::slotIconFeedUpdate(int feedId, QByteArray faviconData)
+void MainWindow::slotIconFeedUpdate(int feedId)
 {
-  QModelIndex index = feedsModel_->indexById(feedId);
-  if (index.isValid()) {
-    QModelIndex indexImage = feedsModel_->indexSibling(index, "image");
-    feedsModel_->setData(indexImage, faviconData.toBase64());
-    feedsView_->viewport()->update();
-  }
+  feedsModel_->invalidateIcon(feedId);
+  updateFeedsIcons();
+}
+
+/** @brief Update favicon of all feeds of site in model and view
+ *---------------------------------------------------------------------------*/
+void MainWindow::slotIconSiteUpdate(QString site)
+{
+  feedsModel_->invalidateSiteIcon(site);
+  updateFeedsIcons();
+}
+
+/** @brief Repaint feed icons in feeds tree, tabs and news list
+ *---------------------------------------------------------------------------*/
+void MainWindow::updateFeedsIcons()
+{
+  feedsView_->viewport()->update();
 
   if (defaultIconFeeds_) return;
 
   for (int i = 0; i < stackedWidget_->count(); i++) {
     NewsTabWidget *widget = (NewsTabWidget*)stackedWidget_->widget(i);
-    if (widget->feedId_ == feedId) {
-      QPixmap iconTab;
-      if (!faviconData.isNull()) {
-        iconTab.loadFromData(faviconData);
-      } else {
-        iconTab.load(":/images/feed");
-      }
+    if (widget->type_ != NewsTabWidget::TabTypeFeed)
+      continue;
+    QPixmap iconTab = feedsModel_->iconById(widget->feedId_);
+    if (!iconTab.isNull())
       widget->newsIconTitle_->setPixmap(iconTab);
-    }
   }
   if (currentNewsTab->type_ < NewsTabWidget::TabTypeWeb)
     currentNewsTab->newsView_->viewport()->update();
@@ -6321,7 +6266,7 @@ QWebPage *MainWindow::createWebTab(QUrl url)
 void MainWindow::creatFeedTab(int feedId, int feedParId)
 {
   QSqlQuery q;
-  q.exec(QString("SELECT text, image, currentNews, xmlUrl FROM feeds WHERE id=='%1'").
+  q.exec(QString("SELECT text, currentNews, xmlUrl FROM feeds WHERE id=='%1'").
          arg(feedId));
 
   if (q.next()) {
@@ -6332,19 +6277,18 @@ void MainWindow::creatFeedTab(int feedId, int feedParId)
     widget->setBrowserPosition();
 
     bool isFeed = true;
-    if (q.value(3).toString().isEmpty())
+    if (q.value(2).toString().isEmpty())
       isFeed = false;
 
     // Set icon and title for tab
     QPixmap iconTab;
-    QByteArray byteArray = q.value(1).toByteArray();
     if (!isFeed) {
       iconTab.load(":/images/folder");
     } else {
-      if (byteArray.isNull() || defaultIconFeeds_) {
+      if (defaultIconFeeds_) {
         iconTab.load(":/images/feed");
-      } else if (isFeed) {
-        iconTab.loadFromData(QByteArray::fromBase64(byteArray));
+      } else {
+        iconTab = feedsModel_->iconById(feedId);
       }
     }
     widget->newsIconTitle_->setPixmap(iconTab);
@@ -6510,6 +6454,13 @@ void MainWindow::slotPageDownWebView()
   QKeyEvent keyEvent(QEvent::KeyPress, Qt::Key_PageDown, Qt::NoModifier);
   QApplication::sendEvent(currentNewsTab->webView_->page(), &keyEvent);
 }
+/** @brief Reload items of feeds tree which have been changed in DB
+ *---------------------------------------------------------------------------*/
+void MainWindow::feedsModelUpdate(QList<int> idList)
+{
+  feedsModel_->updateItems(idList);
+}
+
 /** @brief Reload full model
  * @details Performs: reload model, reset proxy model, restore focus
  *---------------------------------------------------------------------------*/
@@ -6969,10 +6920,12 @@ void MainWindow::slotMoveIndex(const QModelIndex &indexWhere, int how)
 {
   feedsView_->setCursor(Qt::WaitCursor);
 
+  QList<int> idMovedList;
   QModelIndexList indexList = feedsView_->selectionModel()->selectedRows(0);
   for (int i = 0; i < indexList.count(); i++) {
     QModelIndex indexWhat = feedsProxyModel_->mapToSource(indexList[i]);
     int feedIdWhat = feedsModel_->idByIndex(indexWhat);
+    idMovedList.append(feedIdWhat);
     int feedParIdWhat = feedsModel_->paridByIndex(indexWhat);
     int feedIdWhere = feedsModel_->idByIndex(indexWhere);
     int feedParIdWhere = feedsModel_->paridByIndex(indexWhere);
@@ -7064,7 +7017,7 @@ void MainWindow::slotMoveIndex(const QModelIndex &indexWhere, int how)
     }
   }
 
-  feedsView_->refresh();
+  feedsModel_->moveItems(idMovedList);
 
   feedsView_->setCurrentIndex(feedsProxyModel_->mapFromSource(feedIdOld_));
 
@@ -7694,6 +7647,7 @@ void MainWindow::sortedByTitleFeedsTree()
 {
   QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
 
+  QList<int> idList;
   QList<int> parentIdsPotential;
   parentIdsPotential << 0;
   while (!parentIdsPotential.empty()) {
@@ -7717,6 +7671,7 @@ void MainWindow::sortedByTitleFeedsTree()
       q2.addBindValue(rowToParent);
       q2.addBindValue(parentIdNew);
       q2.exec();
+      idList.append(parentIdNew);
 
       if (xmlUrl.isEmpty())
         parentIdsPotential << parentIdNew;
@@ -7724,7 +7679,7 @@ void MainWindow::sortedByTitleFeedsTree()
     }
   }
 
-  feedsModelReload();
+  feedsModel_->moveItems(idList);
   QApplication::restoreOverrideCursor();
 }
 
@@ -7882,6 +7837,25 @@ void MainWindow::setStatusFeed(int feedId, QString status)
   }
 }
 
+/** @brief Keep transfer of finished feeds update and show it in status bar
+ *---------------------------------------------------------------------------*/
+void MainWindow::slotFeedsTransferDone(TransferStats stats)
+{
+  feedsTransfer_ = stats;
+  showMessageStatusBar(tr("Feeds: received %1 (%2 decoded), %3 of %4 replies from cache").
+                       arg(locale().formattedDataSize(stats.receivedBytes)).
+                       arg(locale().formattedDataSize(stats.decodedBytes)).
+                       arg(stats.cachedRepliesCount).arg(stats.repliesCount),
+                       5000);
+}
+
+/** @brief Keep replies of finished favicons update
+ *---------------------------------------------------------------------------*/
+void MainWindow::slotFaviconsTransferDone(TransferStats stats)
+{
+  faviconsTransfer_ = stats;
+}
+
 void MainWindow::createBackup()
 {
   QString backupDir(QDir::currentPath());
@@ -20,6 +20,7 @@
 #include "tabbar.h"
 #include "optionsdialog.h"
 #include "webview.h"
+#include "networkmanager.h"
 #include "parseobject.h"
 #include "toolbutton.h"
 
@@ -39,6 +40,7 @@ enum FeedReedType {
 };
 
 class AdBlockIcon;
+class FeedScheduler;
 
 class MainWindow : public QMainWindow
 {
@@ -227,6 +229,9 @@ public:
 
   AdBlockIcon *adBlockIcon() { return adblockIcon_; }
 
+  TransferStats feedsTransfer() const { return feedsTransfer_; }
+  TransferStats faviconsTransfer() const { return faviconsTransfer_; }
+
   void webViewFullScreen(bool on);
 
 public slots:
@@ -263,13 +268,15 @@ public slots:
   void slotCloseTab(int index);
   QWebPage *createWebTab(QUrl url = QUrl());
   void feedsModelReload(bool checkFilter = false);
+  void feedsModelUpdate(QList<int> idList);
   void setStatusFeed(int feedId, QString status);
+  void slotFeedsTransferDone(TransferStats stats);
+  void slotFaviconsTransferDone(TransferStats stats);
 
 signals:
   void signalQuitApp();
   void signalPlaceToTray();
   void signalGetFeedTimer(int feedId);
-  void signalGetAllFeedsTimer();
   void signalGetFeed(int feedId, QString feedUrl, QDateTime date, int auth);
   void signalGetFeedsFolder(QString query);
   void signalGetAllFeeds();
@@ -277,8 +284,9 @@ signals:
   void signalImportFeeds(QByteArray xmlData);
   void signalRequestUrl(int feedId, QString urlString,
                         QDateTime date, QString userInfo);
-  void faviconRequestUrl(QString urlString, QString feedUrl);
+  void faviconRequestUrl(QString urlString, QString feedUrl, bool force = false);
   void signalIconFeedReady(QString feedUrl, QByteArray faviconData);
+  void signalIconFeedFailed(QString feedUrl);
   void signalSetCurrentTab(int index, bool updateTab = false);
   void signalShowNotification(bool bShowRecentNews=false);
   void signalRefreshInfoTray();
@@ -316,13 +324,13 @@ private slots:
   void showContextMenuFeed(const QPoint & pos);
   void slotFeedsFilter();
   void slotNewsFilter();
-  void slotGetFeedsTimer();
   void showContextMenuToolBar(const QPoint &pos);
   void showFeedPropertiesDlg();
   void slotFeedMenuShow();
   void slotRefreshNewsView(int nextUnread = -1);
   void slotIconFeedPreparing(QString feedUrl, QByteArray byteArray, QString format);
-  void slotIconFeedUpdate(int feedId, QByteArray faviconData);
+  void slotIconFeedUpdate(int feedId);
+  void slotIconSiteUpdate(QString site);
   void showNewsFiltersDlg(bool newFilter = false);
   void showFilterRulesDlg();
   void slotFeedUpPressed();
@@ -466,6 +474,7 @@ private:
   void recountFeedCategories(const QList<int> &categoriesList);
   void creatFeedTab(int feedId, int feedParId);
   void initUpdateFeeds();
+  void updateFeedsIcons();
 
   int addTab(NewsTabWidget *widget);
 
@@ -622,15 +631,14 @@ private:
 
   QPushButton *pushButtonNull_;
 
-  QTimer *updateFeedsTimer_;
-  int updateIntervalSec_;
-  int updateTimeCount_;
+  FeedScheduler *feedScheduler_;
+  // Transfer of last feeds and favicons update
+  TransferStats feedsTransfer_;
+  TransferStats faviconsTransfer_;
   bool updateFeedsEnable_;
   int  updateFeedsInterval_;
   int  updateFeedsIntervalType_;
   QList<int> feedIdList_;
-  QMap<int,int> updateFeedsIntervalSec_;
-  QMap<int,int> updateFeedsTimeCount_;
 
   bool minimizingTray_;
   bool closingTray_;
@@ -69,14 +69,13 @@ QWizardPage *CleanUpWizard::createChooseFeedsPage()
   parentIds.enqueue(0);
   while (!parentIds.empty()) {
     int parentId = parentIds.dequeue();
-    QString qStr = QString("SELECT text, id, image, xmlUrl FROM feeds WHERE parentId='%1' ORDER BY rowToParent").
+    QString qStr = QString("SELECT text, id, xmlUrl FROM feeds WHERE parentId='%1' ORDER BY rowToParent").
         arg(parentId);
     q.exec(qStr);
     while (q.next()) {
       QString feedText = q.value(0).toString();
       QString feedIdStr = q.value(1).toString();
-      QByteArray byteArray = q.value(2).toByteArray();
-      QString xmlUrl = q.value(3).toString();
+      QString xmlUrl = q.value(2).toString();
 
       treeItem.clear();
       treeItem << feedText << feedIdStr << (xmlUrl.isEmpty() ? "0" : "1");
@@ -93,11 +92,11 @@ QWizardPage *CleanUpWizard::createChooseFeedsPage()
       }
       else {
         MainWindow *mainWindow = mainApp->mainWindow();
-        if (byteArray.isNull() || mainWindow->defaultIconFeeds_) {
+        if (mainWindow->defaultIconFeeds_) {
           iconItem.load(":/images/feed");
         }
         else {
-          iconItem.loadFromData(QByteArray::fromBase64(byteArray));
+          iconItem = mainWindow->feedsModel_->iconById(feedIdStr.toInt());
         }
       }
       treeWidgetItem->setIcon(0, iconItem);
@@ -257,13 +256,10 @@ void CleanUpWizard::finishButtonClicked()
   feedsTree_->expandAll();
 
   QStringList feedsIdList;
-  QList<int> foldersIdList;
   QTreeWidgetItem *treeItem = feedsTree_->itemBelow(feedsTree_->topLevelItem(0));
   while (treeItem) {
     if (treeItem->checkState(0) == Qt::Checked)
       feedsIdList << treeItem->text(1);
-    if (treeItem->text(2).toInt() == 0)
-      foldersIdList << treeItem->text(1).toInt();
     treeItem = feedsTree_->itemBelow(treeItem);
   }
 
@@ -282,12 +278,12 @@ void CleanUpWizard::finishButtonClicked()
   settings.setValue("fullCleanUp", fullCleanUp_->isChecked());
   settings.endGroup();
 
-  connect(this, SIGNAL(signalStartCleanUp(bool, QStringList, QList<int>)),
-          mainApp->updateFeeds()->updateObject_, SLOT(startCleanUp(bool, QStringList, QList<int>)));
+  connect(this, SIGNAL(signalStartCleanUp(bool, QStringList)),
+          mainApp->updateFeeds()->updateObject_, SLOT(startCleanUp(bool, QStringList)));
   connect(mainApp->updateFeeds()->updateObject_, SIGNAL(signalFinishCleanUp(int)),
           this, SLOT(finishCleanUp(int)));
 
-  emit signalStartCleanUp(false, feedsIdList, foldersIdList);
+  emit signalStartCleanUp(false, feedsIdList);
 }
 
 void CleanUpWizard::finishCleanUp(int countDeleted)
@@ -11,8 +11,7 @@ public:
   ~CleanUpWizard();
 
 signals:
-  void signalStartCleanUp(bool isShutdown, QStringList feedsIdList,
-                          QList<int> foldersIdList);
+  void signalStartCleanUp(bool isShutdown, QStringList feedsIdList);
 
 public slots:
   void finishCleanUp(int countDeleted);
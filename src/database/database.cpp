@@ -1,6 +1,8 @@
 #include "database.h"
+#include "databaseschema.h"
 
 #include "common.h"
+#include "faviconobject.h"
 #include "mainapplication.h"
 #include "mainwindow.h"
 #include "settings.h"
@@ -9,7 +11,7 @@
 
 #include <sqlite3.h>
 
-const int versionDB = 17;
+const int versionDB = 22;
 
 const QString kCreateFeedsTableQuery(
     "CREATE TABLE feeds("
@@ -105,47 +107,18 @@ const QString kCreateFeedsTableQuery(
     // Version 17
     "SingleClickAction integer default 0, " // ENewsClickAction
     "DoubleClickAction integer default 0, " // ENewsClickAction
-    "MiddleClickAction integer default 0 "  // ENewsClickAction
-    ")");
-
-const QString kCreateNewsTableQuery(
-    "CREATE TABLE news("
-    "id integer primary key, "
-    "feedId integer, "                     // feed id from feed table
-    "guid varchar, "                       // news unique number
-    "guidislink varchar default 'true', "  // flag shows that news unique number is URL-link to news
-    "description varchar, "                // brief description
-    "content varchar, "                    // full content (atom)
-    "title varchar, "                      // title
-    "published varchar, "                  // publish timestamp
-    "modified varchar, "                   // modification timestamp
-    "received varchar, "                   // receive news timestamp (set on receive)
-    "author_name varchar, "                // author name
-    "author_uri varchar, "                 // author web page (atom)
-    "author_email varchar, "               // author e-mail (atom)
-    "category varchar, "                   // category. May be several item tabs separated
-    "label varchar, "                      // label (user purpose label(s))
-    "new integer default 1, "              // Flag "new". Set on receive, reset on application close
-    "read integer default 0, "             // Flag "read". Set after news has been focused
-    "starred integer default 0, "          // Flag "sticky". Set by user
-    "deleted integer default 0, "          // Flag "deleted". News is marked deleted by remains in DB,
-                                           //   for purpose not to display after next update.
-                                           //   News are deleted by cleanup process only
-    "attachment varchar, "                 // Links to attachments (tabs separated)
-    "comments varchar, "                   // News comments page URL-link
-    "enclosure_length, "                   // Media-object, associated to news:
-    "enclosure_type, "                     //   length, type,
-    "enclosure_url, "                      //   URL-address
-    "source varchar, "                     // source, incese of republication (atom: <link via>)
-    "link_href varchar, "                  // URL-link to news (atom: <link self>)
-    "link_enclosure varchar, "             // URL-link to huge amoun of data,
-                                           //   that can't be received in the news
-    "link_related varchar, "               // URL-link for related data of the news (atom)
-    "link_alternate varchar, "             // URL-link to alternative news representation
-    "contributor varchar, "                // contributors (tabs separated)
-    "rights varchar, "                     // copyrights
-    "deleteDate varchar, "                 // news delete timestamp
-    "feedParentId integer default 0 "      // parent feed id from feed table
+    "MiddleClickAction integer default 0, " // ENewsClickAction
+    // Version 19
+    "etag varchar, "          // ETag of last received feed data
+    "lastModified varchar, "  // Last-Modified of last received feed data
+    // Version 20
+    "publishInterval integer, "  // average interval between news arrivals (seconds)
+    "lastPublished varchar, "    // timestamp of last update that brought news
+    "cacheExpires varchar, "     // feed data is fresh until (Cache-Control, Expires)
+    // Version 21
+    "faviconSite varchar, "      // site (scheme://host) feed icon is taken from
+    // Version 22
+    "lastChecked varchar "       // timestamp of last finished update request
     ")");
 
 const QString kCreateFiltersTable(
@@ -194,12 +167,59 @@ const QString kCreatePasswordsTable(
     "password varchar "         // password
     ")");
 
+const QString kCreateFaviconsTable(
+    "CREATE TABLE favicons("
+    "site varchar primary key, "    // scheme://host favicon is looked up for
+    "iconHash varchar, "            // icon in icons table, empty if none found
+    "checked varchar, "             // timestamp of last request
+    "failures integer default 0 "   // number of requests failed in a row
+    ")");
+
+const QString kCreateIconsTable(
+    "CREATE TABLE icons("
+    "hash varchar primary key, "    // SHA-1 of icon data
+    "data blob "                    // icon 16x16 in ICO format
+    ")");
+
 const QString kAddColumnsFeedsTableQuery(
         "ALTER TABLE feeds ADD COLUMN addSingleNewsAnyDateOn integer default 1;"
         "ALTER TABLE feeds ADD COLUMN avoidedOldSingleNewsDateOn integer default 0;"
         "ALTER TABLE feeds ADD COLUMN avoidedOldSingleNewsDate varchar;"
         );
 
+// Full-text index of news, kept in step with news table by triggers.
+// Trigram tokens match any substring, as LIKE '%text%' did, also in
+// scripts without word separators.
+const QString kCreateNewsFtsTableQuery(
+    "CREATE VIRTUAL TABLE IF NOT EXISTS news_fts USING fts5("
+    "title, description, content, author_name, category, "
+    "content='news', content_rowid='id', "
+    "tokenize='trigram')");
+// Shortest text the trigram index can find, shorter text is searched by LIKE
+const int kFullTextMinLength = 3;
+
+const QStringList kCreateNewsFtsTriggersQueries = QStringList()
+    << "CREATE TRIGGER IF NOT EXISTS news_fts_insert AFTER INSERT ON news "
+       "BEGIN "
+       "INSERT INTO news_fts(rowid, title, description, content, author_name, category) "
+       "VALUES (NEW.id, NEW.title, NEW.description, NEW.content, NEW.author_name, NEW.category); "
+       "END"
+    << "CREATE TRIGGER IF NOT EXISTS news_fts_delete AFTER DELETE ON news "
+       "BEGIN "
+       "INSERT INTO news_fts(news_fts, rowid, title, description, content, author_name, category) "
+       "VALUES ('delete', OLD.id, OLD.title, OLD.description, OLD.content, OLD.author_name, OLD.category); "
+       "END"
+    << "CREATE TRIGGER IF NOT EXISTS news_fts_update "
+       "AFTER UPDATE OF title, description, content, author_name, category ON news "
+       "BEGIN "
+       "INSERT INTO news_fts(news_fts, rowid, title, description, content, author_name, category) "
+       "VALUES ('delete', OLD.id, OLD.title, OLD.description, OLD.content, OLD.author_name, OLD.category); "
+       "INSERT INTO news_fts(rowid, title, description, content, author_name, category) "
+       "VALUES (NEW.id, NEW.title, NEW.description, NEW.content, NEW.author_name, NEW.category); "
+       "END";
+
+static bool fullTextSearchEnabled = false;
+
 int Database::version()
 {
   return versionDB;
@@ -239,6 +259,8 @@ void Database::setPragma(QSqlDatabase &db)
   q.exec("PRAGMA page_size = 32768");
   q.exec("PRAGMA cache_size = 131072");
   q.exec("PRAGMA mmap_size = 4294967296");
+  // Feed counters are passed up the categories tree by nested triggers
+  q.exec("PRAGMA recursive_triggers = ON");
 
   q.finish();
 }
@@ -269,6 +291,9 @@ void Database::prepareDatabase()
         q.prepare("INSERT INTO info(name, value) VALUES('appVersion', :appVersion)");
         q.bindValue(":appVersion", STRPRODUCTVER);
         q.exec();
+
+        createCounterTriggers(db);
+        createFullTextIndex();
       } else {
         qWarning() << "Preparation database";
 
@@ -311,6 +336,41 @@ void Database::prepareDatabase()
           q.exec("ALTER table feeds ADD COLUMN MiddleClickAction integer default 0");
         }
 
+        if (dbVersion < 18) {
+          qWarning() << "Creating news indexes";
+          db.transaction();
+          foreach (const QString &qStr, kCreateNewsIndexesQueries) {
+            if (!q.exec(qStr)) {
+              qWarning() << __PRETTY_FUNCTION__ << __LINE__
+                         << "q.lastError(): " << q.lastError().text();
+            }
+          }
+          // Replaced by feedId_flags
+          q.exec("DROP INDEX IF EXISTS feedId");
+          db.commit();
+        }
+        if (dbVersion < 19) {
+          q.exec("ALTER TABLE feeds ADD COLUMN etag varchar");
+          q.exec("ALTER TABLE feeds ADD COLUMN lastModified varchar");
+        }
+        if (dbVersion < 20) {
+          q.exec("ALTER TABLE feeds ADD COLUMN publishInterval integer");
+          q.exec("ALTER TABLE feeds ADD COLUMN lastPublished varchar");
+          q.exec("ALTER TABLE feeds ADD COLUMN cacheExpires varchar");
+        }
+        if (dbVersion < 21) {
+          q.exec("ALTER TABLE feeds ADD COLUMN faviconSite varchar");
+          q.exec(kCreateFaviconsTable);
+          q.exec(kCreateIconsTable);
+          moveFeedIconsToSites(db);
+        }
+        if (dbVersion < 22) {
+          q.exec("ALTER TABLE feeds ADD COLUMN lastChecked varchar");
+        }
+
+        createCounterTriggers(db);
+        createFullTextIndex();
+
         // Update appVersion anyway
         if (appVersion.isEmpty()) {
           q.prepare("INSERT INTO info(name, value) VALUES('appVersion', :appVersion)");
@@ -349,8 +409,10 @@ void Database::createTables(QSqlDatabase &db)
   db.exec(kCreateFeedsTableQuery);
   db.exec(kAddColumnsFeedsTableQuery);
   db.exec(kCreateNewsTableQuery);
-  // Create index for feedId field
-  db.exec("CREATE INDEX feedId ON news(feedId)");
+  // Create indexes for news table
+  foreach (const QString &qStr, kCreateNewsIndexesQueries) {
+    db.exec(qStr);
+  }
 
   // Create extra feeds table just in case
   db.exec("CREATE TABLE feeds_ex(id integer primary key, "
@@ -379,12 +441,214 @@ void Database::createTables(QSqlDatabase &db)
   db.exec(kCreateLabelsTable);
   // Create password table
   db.exec(kCreatePasswordsTable);
+  // Create favicon store tables
+  db.exec(kCreateFaviconsTable);
+  db.exec(kCreateIconsTable);
   //
   db.exec("CREATE TABLE info(id integer primary key, name varchar, value varchar)");
 
   db.commit();
 }
 
+/** @brief Create triggers maintaining feeds counters
+ * @details On first creation counters of all feeds and categories are
+ *   recalculated once, after that they are only changed by triggers.
+ *---------------------------------------------------------------------------*/
+void Database::createCounterTriggers(QSqlDatabase &db)
+{
+  QSqlQuery q(db);
+  q.setForwardOnly(true);
+
+  q.exec("SELECT count(name) FROM sqlite_master "
+         "WHERE type=='trigger' AND name=='feeds_counts_update'");
+  if (q.first() && (q.value(0).toInt() > 0))
+    return;
+
+  qWarning() << "Creating counter triggers";
+
+  db.transaction();
+
+  q.exec(kResetFeedCountersQuery);
+  foreach (const QString &qStr, kCreateCounterTriggersQueries) {
+    if (!q.exec(qStr)) {
+      qWarning() << __PRETTY_FUNCTION__ << __LINE__
+                 << "q.lastError(): " << q.lastError().text();
+    }
+  }
+  q.exec(kCountFeedCountersQuery);
+
+  db.commit();
+}
+
+/** @brief Create full-text index of news
+ * @details Index is filled from news table on first creation. Index is
+ *   created on connection of SQLiteDriver, as SQLite of QSQLITE plugin used
+ *   for preparation may differ. If SQLite is built without FTS5 or is older
+ *   than 3.34 (no trigram tokenizer) the index triggers are removed and
+ *   search falls back to LIKE conditions.
+ *---------------------------------------------------------------------------*/
+void Database::createFullTextIndex()
+{
+  {
+    SQLiteDriver *driver = new SQLiteDriver();
+    QSqlDatabase db = QSqlDatabase::addDatabase(driver, "fullTextIndex");
+    db.setDatabaseName(mainApp->dbFileName());
+    if (!db.open()) {
+      qWarning() << __PRETTY_FUNCTION__ << __LINE__
+                 << "db.lastError(): " << db.lastError().text();
+    } else {
+      createFullTextIndex(db);
+      db.close();
+    }
+  }
+  QSqlDatabase::removeDatabase("fullTextIndex");
+}
+
+void Database::createFullTextIndex(QSqlDatabase &db)
+{
+  QSqlQuery q(db);
+  q.setForwardOnly(true);
+
+  fullTextSearchEnabled = false;
+  // Trigram tokenizer is available since SQLite 3.34
+  bool available = sqlite3_compileoption_used("ENABLE_FTS5") &&
+      (sqlite3_libversion_number() >= 3034000);
+
+  // Index made with other tokenizer is made again
+  bool rebuild = false;
+  q.exec("SELECT sql FROM sqlite_master WHERE type=='table' AND name=='news_fts'");
+  if (q.first() && !q.value(0).toString().contains("trigram") && available) {
+    q.finish();
+    rebuild = q.exec("DROP TABLE news_fts");
+  }
+  q.finish();
+
+  if (!available || !q.exec(kCreateNewsFtsTableQuery)) {
+    qWarning() << "Full-text search is not available:" << sqlite3_libversion()
+               << q.lastError().text();
+    q.exec("DROP TRIGGER IF EXISTS news_fts_insert");
+    q.exec("DROP TRIGGER IF EXISTS news_fts_delete");
+    q.exec("DROP TRIGGER IF EXISTS news_fts_update");
+    return;
+  }
+  fullTextSearchEnabled = true;
+
+  if (!rebuild) {
+    q.exec("SELECT count(name) FROM sqlite_master "
+           "WHERE type=='trigger' AND name=='news_fts_update'");
+    if (q.first() && (q.value(0).toInt() > 0))
+      return;
+  }
+
+  qWarning() << "Creating full-text index";
+
+  db.transaction();
+  foreach (const QString &qStr, kCreateNewsFtsTriggersQueries) {
+    if (!q.exec(qStr)) {
+      qWarning() << __PRETTY_FUNCTION__ << __LINE__
+                 << "q.lastError(): " << q.lastError().text();
+    }
+  }
+  q.exec("INSERT INTO news_fts(news_fts) VALUES('rebuild')");
+  db.commit();
+}
+
+/** @brief Condition selecting news which \a columns contain \a text
+ * @details Text is matched as case-insensitive substring, the same as
+ *   UPPER(column) LIKE '%TEXT%'.
+ * @return SQL condition for news table or empty string if full-text search
+ *   can't be used or text is too short for it
+ *---------------------------------------------------------------------------*/
+QString Database::fullTextCondition(const QString &text, const QStringList &columns)
+{
+  if (!fullTextSearchEnabled || (text.toUcs4().size() < kFullTextMinLength))
+    return QString();
+
+  QString match = QString("\"%1\"").arg(QString(text).replace("\"", "\"\""));
+  if (!columns.isEmpty())
+    match = QString("{%1} : %2").arg(columns.join(" ")).arg(match);
+
+  return QString("id IN (SELECT rowid FROM news_fts WHERE news_fts MATCH '%1')").
+      arg(match.replace("'", "''"));
+}
+
+/** @brief Fill favicon site of feeds and move site icons to icons table
+ * @details Icon most feeds of site have is taken as icon of site, and it
+ *   is removed from these feeds. Other icons are kept in feeds as chosen by
+ *   user. Sites are requested again as their icons have not been checked.
+ *---------------------------------------------------------------------------*/
+void Database::moveFeedIconsToSites(QSqlDatabase &db)
+{
+  QHash<int,QString> sitesList;                 // feed id -> site
+  QHash<int,QByteArray> hashesList;             // feed id -> hash of icon
+  QHash<QByteArray,QByteArray> iconsList;       // hash -> icon data
+  QHash<QString,QHash<QByteArray,int> > countsList;  // site -> hash -> feeds
+
+  QSqlQuery q(db);
+  q.setForwardOnly(true);
+  q.exec("SELECT id, htmlUrl, xmlUrl, image FROM feeds WHERE xmlUrl != ''");
+  while (q.next()) {
+    QString site = FaviconObject::siteUrl(q.value(1).toString(),
+                                          q.value(2).toString()).toString();
+    if (site.isEmpty())
+      continue;
+    int id = q.value(0).toInt();
+    sitesList.insert(id, site);
+
+    QByteArray data = QByteArray::fromBase64(q.value(3).toByteArray());
+    if (data.isEmpty())
+      continue;
+    QByteArray hash = QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex();
+    hashesList.insert(id, hash);
+    iconsList.insert(hash, data);
+    countsList[site][hash]++;
+  }
+
+  db.transaction();
+
+  QHash<QString,QByteArray> siteHashesList;
+  QHash<QString,QHash<QByteArray,int> >::const_iterator it = countsList.constBegin();
+  for (; it != countsList.constEnd(); ++it) {
+    QByteArray siteHash;
+    int count = 0;
+    QHash<QByteArray,int>::const_iterator itCount = it.value().constBegin();
+    for (; itCount != it.value().constEnd(); ++itCount) {
+      if (itCount.value() > count) {
+        siteHash = itCount.key();
+        count = itCount.value();
+      }
+    }
+    siteHashesList.insert(it.key(), siteHash);
+
+    q.prepare("INSERT OR IGNORE INTO icons(hash, data) VALUES (?, ?)");
+    q.addBindValue(QString::fromLatin1(siteHash));
+    q.addBindValue(iconsList.value(siteHash));
+    q.exec();
+    q.prepare("INSERT OR IGNORE INTO favicons(site, iconHash, failures) VALUES (?, ?, 0)");
+    q.addBindValue(it.key());
+    q.addBindValue(QString::fromLatin1(siteHash));
+    q.exec();
+  }
+
+  QHash<int,QString>::const_iterator itSite = sitesList.constBegin();
+  for (; itSite != sitesList.constEnd(); ++itSite) {
+    q.prepare("INSERT OR IGNORE INTO favicons(site, failures) VALUES (?, 0)");
+    q.addBindValue(itSite.value());
+    q.exec();
+
+    QByteArray hash = hashesList.value(itSite.key());
+    if (!hash.isEmpty() && (hash == siteHashesList.value(itSite.value())))
+      q.prepare("UPDATE feeds SET faviconSite=?, image=NULL WHERE id=?");
+    else
+      q.prepare("UPDATE feeds SET faviconSite=? WHERE id=?");
+    q.addBindValue(itSite.value());
+    q.addBindValue(itSite.key());
+    q.exec();
+  }
+
+  db.commit();
+}
+
 void Database::createLabels(QSqlDatabase &db)
 {
   QSqlQuery q(db);
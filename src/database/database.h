@@ -13,13 +13,19 @@ public:
   static QSqlDatabase connection(const QString &connectionName = QString());
   static void sqliteDBMemFile(QSqlDatabase &db, bool save = true);
   static void setVacuum();
+  static QString fullTextCondition(const QString &text,
+                                   const QStringList &columns = QStringList());
 
 private:
   static void setPragma(QSqlDatabase &db);
   static void createTables(QSqlDatabase &db);
   static void prepareDatabase();
   static void createLabels(QSqlDatabase &db);
+  static void createCounterTriggers(QSqlDatabase &db);
+  static void createFullTextIndex();
+  static void createFullTextIndex(QSqlDatabase &db);
   static void addColumnsToFeedsTables(QSqlDatabase &db);
+  static void moveFeedIconsToSites(QSqlDatabase &db);
 
   static QStringList tablesList() {
     QStringList tables;
@@ -0,0 +1,145 @@
+#ifndef DATABASESCHEMA_H
+#define DATABASESCHEMA_H
+
+#include <QString>
+#include <QStringList>
+
+const QString kCreateNewsTableQuery(
+    "CREATE TABLE news("
+    "id integer primary key, "
+    "feedId integer, "                     // feed id from feed table
+    "guid varchar, "                       // news unique number
+    "guidislink varchar default 'true', "  // flag shows that news unique number is URL-link to news
+    "description varchar, "                // brief description
+    "content varchar, "                    // full content (atom)
+    "title varchar, "                      // title
+    "published varchar, "                  // publish timestamp
+    "modified varchar, "                   // modification timestamp
+    "received varchar, "                   // receive news timestamp (set on receive)
+    "author_name varchar, "                // author name
+    "author_uri varchar, "                 // author web page (atom)
+    "author_email varchar, "               // author e-mail (atom)
+    "category varchar, "                   // category. May be several item tabs separated
+    "label varchar, "                      // label (user purpose label(s))
+    "new integer default 1, "              // Flag "new". Set on receive, reset on application close
+    "read integer default 0, "             // Flag "read". Set after news has been focused
+    "starred integer default 0, "          // Flag "sticky". Set by user
+    "deleted integer default 0, "          // Flag "deleted". News is marked deleted by remains in DB,
+                                           //   for purpose not to display after next update.
+                                           //   News are deleted by cleanup process only
+    "attachment varchar, "                 // Links to attachments (tabs separated)
+    "comments varchar, "                   // News comments page URL-link
+    "enclosure_length, "                   // Media-object, associated to news:
+    "enclosure_type, "                     //   length, type,
+    "enclosure_url, "                      //   URL-address
+    "source varchar, "                     // source, incese of republication (atom: <link via>)
+    "link_href varchar, "                  // URL-link to news (atom: <link self>)
+    "link_enclosure varchar, "             // URL-link to huge amoun of data,
+                                           //   that can't be received in the news
+    "link_related varchar, "               // URL-link for related data of the news (atom)
+    "link_alternate varchar, "             // URL-link to alternative news representation
+    "contributor varchar, "                // contributors (tabs separated)
+    "rights varchar, "                     // copyrights
+    "deleteDate varchar, "                 // news delete timestamp
+    "feedParentId integer default 0 "      // parent feed id from feed table
+    ")");
+
+// Indexes of news table used by news lists, counters and cleanup
+const QStringList kCreateNewsIndexesQueries = QStringList()
+    // Feed news filtered by flags; also serves any lookup by feedId
+    << "CREATE INDEX IF NOT EXISTS feedId_flags ON news(feedId, deleted, read, new, starred)"
+    // Feed news ordered by publish date (news list, cleanup)
+    << "CREATE INDEX IF NOT EXISTS feedId_published ON news(feedId, published)"
+    // "New" news (notifications, reset of new flag)
+    << "CREATE INDEX IF NOT EXISTS newNews ON news(feedId) WHERE new = 1"
+    // Categories "Unread", "Starred", "Deleted"; covers recount of their counters
+    << "CREATE INDEX IF NOT EXISTS flags ON news(deleted, starred, read, label)";
+
+// Triggers keeping unread/newCount/undeleteCount of feeds in step with news.
+// Changes of a feed are passed on to its parent, and so up to the tree root.
+const QStringList kCreateCounterTriggersQueries = QStringList()
+    << "CREATE TRIGGER IF NOT EXISTS news_counts_insert "
+       "AFTER INSERT ON news WHEN NEW.deleted IS 0 "
+       "BEGIN "
+       "UPDATE feeds SET "
+       "undeleteCount = ifnull(undeleteCount, 0) + 1, "
+       "unread = ifnull(unread, 0) + (NEW.read IS 0), "
+       "newCount = ifnull(newCount, 0) + (NEW.new IS 1) "
+       "WHERE id == NEW.feedId; "
+       "END"
+    << "CREATE TRIGGER IF NOT EXISTS news_counts_delete "
+       "AFTER DELETE ON news WHEN OLD.deleted IS 0 "
+       "BEGIN "
+       "UPDATE feeds SET "
+       "undeleteCount = ifnull(undeleteCount, 0) - 1, "
+       "unread = ifnull(unread, 0) - (OLD.read IS 0), "
+       "newCount = ifnull(newCount, 0) - (OLD.new IS 1) "
+       "WHERE id == OLD.feedId; "
+       "END"
+    << "CREATE TRIGGER IF NOT EXISTS news_counts_update "
+       "AFTER UPDATE OF feedId, read, new, deleted ON news "
+       "WHEN (OLD.feedId IS NOT NEW.feedId) OR (OLD.deleted IS 0) OR (NEW.deleted IS 0) "
+       "BEGIN "
+       "UPDATE feeds SET "
+       "undeleteCount = ifnull(undeleteCount, 0) - (OLD.deleted IS 0) "
+       "+ (OLD.feedId IS NEW.feedId AND NEW.deleted IS 0), "
+       "unread = ifnull(unread, 0) - (OLD.deleted IS 0 AND OLD.read IS 0) "
+       "+ (OLD.feedId IS NEW.feedId AND NEW.deleted IS 0 AND NEW.read IS 0), "
+       "newCount = ifnull(newCount, 0) - (OLD.deleted IS 0 AND OLD.new IS 1) "
+       "+ (OLD.feedId IS NEW.feedId AND NEW.deleted IS 0 AND NEW.new IS 1) "
+       "WHERE id == OLD.feedId; "
+       "UPDATE feeds SET "
+       "undeleteCount = ifnull(undeleteCount, 0) + (NEW.deleted IS 0), "
+       "unread = ifnull(unread, 0) + (NEW.deleted IS 0 AND NEW.read IS 0), "
+       "newCount = ifnull(newCount, 0) + (NEW.deleted IS 0 AND NEW.new IS 1) "
+       "WHERE id == NEW.feedId AND OLD.feedId IS NOT NEW.feedId; "
+       "END"
+    << "CREATE TRIGGER IF NOT EXISTS feeds_counts_update "
+       "AFTER UPDATE OF unread, newCount, undeleteCount, parentId ON feeds "
+       "WHEN (ifnull(OLD.unread, 0) != ifnull(NEW.unread, 0)) OR "
+       "(ifnull(OLD.newCount, 0) != ifnull(NEW.newCount, 0)) OR "
+       "(ifnull(OLD.undeleteCount, 0) != ifnull(NEW.undeleteCount, 0)) OR "
+       "(ifnull(OLD.parentId, 0) != ifnull(NEW.parentId, 0)) "
+       "BEGIN "
+       "UPDATE feeds SET "
+       "unread = ifnull(unread, 0) - ifnull(OLD.unread, 0) "
+       "+ (ifnull(OLD.parentId, 0) == ifnull(NEW.parentId, 0)) * ifnull(NEW.unread, 0), "
+       "newCount = ifnull(newCount, 0) - ifnull(OLD.newCount, 0) "
+       "+ (ifnull(OLD.parentId, 0) == ifnull(NEW.parentId, 0)) * ifnull(NEW.newCount, 0), "
+       "undeleteCount = ifnull(undeleteCount, 0) - ifnull(OLD.undeleteCount, 0) "
+       "+ (ifnull(OLD.parentId, 0) == ifnull(NEW.parentId, 0)) * ifnull(NEW.undeleteCount, 0) "
+       "WHERE id == OLD.parentId AND id != OLD.id; "
+       "UPDATE feeds SET "
+       "unread = ifnull(unread, 0) + ifnull(NEW.unread, 0), "
+       "newCount = ifnull(newCount, 0) + ifnull(NEW.newCount, 0), "
+       "undeleteCount = ifnull(undeleteCount, 0) + ifnull(NEW.undeleteCount, 0) "
+       "WHERE id == NEW.parentId AND id != NEW.id AND "
+       "ifnull(OLD.parentId, 0) != ifnull(NEW.parentId, 0); "
+       "END"
+    << "CREATE TRIGGER IF NOT EXISTS feeds_counts_delete "
+       "AFTER DELETE ON feeds "
+       "BEGIN "
+       "UPDATE feeds SET "
+       "unread = ifnull(unread, 0) - ifnull(OLD.unread, 0), "
+       "newCount = ifnull(newCount, 0) - ifnull(OLD.newCount, 0), "
+       "undeleteCount = ifnull(undeleteCount, 0) - ifnull(OLD.undeleteCount, 0) "
+       "WHERE id == OLD.parentId; "
+       "END";
+
+// Counters are reset before triggers are created
+const QString kResetFeedCountersQuery(
+    "UPDATE feeds SET unread=0, newCount=0, undeleteCount=0");
+
+// Counters of feeds are counted once after triggers are created, counters
+// of categories are summed up by triggers
+const QString kCountFeedCountersQuery(
+    "UPDATE feeds SET "
+    "undeleteCount=(SELECT count(id) FROM news "
+    "WHERE feedId==feeds.id AND deleted==0), "
+    "unread=(SELECT count(id) FROM news "
+    "WHERE feedId==feeds.id AND read==0 AND deleted==0), "
+    "newCount=(SELECT count(id) FROM news "
+    "WHERE feedId==feeds.id AND new==1 AND deleted==0) "
+    "WHERE ifnull(xmlUrl, '') != ''");
+
+#endif // DATABASESCHEMA_H
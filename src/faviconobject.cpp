@@ -2,7 +2,6 @@
 #include "VersionNo.h"
 #include "mainapplication.h"
 #include "globals.h"
-#include "common.h"
 
 #include <QDebug>
 #include <QtSql>
@@ -26,8 +25,10 @@ FaviconObject::FaviconObject(QObject *parent)
   getUrlTimer_->setInterval(20);
   connect(getUrlTimer_, SIGNAL(timeout()), this, SLOT(getQueuedUrl()));
 
-  connect(this, SIGNAL(signalGet(QUrl,QString,int)),
-          SLOT(slotGet(QUrl,QString,int)));
+  // Next request of a favicon is sent after reply has been processed
+  connect(this, SIGNAL(signalGet(QUrl,QString,int,bool)),
+          SLOT(slotGet(QUrl,QString,int,bool)),
+          Qt::QueuedConnection);
 }
 
 void FaviconObject::disconnectObjects()
@@ -37,9 +38,23 @@ void FaviconObject::disconnectObjects()
     networkManager_->disconnect(networkManager_);
 }
 
+/** @brief Site (scheme://host) whose favicon is used for feed
+ * @param urlString - homepage of feed, host of \a feedUrl is used if empty
+ *----------------------------------------------------------------------------*/
+QUrl FaviconObject::siteUrl(const QString &urlString, const QString &feedUrl)
+{
+  QUrl url = QUrl::fromEncoded(urlString.toUtf8());
+  if (url.host().isEmpty())
+    url = QUrl::fromEncoded(feedUrl.toUtf8());
+  if (url.host().isEmpty())
+    return QUrl();
+  return QUrl(QString("%1://%2").arg(url.scheme()).arg(url.host()));
+}
+
 /** @brief Put requested URL in request queue
+ * @param revalidate - icon is requested from server even if it is cached
  *----------------------------------------------------------------------------*/
-void FaviconObject::requestUrl(QString urlString, QString feedUrl)
+void FaviconObject::requestUrl(QString urlString, QString feedUrl, bool revalidate)
 {
   if (!networkManager_) {
     networkManager_ = new NetworkManager(true, this);
@@ -52,6 +67,7 @@ void FaviconObject::requestUrl(QString urlString, QString feedUrl)
 
   urlsQueue_.enqueue(urlString);
   feedsQueue_.enqueue(feedUrl);
+  revalidateQueue_.enqueue(revalidate);
 
   if (!getUrlTimer_->isActive())
     getUrlTimer_->start();
@@ -81,30 +97,34 @@ void FaviconObject::getQueuedUrl()
 
     QString urlString = urlsQueue_.dequeue();
     feedUrl = feedsQueue_.dequeue();
+    bool revalidate = revalidateQueue_.dequeue();
 
-    QUrl url = QUrl::fromEncoded(urlString.toUtf8());
-    url.setUrl(QString("%1://%2").arg(url.scheme()).arg(url.host()));
+    QUrl url = siteUrl(urlString, feedUrl);
     if (!url.isValid()) {
-      url = QUrl::fromEncoded(feedUrl.toUtf8());
-      url.setUrl(QString("%1://%2").arg(url.scheme()).arg(url.host()));
+      emit signalIconFailed(feedUrl);
+      return;
     }
-    emit signalGet(url, feedUrl, 0);
+    emit signalGet(url, feedUrl, 0, revalidate);
   }
 }
 
 /** @brief Prepare and send network request to receive all data
  *----------------------------------------------------------------------------*/
-void FaviconObject::slotGet(const QUrl &getUrl, const QString &feedUrl, const int &count)
+void FaviconObject::slotGet(const QUrl &getUrl, const QString &feedUrl, const int &count,
+                            bool revalidate)
 {
-  if (count)
-    Common::sleep(30);
-
   QNetworkRequest request(getUrl);
   request.setRawHeader("User-Agent", globals.userAgent().toUtf8());
+  // Favicons change rarely, cached ones are used however old they are
+  // unless icon has expired or is requested by user
+  request.setAttribute(QNetworkRequest::CacheLoadControlAttribute,
+                       revalidate ? QNetworkRequest::AlwaysNetwork
+                                  : QNetworkRequest::PreferCache);
 
   currentUrls_.append(getUrl);
   currentFeeds_.append(feedUrl);
   currentCntRequests_.append(count);
+  currentRevalidate_.append(revalidate);
   currentTime_.append(REQUEST_TIMEOUT);
 
   QNetworkReply *reply = networkManager_->get(request);
@@ -117,12 +137,17 @@ void FaviconObject::slotGet(const QUrl &getUrl, const QString &feedUrl, const in
  *----------------------------------------------------------------------------*/
 void FaviconObject::finished(QNetworkReply *reply)
 {
+  transfer_.repliesCount++;
+  if (reply->attribute(QNetworkRequest::SourceIsFromCacheAttribute).toBool())
+    transfer_.cachedRepliesCount++;
+
   int currentReplyIndex = currentUrls_.indexOf(reply->url());
   if (currentReplyIndex >= 0) {
     currentTime_.removeAt(currentReplyIndex);
     QUrl url = currentUrls_.takeAt(currentReplyIndex);
     QString feedUrl = currentFeeds_.takeAt(currentReplyIndex);
     int cntRequests = currentCntRequests_.takeAt(currentReplyIndex);
+    bool revalidate = currentRevalidate_.takeAt(currentReplyIndex);
 
     if ((reply->error() == QNetworkReply::NoError) || (reply->error() == QNetworkReply::UnknownContentError)) {
       QUrl redirectionTarget = reply->attribute(QNetworkRequest::RedirectionTargetAttribute).toUrl();
@@ -134,7 +159,9 @@ void FaviconObject::finished(QNetworkReply *reply)
             else
               redirectionTarget.setUrl(url.scheme()+"://"+url.host()+"/"+redirectionTarget.toString());
           }
-          emit signalGet(redirectionTarget, feedUrl, cntRequests+2);
+          emit signalGet(redirectionTarget, feedUrl, cntRequests+2, revalidate);
+        } else {
+          emit signalIconFailed(feedUrl);
         }
       } else {
         QByteArray data = reply->readAll();
@@ -170,14 +197,14 @@ void FaviconObject::finished(QNetworkReply *reply)
                   }
                   linkFavicon = urlFavicon.toString().simplified();
                   qDebug() << "Favicon URL:" << linkFavicon;
-                  emit signalGet(linkFavicon, feedUrl, cntRequests+1);
+                  emit signalGet(linkFavicon, feedUrl, cntRequests+1, revalidate);
                 }
               }
             }
             if (linkFavicon.isEmpty()) {
               if ((cntRequests == 0) || (cntRequests == 2)) {
                 QString link = QString("%1://%2/favicon.ico").arg(url.scheme()).arg(url.host());
-                emit signalGet(link, feedUrl, cntRequests+1);
+                emit signalGet(link, feedUrl, cntRequests+1, revalidate);
               }
             }
           } else {
@@ -188,7 +215,9 @@ void FaviconObject::finished(QNetworkReply *reply)
         } else {
           if ((cntRequests == 0) || (cntRequests == 2)) {
             QString link = QString("%1://%2/favicon.ico").arg(url.scheme()).arg(url.host());
-            emit signalGet(link, feedUrl, cntRequests+1);
+            emit signalGet(link, feedUrl, cntRequests+1, revalidate);
+          } else {
+            emit signalIconFailed(feedUrl);
           }
         }
       }
@@ -201,8 +230,10 @@ void FaviconObject::finished(QNetworkReply *reply)
 
       if ((cntRequests == 0) || (cntRequests == 1)) {
         QString link = QString("%1://%2").arg(url.scheme()).arg(url.host());
-        emit signalGet(link, feedUrl, 2);
+        emit signalGet(link, feedUrl, 2, revalidate);
         qDebug() << "Request Url error: " << reply->url().toString() << reply->errorString();
+      } else {
+        emit signalIconFailed(feedUrl);
       }
     }
   } else {
@@ -216,6 +247,13 @@ void FaviconObject::finished(QNetworkReply *reply)
   }
   reply->abort();
   reply->deleteLater();
+
+  if (urlsQueue_.isEmpty() && currentUrls_.isEmpty()) {
+    qDebug() << "Favicons transfer:" << transfer_.cachedRepliesCount << "of"
+             << transfer_.repliesCount << "replies from cache";
+    emit transferDone(transfer_);
+    transfer_ = TransferStats();
+  }
 }
 
 /** @brief Timeout to delete requests without answer from server
@@ -228,6 +266,7 @@ void FaviconObject::slotRequestTimeout()
       QUrl url = currentUrls_.takeAt(i);
       QString feedUrl = currentFeeds_.takeAt(i);
       int cntRequests = currentCntRequests_.takeAt(i);
+      bool revalidate = currentRevalidate_.takeAt(i);
       currentTime_.removeAt(i);
 
       int replyIndex = requestUrl_.indexOf(url);
@@ -237,9 +276,11 @@ void FaviconObject::slotRequestTimeout()
         reply->deleteLater();
 
         if (cntRequests == 0) {
-          emit signalGet(url, feedUrl, 2);
+          emit signalGet(url, feedUrl, 2, revalidate);
+          continue;
         }
       }
+      emit signalIconFailed(feedUrl);
     } else {
       currentTime_.replace(i, time);
     }
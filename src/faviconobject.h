@@ -18,14 +18,20 @@ public:
 
   void disconnectObjects();
 
+  static QUrl siteUrl(const QString &urlString, const QString &feedUrl);
+
 public slots:
-  void requestUrl(QString urlString, QString feedUrl);
-  void slotGet(const QUrl &getUrl, const QString &feedUrl, const int &count);
+  void requestUrl(QString urlString, QString feedUrl, bool revalidate = false);
+  void slotGet(const QUrl &getUrl, const QString &feedUrl, const int &count,
+               bool revalidate);
 
 signals:
   void startTimer();
-  void signalGet(const QUrl &getUrl, const QString &feedUrl, const int &count);
+  void signalGet(const QUrl &getUrl, const QString &feedUrl, const int &count,
+                 bool revalidate);
   void signalIconRecived(QString feedUrl, QByteArray byteArray, QString format);
+  void signalIconFailed(QString feedUrl);
+  void transferDone(TransferStats stats);
 
 private slots:
   void getQueuedUrl();
@@ -37,17 +43,22 @@ private:
 
   QQueue<QString> urlsQueue_;
   QQueue<QString> feedsQueue_;
+  QQueue<bool> revalidateQueue_;
 
   QTimer *timeout_;
   QTimer *getUrlTimer_;
   QList<QUrl> currentUrls_;
   QList<QString> currentFeeds_;
   QList<int> currentCntRequests_;
+  QList<bool> currentRevalidate_;
   QList<int> currentTime_;
   QList<QUrl> requestUrl_;
   QList<QNetworkReply*> networkReply_;
   QList<QString> hostList_;
 
+  // Replies and replies from cache since queue was empty
+  TransferStats transfer_;
+
 };
 
 #endif // FAVICONOBJECT_H
@@ -0,0 +1,903 @@
+#include "feedparser.h"
+
+#include <QDebug>
+#include <QHash>
+#include <QSet>
+#include <QTextCodec>
+#include <QTextDocumentFragment>
+#include <QUrl>
+#include <qzregexp.h>
+
+FeedParser::FeedParser()
+{
+}
+
+/** @brief Parse feed data
+ * @param xmlData - feed data as received
+ * @param feedUrl - URL of feed, base of relative links
+ * @param codecName - charset of reply, used if data does not declare encoding
+ * @return false if data is not well-formed xml or has content after it
+ *----------------------------------------------------------------------------*/
+bool FeedParser::parse(const QByteArray &xmlData, const QString &feedUrl,
+                       const QString &codecName)
+{
+  feedType_.clear();
+  feedItem_ = FeedItemStruct();
+  newsList_.clear();
+  errorString_.clear();
+
+  bool codecOk = false;
+  bool rawData = false;
+  QString convertData;
+  QXmlStreamReader xml;
+  xml.setNamespaceProcessing(false);
+
+  QzRegExp rx("encoding=\"([^\"]+)", Qt::CaseInsensitive);
+  int pos = rx.indexIn(xmlData);
+  if (pos == -1) {
+    rx.setPattern("encoding='([^']+)");
+    pos = rx.indexIn(xmlData);
+  }
+  if (pos > -1) {
+    QString codecNameT = rx.cap(1);
+    qDebug() << "Codec name (1):" << codecNameT;
+    QTextCodec *codec = QTextCodec::codecForName(codecNameT.toUtf8());
+    if (codec) {
+      // UTF-8 is decoded by the reader itself without a copy of data
+      if (codec->mibEnum() == 106)
+        rawData = true;
+      else
+        convertData = codec->toUnicode(xmlData);
+    } else {
+      qWarning() << "Codec not found (1): " << codecNameT << feedUrl;
+      QString str(xmlData);
+      if (codecNameT.contains("us-ascii", Qt::CaseInsensitive))
+        convertData = str.remove(rx.cap(0)+"\"");
+      else
+        convertData = str;
+    }
+  } else {
+    if (!codecName.isEmpty()) {
+      qDebug() << "Codec name (2):" << codecName;
+      QTextCodec *codec = QTextCodec::codecForName(codecName.toUtf8());
+      if (codec) {
+        convertData = codec->toUnicode(xmlData);
+        codecOk = true;
+      } else {
+        qWarning() << "Codec not found (2): " << codecName << feedUrl;
+      }
+    }
+    if (!codecOk) {
+      codecOk = false;
+      QStringList codecNameList;
+      codecNameList << "UTF-8" << "Windows-1251" << "KOI8-R" << "KOI8-U"
+                    << "ISO 8859-5" << "IBM 866";
+      foreach (QString codecNameT, codecNameList) {
+        QTextCodec *codec = QTextCodec::codecForName(codecNameT.toUtf8());
+        if (codec && codec->canEncode(xmlData)) {
+          qDebug() << "Codec name (3):" << codecNameT;
+          convertData = codec->toUnicode(xmlData);
+          codecOk = true;
+          break;
+        }
+      }
+      if (!codecOk) {
+        convertData = QString::fromLocal8Bit(xmlData);
+      }
+    }
+  }
+
+  if (rawData)
+    xml.addData(xmlData);
+  else
+    xml.addData(convertData);
+  convertData.clear();
+
+  // News are read in a single pass while the root element is being read
+  while (!xml.atEnd()) {
+    if (xml.readNext() == QXmlStreamReader::StartElement) {
+      feedType_ = xml.qualifiedName().toString();
+      qDebug() << "Feed type: " << feedType_;
+
+      if (feedType_ == "feed") {
+        parseAtom(feedUrl, xml);
+      } else if ((feedType_ == "rss") || (feedType_ == "rdf:RDF")) {
+        parseRss(feedUrl, xml);
+      }
+      break;
+    }
+  }
+  // Reader rejects anything but comments and whitespace after root element
+  while (!xml.atEnd())
+    xml.readNext();
+
+  if (xml.hasError()) {
+    errorString_ = QString("line %1, column %2: %3").
+        arg(xml.lineNumber()).arg(xml.columnNumber()).arg(xml.errorString());
+    feedType_.clear();
+    feedItem_ = FeedItemStruct();
+    newsList_.clear();
+    return false;
+  }
+  return true;
+}
+
+void FeedParser::parseAtom(const QString &feedUrl, QXmlStreamReader &xml)
+{
+  FeedItemStruct feedItem;
+  QList<QXmlStreamAttributes> linksList;
+  QSet<QString> namedItems;
+
+  feedItem.linkBase = xml.attributes().value("xml:base").toString();
+
+  int depth = 0;
+  while (!xml.atEnd()) {
+    QXmlStreamReader::TokenType token = xml.readNext();
+    if (token == QXmlStreamReader::EndElement) {
+      if (--depth < 0) break;
+      continue;
+    }
+    if (token != QXmlStreamReader::StartElement)
+      continue;
+
+    ++depth;
+    QString name = xml.qualifiedName().toString();
+    if (name == "entry") {
+      newsList_.append(readAtomEntry(feedUrl, xml, &linksList));
+      --depth;
+      continue;
+    }
+    if (name == "link")
+      linksList.append(xml.attributes());
+    if ((depth != 1) || namedItems.contains(name))
+      continue;
+
+    namedItems.insert(name);
+    if (name == "title") {
+      feedItem.title = toPlainText(readElement(xml));
+      --depth;
+    } else if (name == "subtitle") {
+      feedItem.description = readElement(xml);
+      --depth;
+    } else if (name == "updated") {
+      feedItem.updated = parseDate(readElement(xml), feedUrl);
+      --depth;
+    } else if (name == "language") {
+      feedItem.language = readElement(xml);
+      --depth;
+    } else if (name == "author") {
+      readAtomAuthor(xml, &feedItem.author, &feedItem.authorUri, &feedItem.authorEmail);
+      --depth;
+    }
+  }
+
+  for (int j = 0; j < linksList.size(); j++) {
+    if (linksList.at(j).value("rel") == "alternate") {
+      feedItem.link = linksList.at(j).value("href").toString();
+      break;
+    }
+  }
+  if (feedItem.link.isEmpty()) {
+    for (int j = 0; j < linksList.size(); j++) {
+        if (!(linksList.at(j).value("rel") == "self")) {
+          feedItem.link = linksList.at(j).value("href").toString();
+          break;
+        }
+    }
+  }
+
+  if (QUrl(feedItem.link).host().isEmpty() || (QUrl(feedItem.link).host().indexOf('.')) == -1) {
+    if (!feedItem.linkBase.isEmpty() && !QUrl(feedItem.linkBase).host().isEmpty())
+      feedItem.link = QUrl(feedItem.linkBase).scheme() %  "://" % QUrl(feedItem.linkBase).host();
+    else
+      feedItem.link = QUrl(feedUrl).scheme() %  "://" % QUrl(feedUrl).host();
+  }
+  if (feedItem.linkBase.isEmpty() && !QUrl(feedItem.link).host().isEmpty())
+    feedItem.linkBase = QUrl(feedItem.link).scheme() %  "://" % QUrl(feedItem.link).host();
+  if (QUrl(feedItem.link).host().isEmpty())
+    feedItem.link = feedItem.linkBase + feedItem.link;
+  feedItem.link = toPlainText(feedItem.link);
+  QUrl url = QUrl(feedItem.link);
+  if (url.scheme().isEmpty())
+    url.setScheme(QUrl(feedUrl).scheme());
+  feedItem.link = url.toString();
+
+  feedItem_ = feedItem;
+
+  // Links of entries are resolved when base of the feed is known
+  for (int i = 0; i < newsList_.size(); i++) {
+    NewsItemStruct &newsItem = newsList_[i];
+    if (!newsItem.link.isEmpty() && QUrl(newsItem.link).host().isEmpty())
+      newsItem.link = feedItem.linkBase + newsItem.link;
+    newsItem.link = toPlainText(newsItem.link);
+    if (!newsItem.linkAlternate.isEmpty() && QUrl(newsItem.linkAlternate).host().isEmpty())
+      newsItem.linkAlternate = feedItem.linkBase + newsItem.linkAlternate;
+    newsItem.linkAlternate = toPlainText(newsItem.linkAlternate);
+    if (newsItem.link.isEmpty()) {
+      newsItem.link = newsItem.linkAlternate;
+      newsItem.linkAlternate.clear();
+    }
+    url = QUrl(newsItem.link);
+    if (url.scheme().isEmpty())
+      url.setScheme(QUrl(feedUrl).scheme());
+    newsItem.link = url.toString();
+  }
+}
+
+/** @brief Read Atom entry from current element
+ * @param feedLinks - List to collect all links of the feed
+ *----------------------------------------------------------------------------*/
+NewsItemStruct FeedParser::readAtomEntry(const QString &feedUrl, QXmlStreamReader &xml,
+                                          QList<QXmlStreamAttributes> *feedLinks)
+{
+  NewsItemStruct newsItem;
+  QString published;
+  QString updated;
+  QString issued;
+  QString summaryXml;
+  bool hasSummary = false;
+  QString contentType;
+  QString contentXml;
+  QString imgUrl;
+  QString community;
+  bool hasMediaGroup = false;
+  QString mediaDescription;
+  QString mediaImgUrl;
+  QString mediaCommunity;
+  QList<QXmlStreamAttributes> linksList;
+  QList<bool> sourceLinksList;
+  QStringList parentsList;
+  QSet<QString> namedItems;
+
+  while (!xml.atEnd()) {
+    QXmlStreamReader::TokenType token = xml.readNext();
+    if (token == QXmlStreamReader::EndElement) {
+      if (parentsList.isEmpty()) break;
+      parentsList.removeLast();
+      continue;
+    }
+    if (token != QXmlStreamReader::StartElement)
+      continue;
+
+    QString name = xml.qualifiedName().toString();
+    if (name == "category") {
+      if (!newsItem.category.isEmpty()) newsItem.category.append(", ");
+      QString category = xml.attributes().value("label").toString();
+      if (category.isEmpty())
+        category = xml.attributes().value("term").toString();
+      newsItem.category.append(toPlainText(category));
+    } else if (name == "link") {
+      QString parentTagName = parentsList.isEmpty() ? QString("entry") : parentsList.last();
+      linksList.append(xml.attributes());
+      sourceLinksList.append(QString::compare(parentTagName, "source", Qt::CaseInsensitive) == 0);
+      feedLinks->append(xml.attributes());
+    }
+
+    if (!parentsList.isEmpty() || namedItems.contains(name)) {
+      parentsList.append(name);
+      continue;
+    }
+
+    namedItems.insert(name);
+    if (name == "id") {
+      newsItem.id = readElement(xml);
+    } else if (name == "title") {
+      newsItem.title = toPlainText(readElement(xml));
+    } else if (name == "published") {
+      published = readElement(xml);
+    } else if (name == "updated") {
+      updated = readElement(xml);
+    } else if (name == "issued") {
+      issued = readElement(xml);
+    } else if (name == "author") {
+      readAtomAuthor(xml, &newsItem.author, &newsItem.authorUri, &newsItem.authorEmail);
+    } else if (name == "summary") {
+      hasSummary = true;
+      newsItem.description = readElement(xml, &summaryXml);
+    } else if (name == "content") {
+      contentType = xml.attributes().value("type").toString();
+      newsItem.content = readElement(xml, &contentXml);
+    } else if (name == "media:community") {
+      community = readCommunity(xml);
+    } else if (name == "media:group") {
+      hasMediaGroup = true;
+      readMediaGroup(xml, &mediaDescription, &mediaImgUrl, &mediaCommunity);
+    } else {
+      if (name == "media:thumbnail") {
+        imgUrl = xml.attributes().value("url").toString();
+      } else if (name == "enclosure") {
+        newsItem.eUrl = xml.attributes().value("url").toString();
+        newsItem.eType = xml.attributes().value("type").toString();
+        newsItem.eLength = xml.attributes().value("length").toString();
+      }
+      parentsList.append(name);
+    }
+  }
+
+  newsItem.updated = published;
+  if (newsItem.updated.isEmpty())
+    newsItem.updated = updated;
+  if (newsItem.updated.isEmpty())
+    newsItem.updated = issued;
+  newsItem.updated = parseDate(newsItem.updated, feedUrl);
+
+  if (hasSummary && newsItem.description.isEmpty())
+    newsItem.description = summaryXml;
+  if (contentType == "xhtml")
+    newsItem.content = contentXml;
+  if (hasMediaGroup) {
+    if (mediaDescription.length() > newsItem.content.length())
+      newsItem.content = mediaDescription;
+    newsItem.content = fromPlainText(newsItem.content);
+    if (imgUrl.isEmpty())
+      imgUrl = mediaImgUrl;
+    if (community.isEmpty())
+      community = mediaCommunity;
+  }
+  if (!(newsItem.content.isEmpty() ||
+        (newsItem.description.length() > newsItem.content.length()))) {
+    newsItem.description = newsItem.content;
+  }
+  newsItem.content.clear();
+  if (!imgUrl.isEmpty()) {
+    newsItem.description = "<p class=\"description\">" + newsItem.description + "</p>";
+    newsItem.description += "<img src=\"" + imgUrl + "\" alt=\"image\"/>";
+  }
+  if (!community.isEmpty())
+    newsItem.description += community;
+
+  for (int j = 0; j < linksList.size(); j++) {
+    if (sourceLinksList.at(j))
+    {
+      continue;
+    }
+
+    if (linksList.at(j).value("type") == "text/html") {
+      if (linksList.at(j).value("rel") == "self")
+        newsItem.link = linksList.at(j).value("href").toString();
+      if (linksList.at(j).value("rel") == "alternate")
+        newsItem.linkAlternate = linksList.at(j).value("href").toString();
+      if (linksList.at(j).value("rel") == "replies")
+        newsItem.comments = linksList.at(j).value("href").toString();
+#if 1
+    } else if (newsItem.linkAlternate.isEmpty()) {
+#else
+    } else {
+#endif
+      if (linksList.at(j).value("rel") == "alternate")
+        newsItem.linkAlternate = linksList.at(j).value("href").toString();
+    }
+  }
+  for (int j = 0; j < linksList.size(); j++) {
+    if (newsItem.linkAlternate.isEmpty()) {
+      if (!(linksList.at(j).value("rel") == "self")) {
+        newsItem.linkAlternate = linksList.at(j).value("href").toString();
+        break;
+      }
+    }
+  }
+
+  return newsItem;
+}
+
+/** @brief Read Atom author from current element
+ *----------------------------------------------------------------------------*/
+void FeedParser::readAtomAuthor(QXmlStreamReader &xml, QString *name,
+                                 QString *uri, QString *email)
+{
+  QString text;
+  QString authorName;
+  QSet<QString> namedItems;
+
+  int depth = 0;
+  while (!xml.atEnd()) {
+    QXmlStreamReader::TokenType token = xml.readNext();
+    if (token == QXmlStreamReader::EndElement) {
+      if (--depth < 0) break;
+    } else if (token == QXmlStreamReader::StartElement) {
+      ++depth;
+      QString tagName = xml.qualifiedName().toString();
+      if ((depth != 1) || namedItems.contains(tagName))
+        continue;
+      namedItems.insert(tagName);
+      if ((tagName == "name") || (tagName == "uri") || (tagName == "email")) {
+        QString value = readElement(xml);
+        text.append(value);
+        --depth;
+        if (tagName == "name")
+          authorName = value;
+        else if (tagName == "uri")
+          *uri = value;
+        else
+          *email = value;
+      }
+    } else if (token == QXmlStreamReader::Characters) {
+      if (xml.isWhitespace() && !xml.isCDATA()) continue;
+      text.append(xml.text());
+    }
+  }
+
+  *name = toPlainText(authorName);
+  if (name->isEmpty()) *name = toPlainText(text);
+}
+
+void FeedParser::parseRss(const QString &feedUrl, QXmlStreamReader &xml)
+{
+  static const QStringList channelItemsList = QStringList()
+      << "title" << "rss:title" << "description" << "rss:description"
+      << "link" << "rss:link" << "pubDate" << "pubdate" << "author"
+      << "language" << "dc:language" << "ttl";
+
+  QHash<QString, QString> channels[2];  // "channel" and "rss:channel"
+  QList<NewsItemStruct> newsList[2];    // "item" and "rss:item"
+  int channelIndex = -1;
+  QStringList parentsList;
+  QSet<QString> namedItems;
+
+  while (!xml.atEnd()) {
+    QXmlStreamReader::TokenType token = xml.readNext();
+    if (token == QXmlStreamReader::EndElement) {
+      if (parentsList.isEmpty()) break;
+      parentsList.removeLast();
+      if (parentsList.isEmpty()) channelIndex = -1;
+      continue;
+    }
+    if (token != QXmlStreamReader::StartElement)
+      continue;
+
+    QString name = xml.qualifiedName().toString();
+    if (name == "item") {
+      newsList[0].append(readRssItem(feedUrl, xml));
+      continue;
+    } else if (name == "rss:item") {
+      newsList[1].append(readRssItem(feedUrl, xml));
+      continue;
+    }
+
+    if (parentsList.isEmpty()) {
+      if (!namedItems.contains(name)) {
+        namedItems.insert(name);
+        if (name == "channel")
+          channelIndex = 0;
+        else if (name == "rss:channel")
+          channelIndex = 1;
+      }
+    } else if ((parentsList.count() == 1) && (channelIndex != -1)) {
+      if (channelItemsList.contains(name) && !channels[channelIndex].contains(name)) {
+        channels[channelIndex].insert(name, readElement(xml));
+        continue;
+      }
+      if (((name == "skipHours") || (name == "skipDays")) &&
+          !channels[channelIndex].contains(name)) {
+        channels[channelIndex].insert(name, readElementList(xml).join(","));
+        continue;
+      }
+    }
+    parentsList.append(name);
+  }
+
+  const QHash<QString, QString> &channel = namedItems.contains("channel") ? channels[0] : channels[1];
+  FeedItemStruct feedItem;
+
+  feedItem.title = toPlainText(channel.value("title"));
+  if (feedItem.title.isEmpty())
+    feedItem.title = toPlainText(channel.value("rss:title"));
+  feedItem.description = channel.value("description");
+  if (feedItem.description.isEmpty())
+    feedItem.description = toPlainText(channel.value("rss:description"));
+  feedItem.link = toPlainText(channel.value("link"));
+  if (feedItem.link.isEmpty())
+    feedItem.link = toPlainText(channel.value("rss:link"));
+  QUrl url = QUrl(feedItem.link);
+  if (url.host().isEmpty())
+    url.setHost(QUrl(feedUrl).host());
+  if (url.scheme().isEmpty())
+    url.setScheme(QUrl(feedUrl).scheme());
+  feedItem.link = url.toString();
+
+  feedItem.updated = channel.value("pubDate");
+  if (feedItem.updated.isEmpty())
+    feedItem.updated = channel.value("pubdate");
+  feedItem.updated = parseDate(feedItem.updated, feedUrl);
+  feedItem.author = toPlainText(channel.value("author"));
+  feedItem.language = channel.value("language");
+  if (feedItem.language.isEmpty())
+    feedItem.language = channel.value("dc:language");
+  feedItem.ttl = channel.value("ttl").trimmed();
+  feedItem.skipHours = channel.value("skipHours");
+  feedItem.skipDays = channel.value("skipDays");
+
+  feedItem_ = feedItem;
+
+  newsList_ = newsList[0];
+  if (newsList_.isEmpty())
+    newsList_ = newsList[1];
+}
+
+/** @brief Read RSS item from current element
+ *----------------------------------------------------------------------------*/
+NewsItemStruct FeedParser::readRssItem(const QString &feedUrl, QXmlStreamReader &xml)
+{
+  static const QStringList itemItemsList = QStringList()
+      << "title" << "rss:title" << "pubDate" << "pubdate" << "dc:date"
+      << "author" << "dc:creator" << "link" << "rss:link" << "comments";
+
+  NewsItemStruct newsItem;
+  QHash<QString, QString> values;
+  bool isPermaLink = false;
+  QString descriptionXml;
+  bool hasDescription = false;
+  QString contentXml;
+  bool hasContent = false;
+  QString imgUrl;
+  QString community;
+  bool hasMediaGroup = false;
+  QString mediaDescription;
+  QString mediaImgUrl;
+  QString mediaCommunity;
+  QStringList parentsList;
+  QSet<QString> namedItems;
+
+  while (!xml.atEnd()) {
+    QXmlStreamReader::TokenType token = xml.readNext();
+    if (token == QXmlStreamReader::EndElement) {
+      if (parentsList.isEmpty()) break;
+      parentsList.removeLast();
+      continue;
+    }
+    if (token != QXmlStreamReader::StartElement)
+      continue;
+
+    QString name = xml.qualifiedName().toString();
+    if (name == "category") {
+      if (!newsItem.category.isEmpty()) newsItem.category.append(", ");
+      newsItem.category.append(toPlainText(readElement(xml)));
+      continue;
+    }
+
+    if (!parentsList.isEmpty() || namedItems.contains(name)) {
+      parentsList.append(name);
+      continue;
+    }
+
+    namedItems.insert(name);
+    if (name == "guid") {
+      isPermaLink = (xml.attributes().value("isPermaLink") == "true");
+      newsItem.id = readElement(xml);
+    } else if (name == "description") {
+      hasDescription = true;
+      newsItem.description = readElement(xml, &descriptionXml);
+    } else if (name == "content:encoded") {
+      hasContent = true;
+      newsItem.content = readElement(xml, &contentXml);
+    } else if (name == "media:community") {
+      community = readCommunity(xml);
+    } else if (name == "media:group") {
+      hasMediaGroup = true;
+      readMediaGroup(xml, &mediaDescription, &mediaImgUrl, &mediaCommunity);
+    } else if (itemItemsList.contains(name)) {
+      values.insert(name, readElement(xml));
+    } else {
+      if (name == "media:thumbnail") {
+        imgUrl = xml.attributes().value("url").toString();
+      } else if (name == "enclosure") {
+        newsItem.eUrl = xml.attributes().value("url").toString();
+        newsItem.eType = xml.attributes().value("type").toString();
+        newsItem.eLength = xml.attributes().value("length").toString();
+      }
+      parentsList.append(name);
+    }
+  }
+
+  newsItem.title = toPlainText(values.value("title"));
+  if (newsItem.title.isEmpty())
+    newsItem.title = toPlainText(values.value("rss:title"));
+  newsItem.updated = values.value("pubDate");
+  if (newsItem.updated.isEmpty())
+    newsItem.updated = values.value("pubdate");
+  if (newsItem.updated.isEmpty())
+    newsItem.updated = values.value("dc:date");
+  newsItem.updated = parseDate(newsItem.updated, feedUrl);
+  newsItem.author = toPlainText(values.value("author"));
+  if (newsItem.author.isEmpty())
+    newsItem.author = toPlainText(values.value("dc:creator"));
+  newsItem.link = toPlainText(values.value("link"));
+  if (newsItem.link.isEmpty()) {
+      newsItem.link = toPlainText(values.value("rss:link"));
+      if (newsItem.link.isEmpty()) {
+          if (isPermaLink)
+              newsItem.link = newsItem.id;
+      }
+  }
+  QUrl url = QUrl(newsItem.link);
+  if (url.host().isEmpty())
+    url.setHost(QUrl(feedUrl).host());
+  if (url.scheme().isEmpty())
+    url.setScheme(QUrl(feedUrl).scheme());
+  newsItem.link = url.toString();
+
+  if (hasDescription && newsItem.description.isEmpty())
+    newsItem.description = descriptionXml;
+  if (hasContent && newsItem.content.isEmpty())
+    newsItem.content = contentXml;
+  if (hasMediaGroup) {
+    if (mediaDescription.length() > newsItem.content.length())
+      newsItem.content = mediaDescription;
+    newsItem.content = fromPlainText(newsItem.content);
+    if (imgUrl.isEmpty())
+      imgUrl = mediaImgUrl;
+    if (community.isEmpty())
+      community = mediaCommunity;
+  }
+  if (!(newsItem.content.isEmpty() ||
+        (newsItem.description.length() > newsItem.content.length()))) {
+    newsItem.description = newsItem.content;
+  }
+  newsItem.content.clear();
+  if (!imgUrl.isEmpty()) {
+    newsItem.description = "<p class=\"description\">" + newsItem.description + "</p>";
+    newsItem.description += "<img src=\"" + imgUrl + "\" alt=\"image\"/>";
+  }
+  if (!community.isEmpty())
+    newsItem.description += community;
+
+  newsItem.comments = values.value("comments");
+
+  if (newsItem.title.isEmpty()) {
+    newsItem.title = toPlainText(newsItem.description);
+    if (newsItem.title.size() > 50) {
+      newsItem.title.resize(50);
+      newsItem.title = newsItem.title % "...";
+    }
+  }
+
+  return newsItem;
+}
+
+QString FeedParser::toPlainText(const QString &text)
+{
+  return QTextDocumentFragment::fromHtml(text).toPlainText().simplified();
+}
+
+QString FeedParser::fromPlainText(QString text)
+{
+  text = text.replace("\r\n", "<br>");
+  text = text.replace("\n", "<br>");
+  return text;
+}
+
+static void appendStartElement(QXmlStreamReader &xml, QString *xmlText)
+{
+  xmlText->append("<" % xml.qualifiedName());
+  foreach (const QXmlStreamNamespaceDeclaration &ns, xml.namespaceDeclarations()) {
+    if (ns.prefix().isEmpty())
+      xmlText->append(" xmlns=\"" % ns.namespaceUri() % "\"");
+    else
+      xmlText->append(" xmlns:" % ns.prefix() % "=\"" % ns.namespaceUri() % "\"");
+  }
+  foreach (const QXmlStreamAttribute &attr, xml.attributes()) {
+    xmlText->append(" " % attr.qualifiedName() % "=\"" %
+                    attr.value().toString().toHtmlEscaped() % "\"");
+  }
+  xmlText->append(">");
+}
+
+/** @brief Read text of current element including text of all its children
+ *
+ * Whitespace-only text is skipped the same way QDomDocument does.
+ * @param xmlText - If set, receives the element serialised as xml
+ *----------------------------------------------------------------------------*/
+QString FeedParser::readElement(QXmlStreamReader &xml, QString *xmlText)
+{
+  QString text;
+  if (xmlText) appendStartElement(xml, xmlText);
+
+  int depth = 0;
+  while (!xml.atEnd()) {
+    QXmlStreamReader::TokenType token = xml.readNext();
+    if (token == QXmlStreamReader::StartElement) {
+      ++depth;
+      if (xmlText) appendStartElement(xml, xmlText);
+    } else if (token == QXmlStreamReader::EndElement) {
+      if (xmlText) xmlText->append("</" % xml.qualifiedName() % ">");
+      if (--depth < 0) break;
+    } else if (token == QXmlStreamReader::Characters) {
+      if (xml.isWhitespace() && !xml.isCDATA()) continue;
+      text.append(xml.text());
+      if (xmlText) {
+        if (xml.isCDATA())
+          xmlText->append("<![CDATA[" % xml.text() % "]]>");
+        else
+          xmlText->append(xml.text().toString().toHtmlEscaped());
+      }
+    }
+  }
+  return text;
+}
+
+/** @brief Read texts of child elements of current element
+ *----------------------------------------------------------------------------*/
+QStringList FeedParser::readElementList(QXmlStreamReader &xml)
+{
+  QStringList list;
+  while (!xml.atEnd()) {
+    QXmlStreamReader::TokenType token = xml.readNext();
+    if (token == QXmlStreamReader::StartElement) {
+      QString text = readElement(xml).trimmed();
+      if (!text.isEmpty())
+        list.append(text);
+    } else if (token == QXmlStreamReader::EndElement) {
+      break;
+    }
+  }
+  return list;
+}
+
+/** @brief Read media:community from current element
+ *----------------------------------------------------------------------------*/
+QString FeedParser::readCommunity(QXmlStreamReader &xml)
+{
+  QString community;
+  QXmlStreamAttributes starRating;
+  QXmlStreamAttributes statistics;
+  QSet<QString> namedItems;
+
+  int depth = 0;
+  while (!xml.atEnd()) {
+    QXmlStreamReader::TokenType token = xml.readNext();
+    if (token == QXmlStreamReader::EndElement) {
+      if (--depth < 0) break;
+    } else if (token == QXmlStreamReader::StartElement) {
+      ++depth;
+      QString name = xml.qualifiedName().toString();
+      if ((depth != 1) || namedItems.contains(name))
+        continue;
+      namedItems.insert(name);
+      if (name == "media:starRating")
+        starRating = xml.attributes();
+      else if (name == "media:statistics")
+        statistics = xml.attributes();
+    }
+  }
+
+  QString count = starRating.value("count").toString();
+  QString average = starRating.value("average").toString();
+  QString min = starRating.value("min").toString();
+  QString max = starRating.value("max").toString();
+  QString views = statistics.value("views").toString();
+  if (!count.isEmpty())
+    community = QString("Count: %1, average: %2, min: %3, max: %4<br>").
+        arg(count).arg(average).arg(min).arg(max);
+  if (!views.isEmpty())
+    community += QString("Views: %1").arg(views);
+  if (!community.isEmpty())
+    community = "<p><i>" + community + "</i></p>";
+  return community;
+}
+
+/** @brief Read media:group from current element
+ *----------------------------------------------------------------------------*/
+void FeedParser::readMediaGroup(QXmlStreamReader &xml, QString *description,
+                                 QString *imgUrl, QString *community)
+{
+  QSet<QString> namedItems;
+
+  int depth = 0;
+  while (!xml.atEnd()) {
+    QXmlStreamReader::TokenType token = xml.readNext();
+    if (token == QXmlStreamReader::EndElement) {
+      if (--depth < 0) break;
+    } else if (token == QXmlStreamReader::StartElement) {
+      ++depth;
+      QString name = xml.qualifiedName().toString();
+      if ((depth != 1) || namedItems.contains(name))
+        continue;
+      namedItems.insert(name);
+      if (name == "media:description") {
+        *description = readElement(xml);
+        --depth;
+      } else if (name == "media:thumbnail") {
+        *imgUrl = xml.attributes().value("url").toString();
+      } else if (name == "media:community") {
+        *community = readCommunity(xml);
+        --depth;
+      }
+    }
+  }
+}
+
+/** @brief Date/time string parsing
+ *----------------------------------------------------------------------------*/
+QString FeedParser::parseDate(const QString &dateString, const QString &urlString)
+{
+  QDateTime dt;
+  QString temp;
+  QString timeZone;
+
+  if (dateString.isEmpty()) return QString();
+
+  QDateTime dtLocalTime = QDateTime::currentDateTime();
+  QDateTime dtUTC = QDateTime(dtLocalTime.date(), dtLocalTime.time(), Qt::UTC);
+  int nTimeShift = dtLocalTime.secsTo(dtUTC)/3600;
+
+  QString ds = dateString.simplified();
+  QLocale locale(QLocale::C);
+
+  if (ds.indexOf(',') != -1) {
+    ds = ds.remove(0, ds.indexOf(',')+1).simplified();
+  }
+
+  for (int i = 0; i < 2; i++, locale = QLocale::system()) {
+    temp     = ds.left(23);
+    timeZone = ds.mid(temp.length(), 3);
+    if (timeZone.isEmpty()) timeZone = QString::number(nTimeShift);
+    dt = locale.toDateTime(temp, "yyyy-MM-ddTHH:mm:ss.z");
+    if (dt.isValid()) return locale.toString(dt.addSecs(timeZone.toInt() * -3600), "yyyy-MM-ddTHH:mm:ss");
+
+    temp     = ds.left(19);
+    timeZone = ds.mid(temp.length(), 3);
+    if (timeZone.isEmpty()) timeZone = QString::number(nTimeShift);
+    dt = locale.toDateTime(temp, "yyyy-MM-ddTHH:mm:ss");
+    if (dt.isValid()) return locale.toString(dt.addSecs(timeZone.toInt() * -3600), "yyyy-MM-ddTHH:mm:ss");
+
+    temp = ds.left(23);
+    timeZone = ds.mid(temp.length()+1, 3);
+    if (timeZone.isEmpty()) timeZone = QString::number(nTimeShift);
+    dt = locale.toDateTime(temp, "yyyy-MM-dd HH:mm:ss.z");
+    if (dt.isValid()) return locale.toString(dt.addSecs(timeZone.toInt() * -3600), "yyyy-MM-ddTHH:mm:ss");
+
+    temp = ds.left(19);
+    timeZone = ds.mid(temp.length()+1, 3);
+    if (timeZone.isEmpty()) timeZone = QString::number(nTimeShift);
+    dt = locale.toDateTime(temp, "yyyy-MM-dd HH:mm:ss");
+    if (dt.isValid()) return locale.toString(dt.addSecs(timeZone.toInt() * -3600), "yyyy-MM-ddTHH:mm:ss");
+
+    temp = ds.left(20);
+    timeZone = ds.mid(temp.length()+1, 3);
+    if (timeZone.contains("EDT"))
+      timeZone="-4";
+    if (timeZone.isEmpty()) timeZone = QString::number(nTimeShift);
+    dt = locale.toDateTime(temp, "dd MMM yyyy HH:mm:ss");
+    if (dt.isValid()) return locale.toString(dt.addSecs(timeZone.toInt() * -3600), "yyyy-MM-ddTHH:mm:ss");
+
+    temp = ds.left(19);
+    timeZone = ds.mid(temp.length()+1, 3);
+    if (timeZone.isEmpty()) timeZone = QString::number(nTimeShift);
+    dt = locale.toDateTime(temp, "d MMM yyyy HH:mm:ss");
+    if (dt.isValid()) return locale.toString(dt.addSecs(timeZone.toInt() * -3600), "yyyy-MM-ddTHH:mm:ss");
+
+    temp = ds.left(11);
+    timeZone = ds.mid(temp.length()+1, 3);
+    if (timeZone.isEmpty()) timeZone = QString::number(nTimeShift);
+    dt = locale.toDateTime(temp, "dd MMM yyyy");
+    if (dt.isValid()) return locale.toString(dt.addSecs(timeZone.toInt() * -3600), "yyyy-MM-ddTHH:mm:ss");
+
+    temp = ds.left(10);
+    timeZone = ds.mid(temp.length()+1, 3);
+    if (timeZone.isEmpty()) timeZone = QString::number(nTimeShift);
+    dt = locale.toDateTime(temp, "d MMM yyyy");
+    if (dt.isValid()) return locale.toString(dt.addSecs(timeZone.toInt() * -3600), "yyyy-MM-ddTHH:mm:ss");
+
+    temp = ds.left(10);
+    timeZone = ds.mid(temp.length(), 3);
+    if (timeZone.isEmpty()) timeZone = QString::number(nTimeShift);
+    dt = locale.toDateTime(temp, "yyyy-MM-dd");
+    if (dt.isValid()) return locale.toString(dt.addSecs(timeZone.toInt() * -3600), "yyyy-MM-ddTHH:mm:ss");
+
+    // @HACK(arhohryakov:2012.01.01):
+    // "dd MMM yy HH:mm:ss" format doesn/t parse automatically
+    // Reformat it to "dd MMM yyyy HH:mm:ss"
+    QString temp2;
+    temp2 = ds;  // save ds for output in case of error
+    if (70 < ds.mid(7, 2).toInt()) temp2.insert(7, "19");
+    else temp2.insert(7, "20");
+    temp = temp2.left(20);
+    timeZone = ds.mid(temp.length()+1-2, 3);  // "-2", cause 2 symbols inserted
+    if (timeZone.isEmpty()) timeZone = QString::number(nTimeShift);
+    dt = locale.toDateTime(temp, "dd MMM yyyy HH:mm:ss");
+    if (dt.isValid()) return locale.toString(dt.addSecs(timeZone.toInt() * -3600), "yyyy-MM-ddTHH:mm:ss");
+  }
+
+  qDebug() << __LINE__ << "parseDate: error with" << dateString << urlString;
+  return QString();
+}
@@ -0,0 +1,85 @@
+#ifndef FEEDPARSER_H
+#define FEEDPARSER_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QXmlStreamReader>
+
+struct FeedItemStruct {
+  QString title;
+  QString updated;
+  QString link;
+  QString linkBase;
+  QString language;
+  QString author;
+  QString authorUri;
+  QString authorEmail;
+  QString description;
+  QString ttl;
+  QString skipHours;
+  QString skipDays;
+};
+
+struct NewsItemStruct {
+  QString id;
+  QString title;
+  QString updated;
+  QString link;
+  QString linkAlternate;
+  QString language;
+  QString author;
+  QString authorUri;
+  QString authorEmail;
+  QString description;
+  QString content;
+  QString category;
+  QString eUrl;
+  QString eType;
+  QString eLength;
+  QString comments;
+};
+
+/** @brief Read feed data (Atom, RSS 2.0, RSS 1.0) into feed and news items
+ *
+ * Data is read in a single pass with QXmlStreamReader, no DOM tree is built.
+ *----------------------------------------------------------------------------*/
+class FeedParser
+{
+public:
+  FeedParser();
+
+  bool parse(const QByteArray &xmlData, const QString &feedUrl,
+             const QString &codecName = QString());
+
+  QString feedType() const { return feedType_; }
+  FeedItemStruct feedItem() const { return feedItem_; }
+  QList<NewsItemStruct> newsList() const { return newsList_; }
+  QString errorString() const { return errorString_; }
+
+  static QString toPlainText(const QString &text);
+  static QString fromPlainText(QString text);
+  static QString parseDate(const QString &dateString, const QString &urlString);
+
+private:
+  void parseAtom(const QString &feedUrl, QXmlStreamReader &xml);
+  NewsItemStruct readAtomEntry(const QString &feedUrl, QXmlStreamReader &xml,
+                               QList<QXmlStreamAttributes> *feedLinks);
+  void readAtomAuthor(QXmlStreamReader &xml, QString *name,
+                      QString *uri, QString *email);
+  void parseRss(const QString &feedUrl, QXmlStreamReader &xml);
+  NewsItemStruct readRssItem(const QString &feedUrl, QXmlStreamReader &xml);
+  QString readElement(QXmlStreamReader &xml, QString *xmlText = 0);
+  QStringList readElementList(QXmlStreamReader &xml);
+  QString readCommunity(QXmlStreamReader &xml);
+  void readMediaGroup(QXmlStreamReader &xml, QString *description,
+                      QString *imgUrl, QString *community);
+
+  QString feedType_;
+  FeedItemStruct feedItem_;
+  QList<NewsItemStruct> newsList_;
+  QString errorString_;
+
+};
+
+#endif // FEEDPARSER_H
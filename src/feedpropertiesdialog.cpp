@@ -26,8 +26,8 @@ FeedPropertiesDialog::FeedPropertiesDialog(bool isFeed, QWidget *parent)
   buttonBox->addButton(QDialogButtonBox::Cancel);
   connect(buttonBox, SIGNAL(accepted()), this, SLOT(accept()));
 
-  connect(this, SIGNAL(signalLoadIcon(QString,QString)),
-          parent, SIGNAL(faviconRequestUrl(QString,QString)));
+  connect(this, SIGNAL(signalLoadIcon(QString,QString,bool)),
+          parent, SIGNAL(faviconRequestUrl(QString,QString,bool)));
   connect(parent, SIGNAL(signalIconFeedReady(QString,QByteArray)),
           this, SLOT(slotFaviconUpdate(QString,QByteArray)));
 }
@@ -447,7 +447,7 @@ void FeedPropertiesDialog::setDefaultTitle()
 
 void FeedPropertiesDialog::loadDefaultIcon()
 {
-  emit signalLoadIcon(feedProperties.general.homepage, feedProperties.general.url);
+  emit signalLoadIcon(feedProperties.general.homepage, feedProperties.general.url, true);
 }
 
 void FeedPropertiesDialog::selectIcon()
@@ -114,7 +114,7 @@ public slots:
   void slotFaviconUpdate(const QString &feedUrl, const QByteArray &faviconData);
 
 signals:
-  void signalLoadIcon(const QString &urlString, const QString &feedUrl);
+  void signalLoadIcon(const QString &urlString, const QString &feedUrl, bool force);
 
 protected:
   virtual void showEvent(QShowEvent *);
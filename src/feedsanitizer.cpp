@@ -0,0 +1,143 @@
+#include "feedsanitizer.h"
+
+namespace {
+
+const char kLineBreak[] = "<br>";
+const char *const kClosingTags[] = { "</rss>", "</feed>", "</rdf:RDF>" };
+const int kClosingTagsCount = sizeof(kClosingTags) / sizeof(kClosingTags[0]);
+
+inline bool isSpace(char c)
+{
+  return (c == ' ') || (c == '\t') || (c == '\n') || (c == '\v') ||
+      (c == '\f') || (c == '\r');
+}
+
+inline bool isEntityChar(char c)
+{
+  return ((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')) ||
+      ((c >= '0') && (c <= '9')) || (c == '#');
+}
+
+inline bool startsWith(const char *str, const QByteArray &prefix)
+{
+  for (int i = 0; i < prefix.size(); ++i) {
+    if (!str[i] || (str[i] != prefix.at(i)))
+      return false;
+  }
+  return true;
+}
+
+} // namespace
+
+FeedSanitizer::FeedSanitizer()
+  : started_(false)
+  , closed_(false)
+{
+}
+
+/** @brief Process next part of feed data
+ *----------------------------------------------------------------------------*/
+void FeedSanitizer::write(const QByteArray &data)
+{
+  process(data.constData(), data.size());
+}
+
+/** @brief Process end of feed data
+ * @return fixed feed data
+ *----------------------------------------------------------------------------*/
+QByteArray FeedSanitizer::finish()
+{
+  while (!pending_.isEmpty() && !closed_)
+    flushPending();
+
+  if (!closed_) {
+    int size = data_.size();
+    while ((size > 0) && isSpace(data_.at(size - 1)))
+      --size;
+    data_.truncate(size);
+  }
+
+  QByteArray data = data_;
+  data_.clear();
+  return data;
+}
+
+void FeedSanitizer::process(const char *data, int size)
+{
+  int i = 0;
+  while ((i < size) && !closed_) {
+    if (!started_) {
+      if (isSpace(data[i])) {
+        ++i;
+        continue;
+      }
+      started_ = true;
+    }
+
+    if (!pending_.isEmpty()) {
+      pending_.append(data[i++]);
+      resolvePending();
+      continue;
+    }
+
+    int start = i;
+    while ((i < size) && (data[i] != '&') && (data[i] != '<'))
+      ++i;
+    data_.append(data + start, i - start);
+    if (i < size)
+      pending_.append(data[i++]);
+  }
+}
+
+/** @brief Decide on pending '&' or '<' once next char has been added
+ *----------------------------------------------------------------------------*/
+void FeedSanitizer::resolvePending()
+{
+  char last = pending_.at(pending_.size() - 1);
+
+  if (pending_.at(0) == '&') {
+    if (isEntityChar(last))
+      return;
+    if ((last == ';') && (pending_.size() > 2)) {
+      data_.append(pending_);
+      pending_.clear();
+      return;
+    }
+  } else {
+    if (pending_ == kLineBreak) {
+      data_.append("<br/>");
+      pending_.clear();
+      return;
+    }
+
+    bool prefix = startsWith(kLineBreak, pending_);
+    for (int i = 0; i < kClosingTagsCount; ++i) {
+      if (pending_ == kClosingTags[i]) {
+        data_.append(pending_);
+        pending_.clear();
+        closed_ = true;
+        return;
+      }
+      if (startsWith(kClosingTags[i], pending_))
+        prefix = true;
+    }
+    if (prefix)
+      return;
+  }
+
+  flushPending();
+}
+
+/** @brief Output pending '&' or '<' as not special, reprocess chars after it
+ *----------------------------------------------------------------------------*/
+void FeedSanitizer::flushPending()
+{
+  if (pending_.at(0) == '&')
+    data_.append("&amp;");
+  else
+    data_.append('<');
+
+  QByteArray rest = pending_.mid(1);
+  pending_.clear();
+  process(rest.constData(), rest.size());
+}
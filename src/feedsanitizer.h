@@ -0,0 +1,32 @@
+#ifndef FEEDSANITIZER_H
+#define FEEDSANITIZER_H
+
+#include <QByteArray>
+
+/** @brief Fix common errors of feed data as it is received
+ *
+ * In one pass escapes '&' that does not start an entity, replaces "<br>"
+ * with "<br/>", drops leading whitespace and everything after the closing
+ * tag of the document (</rss>, </feed>, </rdf:RDF>).
+ *----------------------------------------------------------------------------*/
+class FeedSanitizer
+{
+public:
+  FeedSanitizer();
+
+  void write(const QByteArray &data);
+  QByteArray finish();
+
+private:
+  void process(const char *data, int size);
+  void resolvePending();
+  void flushPending();
+
+  QByteArray data_;
+  QByteArray pending_;  // '&' or '<' with following chars not decided yet
+  bool started_;
+  bool closed_;
+
+};
+
+#endif // FEEDSANITIZER_H
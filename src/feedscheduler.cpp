@@ -0,0 +1,272 @@
+#include "feedscheduler.h"
+
+#include <QDebug>
+#include <QRandomGenerator>
+#include <QStringList>
+#include <QtSql>
+
+#define ADAPTIVE_INTERVAL_MAX 86400  // sec
+#define SPREAD_INTERVAL_MAX 600      // sec
+#define TIMER_INTERVAL_MAX 300000    // ms
+
+namespace {
+
+const char kSelectFeedsQuery[] =
+    "SELECT id, updateIntervalEnable, updateInterval, updateIntervalType, "
+    "ttl, skipHours, skipDays, publishInterval, lastPublished, "
+    "cacheExpires, lastChecked, updated "
+    "FROM feeds WHERE xmlUrl!='' AND disableUpdate=0";
+
+/** @brief Convert stored timestamp, UTC if it has no offset
+ *----------------------------------------------------------------------------*/
+QDateTime toDateTimeUtc(const QVariant &value)
+{
+  QDateTime date = QDateTime::fromString(value.toString(), Qt::ISODate);
+  if (date.isValid() && (date.timeSpec() == Qt::LocalTime))
+    date.setTimeSpec(Qt::UTC);
+  return date.toUTC();
+}
+
+} // namespace
+
+FeedScheduler::FeedScheduler(QObject *parent)
+  : QObject(parent)
+  , initialized_(false)
+  , commonEnabled_(false)
+  , commonInterval_(0)
+{
+  timer_ = new QTimer(this);
+  timer_->setSingleShot(true);
+  connect(timer_, SIGNAL(timeout()), this, SLOT(slotTimeout()));
+}
+
+/** @brief Convert update interval of settings into seconds
+ * @param intervalType - 0 minutes, 1 hours, otherwise seconds
+ *----------------------------------------------------------------------------*/
+int FeedScheduler::intervalSec(int interval, int intervalType)
+{
+  if (intervalType == 0)
+    return interval*60;
+  else if (intervalType == 1)
+    return interval*60*60;
+  return interval;
+}
+
+/** @brief Set update interval of feeds which do not have their own
+ * @details Feeds are scheduled on first call even if interval is the same
+ *   as default one, as feeds with their own interval are to be updated too.
+ *----------------------------------------------------------------------------*/
+void FeedScheduler::setCommonInterval(bool enabled, int interval)
+{
+  if (initialized_ && (enabled == commonEnabled_) && (interval == commonInterval_))
+    return;
+
+  initialized_ = true;
+  commonEnabled_ = enabled;
+  commonInterval_ = interval;
+  reload();
+}
+
+/** @brief Schedule all feeds from base
+ * @details Next update is counted from last check of feed. Feeds that are overdue
+ *   are spread over some time instead of being updated all at once.
+ *----------------------------------------------------------------------------*/
+void FeedScheduler::reload()
+{
+  queue_.clear();
+  dueTimes_.clear();
+
+  QDateTime currentDate = QDateTime::currentDateTimeUtc();
+  QSqlQuery q;
+  q.setForwardOnly(true);
+  if (!q.exec(kSelectFeedsQuery)) {
+    qWarning() << __PRETTY_FUNCTION__ << __LINE__
+               << "q.lastError(): " << q.lastError().text();
+  }
+  while (q.next()) {
+    FeedSchedule feed;
+    if (!readFeed(q, &feed))
+      continue;
+
+    QDateTime due;
+    if (feed.lastChecked.isValid())
+      due = nextUpdate(feed, feed.lastChecked);
+    if (!due.isValid() || (due < currentDate)) {
+      int spread = qMin(feed.interval, SPREAD_INTERVAL_MAX);
+      due = currentDate.addSecs(QRandomGenerator::global()->bounded(spread + 1));
+    }
+    schedule(q.value(0).toInt(), due);
+  }
+
+  qDebug() << "Feeds scheduled for update:" << queue_.count();
+  startTimer();
+}
+
+/** @brief Schedule next update of feed after it has been updated or
+ *   its properties have been changed
+ *----------------------------------------------------------------------------*/
+void FeedScheduler::updateFeed(int feedId)
+{
+  FeedSchedule feed;
+  if (!loadFeed(feedId, &feed)) {
+    removeFeed(feedId);
+    return;
+  }
+
+  schedule(feedId, nextUpdate(feed, QDateTime::currentDateTimeUtc()));
+  startTimer();
+}
+
+void FeedScheduler::removeFeed(int feedId)
+{
+  if (!dueTimes_.contains(feedId))
+    return;
+
+  queue_.remove(dueTimes_.take(feedId), feedId);
+  startTimer();
+}
+
+/** @brief Request update of feeds which are due
+ *----------------------------------------------------------------------------*/
+void FeedScheduler::slotTimeout()
+{
+  QDateTime currentDate = QDateTime::currentDateTimeUtc();
+  qint64 currentTime = currentDate.toMSecsSinceEpoch();
+
+  while (!queue_.isEmpty() && (queue_.firstKey() <= currentTime)) {
+    int feedId = queue_.first();
+    queue_.erase(queue_.begin());
+    dueTimes_.remove(feedId);
+
+    // Feed has been deleted or does not need updates anymore
+    FeedSchedule feed;
+    if (!loadFeed(feedId, &feed))
+      continue;
+
+    // Rescheduled when update is finished, kept here if it never is
+    schedule(feedId, nextUpdate(feed, currentDate));
+    emit signalGetFeed(feedId);
+  }
+
+  startTimer();
+}
+
+/** @brief Fill \a feed from row of kSelectFeedsQuery
+ * @return false if feed is not updated automatically
+ *----------------------------------------------------------------------------*/
+bool FeedScheduler::readFeed(const QSqlQuery &q, FeedSchedule *feed) const
+{
+  int updateIntervalEnable = q.value(1).isNull() ? -1 : q.value(1).toInt();
+  if (updateIntervalEnable == 1) {
+    feed->interval = intervalSec(q.value(2).toInt(), q.value(3).toInt());
+    feed->adaptive = false;
+  } else if ((updateIntervalEnable == -1) && commonEnabled_) {
+    feed->interval = commonInterval_;
+    feed->adaptive = true;
+  } else {
+    return false;
+  }
+  if (feed->interval <= 0)
+    return false;
+
+  feed->ttl = q.value(4).toInt();
+
+  feed->skipHours.clear();
+  foreach (const QString &hour, q.value(5).toString().split(',', Qt::SkipEmptyParts)) {
+    bool ok;
+    int value = hour.trimmed().toInt(&ok);
+    if (ok && (value >= 0) && (value <= 24))
+      feed->skipHours.insert(value % 24);
+  }
+
+  static const QStringList daysList = QStringList()
+      << "monday" << "tuesday" << "wednesday" << "thursday"
+      << "friday" << "saturday" << "sunday";
+  feed->skipDays.clear();
+  foreach (const QString &day, q.value(6).toString().split(',', Qt::SkipEmptyParts)) {
+    int index = daysList.indexOf(day.trimmed().toLower());
+    if (index != -1)
+      feed->skipDays.insert(index + 1);
+  }
+
+  feed->publishInterval = q.value(7).toLongLong();
+  feed->lastPublished = toDateTimeUtc(q.value(8));
+  feed->cacheExpires = toDateTimeUtc(q.value(9));
+  // Feeds not checked since DB upgrade fall back to last parsed data
+  feed->lastChecked = toDateTimeUtc(q.value(10));
+  if (!feed->lastChecked.isValid())
+    feed->lastChecked = toDateTimeUtc(q.value(11));
+  return true;
+}
+
+bool FeedScheduler::loadFeed(int feedId, FeedSchedule *feed) const
+{
+  QSqlQuery q;
+  q.setForwardOnly(true);
+  q.prepare(QString("%1 AND id=?").arg(kSelectFeedsQuery));
+  q.addBindValue(feedId);
+  q.exec();
+  if (!q.first())
+    return false;
+  return readFeed(q, feed);
+}
+
+/** @brief Time of next update of feed updated at \a from
+ *----------------------------------------------------------------------------*/
+QDateTime FeedScheduler::nextUpdate(const FeedSchedule &feed, const QDateTime &from) const
+{
+  qint64 interval = feed.interval;
+  if (!feed.adaptive)
+    return from.addSecs(interval);
+
+  qint64 intervalMax = qMax(interval, qint64(ADAPTIVE_INTERVAL_MAX));
+
+  // Poll about twice per publish interval, and more rarely as long as
+  // feed stays quiet
+  if (feed.lastPublished.isValid()) {
+    qint64 publishInterval = qMax(feed.publishInterval,
+                                  feed.lastPublished.secsTo(from));
+    interval = qBound(interval, publishInterval / 2, intervalMax);
+  }
+  interval = qBound(interval, qint64(feed.ttl) * 60, intervalMax);
+
+  // Feeds updated together drift apart
+  interval += QRandomGenerator::global()->bounded(int(interval / 10) + 1);
+
+  QDateTime due = from.addSecs(interval);
+  if (feed.cacheExpires.isValid() && (due < feed.cacheExpires))
+    due = qMin(feed.cacheExpires, from.addSecs(intervalMax));
+
+  // Skipped hours and days are moved to start of next allowed hour
+  for (int i = 0; i < 24*7; ++i) {
+    if (!feed.skipHours.contains(due.time().hour()) &&
+        !feed.skipDays.contains(due.date().dayOfWeek()))
+      break;
+    due = QDateTime(due.date(), QTime(due.time().hour(), 0), Qt::UTC).addSecs(60*60);
+  }
+  return due;
+}
+
+void FeedScheduler::schedule(int feedId, const QDateTime &due)
+{
+  if (dueTimes_.contains(feedId))
+    queue_.remove(dueTimes_.value(feedId), feedId);
+
+  qint64 time = due.toMSecsSinceEpoch();
+  dueTimes_.insert(feedId, time);
+  queue_.insert(time, feedId);
+}
+
+/** @brief Wake up when first feed in queue is due
+ * @details Timer is limited to recheck queue after sleep or clock change.
+ *----------------------------------------------------------------------------*/
+void FeedScheduler::startTimer()
+{
+  if (queue_.isEmpty()) {
+    timer_->stop();
+    return;
+  }
+
+  qint64 delay = queue_.firstKey() - QDateTime::currentMSecsSinceEpoch();
+  timer_->start(int(qBound(qint64(0), delay, qint64(TIMER_INTERVAL_MAX))));
+}
@@ -0,0 +1,68 @@
+#ifndef FEEDSCHEDULER_H
+#define FEEDSCHEDULER_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QMap>
+#include <QObject>
+#include <QSet>
+#include <QTimer>
+
+class QSqlQuery;
+
+/** @brief Decide when every feed is to be updated automatically
+ *
+ * Feeds wait in a queue ordered by due time, and the timer is started only
+ * for the first of them. Feeds with their own update interval are updated
+ * exactly with it. Feeds using the common interval are updated not more
+ * often than it, but less often when they publish rarely or ask for it with
+ * ttl, skipHours, skipDays or HTTP cache headers.
+ *----------------------------------------------------------------------------*/
+class FeedScheduler : public QObject
+{
+  Q_OBJECT
+public:
+  explicit FeedScheduler(QObject *parent = 0);
+
+  static int intervalSec(int interval, int intervalType);
+
+  void setCommonInterval(bool enabled, int interval);
+  void reload();
+  void updateFeed(int feedId);
+  void removeFeed(int feedId);
+
+signals:
+  void signalGetFeed(int feedId);
+
+private slots:
+  void slotTimeout();
+
+private:
+  struct FeedSchedule {
+    int interval;         // sec
+    bool adaptive;        // common interval is used
+    int ttl;              // min
+    QSet<int> skipHours;  // 0..23, UTC
+    QSet<int> skipDays;   // 1..7, Monday first
+    qint64 publishInterval;  // sec
+    QDateTime lastPublished;
+    QDateTime cacheExpires;
+    QDateTime lastChecked;
+  };
+
+  bool readFeed(const QSqlQuery &q, FeedSchedule *feed) const;
+  bool loadFeed(int feedId, FeedSchedule *feed) const;
+  QDateTime nextUpdate(const FeedSchedule &feed, const QDateTime &from) const;
+  void schedule(int feedId, const QDateTime &due);
+  void startTimer();
+
+  QTimer *timer_;
+  bool initialized_;  // feeds have been scheduled
+  bool commonEnabled_;
+  int commonInterval_;
+  QMultiMap<qint64, int> queue_;  // due time (ms since epoch) -> feed id
+  QHash<int, qint64> dueTimes_;
+
+};
+
+#endif // FEEDSCHEDULER_H
@@ -2,29 +2,54 @@
 #include "feedsproxymodel.h"
 
 #include <QtCore>
+#include <QCryptographicHash>
 #include <QPainter>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+
+namespace {
+
+// Columns painted in tree or used to filter it. Other columns of feed are
+// read one by one the first time they are needed, its image is not kept.
+const char *const kTreeColumns[] = {
+  "id", "text", "xmlUrl", "parentId", "rowToParent", "unread", "newCount",
+  "undeleteCount", "updated", "status", "disableUpdate"
+};
+const int kTreeColumnsCount = sizeof(kTreeColumns) / sizeof(kTreeColumns[0]);
+
+} // namespace
 
 FeedsModel::FeedsModel(QObject *parent)
   : QAbstractItemModel(parent)
   , defaultIconFeeds_(false)
   , view_(0)
   , rootParentId_(0)
+  , folderIcon_(":/images/folder")
+  , feedIcon_(":/images/feed")
+  , errorBullet_(":/images/bulletError")
+  , updateBullet_(":/images/bulletUpdate")
 {
   setObjectName("FeedsModel");
 
+  rootItem_ = new UserData(rootParentId_, -1, QSqlRecord());
+
   refresh();
 }
 
 FeedsModel::~FeedsModel()
 {
   clear();
+  delete rootItem_;
 }
 
 void FeedsModel::clear()
 {
-  id2RowList_.clear();
-  parid2RowList_.clear();
+  rootItem_->children.clear();
   columnsList_.clear();
+  iconHashes_.clear();
+  iconUsers_.clear();
+  icons_.clear();
+  statusIcons_.clear();
 
   qDeleteAll(userDataList_);
   userDataList_.clear();
@@ -34,27 +59,88 @@ void FeedsModel::refresh()
 {
   beginResetModel();
   clear();
-  endResetModel();
-
-  queryModel_.setQuery("SELECT * FROM feeds ORDER BY parentId, rowToParent");
-  while (queryModel_.canFetchMore())
-    queryModel_.fetchMore();
 
-  indexId_ = queryModel_.record().indexOf("id");
-  indexParid_ = queryModel_.record().indexOf("parentId");
-  for (int i = 0; i < queryModel_.record().count(); i++) {
+  record_ = QSqlDatabase::database().record("feeds");
+  treeColumns_.clear();
+  QStringList columnsList;
+  for (int i = 0; i < kTreeColumnsCount; ++i) {
+    treeColumns_.append(record_.indexOf(kTreeColumns[i]));
+    columnsList.append(kTreeColumns[i]);
+  }
+  treeColumnsStr_ = columnsList.join(", ");
+
+  indexId_ = record_.indexOf("id");
+  indexParid_ = record_.indexOf("parentId");
+  indexRowToParent_ = record_.indexOf("rowToParent");
+  indexImage_ = record_.indexOf("image");
+  indexXmlUrl_ = record_.indexOf("xmlUrl");
+  for (int i = 0; i < record_.count(); i++) {
     columnsList_[i] = i;
   }
-  columnsList_[0] = queryModel_.record().indexOf("text");
-  columnsList_[queryModel_.record().indexOf("text")] = 0;
-
-  for (int i = 0; i < queryModel_.rowCount(); i++) {
-    int id = queryModel_.record(i).value(indexId_).toInt();
-    id2RowList_[id] = i;
-    int parid = queryModel_.record(i).value(indexParid_).toInt();
-    parid2RowList_[i] = parid;
-    userDataList_[id] = new UserData(id, parid, queryModel_.record(i));
+  columnsList_[0] = record_.indexOf("text");
+  columnsList_[record_.indexOf("text")] = 0;
+
+  QList<UserData*> itemsList;
+  QSqlQuery q;
+  q.setForwardOnly(true);
+  q.exec(QString("SELECT %1 FROM feeds ORDER BY parentId, rowToParent").
+         arg(treeColumnsStr_));
+  while (q.next()) {
+    QSqlRecord record = treeRecord(q);
+    int id = record.value(indexId_).toInt();
+    int parid = record.value(indexParid_).toInt();
+    UserData *userData = new UserData(id, parid, record);
+    userDataList_[id] = userData;
+    itemsList.append(userData);
+  }
+
+  // Parent folder may follow its children in query
+  foreach (UserData *userData, itemsList) {
+    UserData *parentItem = (userData->parid == rootParentId_) ?
+          rootItem_ : userDataById(userData->parid);
+    if (!parentItem)
+      continue;
+    userData->parent = parentItem;
+    userData->row = parentItem->children.count();
+    parentItem->children.append(userData);
+  }
+
+  endResetModel();
+}
+
+/** @brief Record of item from row of query selecting tree columns
+ *---------------------------------------------------------------------------*/
+QSqlRecord FeedsModel::treeRecord(const QSqlQuery &q) const
+{
+  QSqlRecord record = record_;
+  for (int i = 0; i < treeColumns_.count(); ++i) {
+    record.setValue(treeColumns_.at(i), q.value(i));
+  }
+  return record;
+}
+
+/** @brief Value of item column, column not in tree is read when it is needed
+ * @details Only the asked column is read. Image of feed is read every time,
+ *   it is not kept in item, decoded icons are cached by their hash.
+ *---------------------------------------------------------------------------*/
+QVariant FeedsModel::fieldValue(UserData *userData, int column) const
+{
+  if ((column < 0) || treeColumns_.contains(column) || userData->loaded.contains(column))
+    return userData->record.value(column);
+
+  QVariant value;
+  QSqlQuery q;
+  q.prepare(QString("SELECT %1 FROM feeds WHERE id=?").arg(record_.fieldName(column)));
+  q.addBindValue(userData->id);
+  q.exec();
+  if (q.first())
+    value = q.value(0);
+
+  if (column != indexImage_) {
+    userData->record.setValue(column, value);
+    userData->loaded.insert(column);
   }
+  return value;
 }
 
 UserData * FeedsModel::userDataById(int id) const
@@ -62,45 +148,48 @@ UserData * FeedsModel::userDataById(int id) const
   return userDataList_.value(id, 0);
 }
 
-int FeedsModel::rowById(int id) const
+UserData * FeedsModel::itemByIndex(const QModelIndex &index) const
+{
+  if (index.isValid())
+    return static_cast<UserData*>(index.internalPointer());
+  return rootItem_;
+}
+
+QModelIndex FeedsModel::indexOfItem(UserData *userData) const
 {
-  return id2RowList_.value(id, -1);
+  if (!userData || (userData == rootItem_) || !userData->parent)
+    return QModelIndex();
+  return createIndex(userData->row, 0, userData);
 }
 
-int FeedsModel::rowByParid(int parid) const
+/** @brief Renumber children of item starting from \a first
+ *---------------------------------------------------------------------------*/
+void FeedsModel::updateRows(UserData *parentItem, int first)
 {
-  return parid2RowList_.key(parid, -1);
+  for (int i = first; i < parentItem->children.count(); ++i) {
+    UserData *userData = parentItem->children.at(i);
+    userData->row = i;
+    userData->record.setValue(indexRowToParent_, i);
+  }
 }
 
 int FeedsModel::rowCount(const QModelIndex &parent) const
 {
-  if (parent.isValid())
-    return parid2RowList_.keys(idByIndex(parent)).count();
-  else
-    return parid2RowList_.keys(rootParentId_).count();
+  return itemByIndex(parent)->children.count();
 }
 
 int FeedsModel::columnCount(const QModelIndex&) const
 {
-  return queryModel_.record().count();
+  return record_.count();
 }
 
 QModelIndex FeedsModel::index(int row, int column, const QModelIndex &parent) const
 {
-  if (row == -1)
+  UserData *parentItem = itemByIndex(parent);
+  if ((row < 0) || (row >= parentItem->children.count()))
     return QModelIndex();
 
-  int id = 0;
-  if (parent.isValid())
-    id = id2RowList_.key(row + rowByParid(idByIndex(parent)), 0);
-  else
-    id = id2RowList_.key(row, 0);
-
-  UserData *userData = userDataById(id);
-  if (userData)
-    return createIndex(row, column, userData);
-  else
-    return QModelIndex();
+  return createIndex(row, column, parentItem->children.at(row));
 }
 
 QModelIndex FeedsModel::parent(const QModelIndex &index) const
@@ -108,17 +197,7 @@ QModelIndex FeedsModel::parent(const QModelIndex &index) const
   if (!index.isValid())
     return QModelIndex();
 
-  int parid = paridByIndex(index);
-  if (parid == rootParentId_)
-    return QModelIndex();
-
-  UserData *userData = userDataById(parid);
-  if (userData) {
-    int row = rowById(parid) - rowByParid(userData->parid);
-    return createIndex(row, 0, userData);
-  } else {
-    return QModelIndex();
-  }
+  return indexOfItem(static_cast<UserData*>(index.internalPointer())->parent);
 }
 
 QVariant FeedsModel::data(const QModelIndex &index, int role) const
@@ -198,46 +277,14 @@ QVariant FeedsModel::data(const QModelIndex &index, int role) const
     }
   } else if (role == Qt::DecorationRole) {
     if (indexColumnOf("text") == index.column()) {
-      if (isFolder(index)) {
-        return QPixmap(":/images/folder");
-      } else {
-        if (!defaultIconFeeds_) {
-          QByteArray byteArray = indexSibling(index, "image").data(Qt::EditRole).toByteArray();
-          if (!byteArray.isNull()) {
-            QImage resultImage;
-            if (resultImage.loadFromData(QByteArray::fromBase64(byteArray))) {
-              QString strStatus = indexSibling(index, "status").data(Qt::EditRole).toString();
-              if (strStatus.section(" ", 0, 0).toInt() != 0) {
-                QImage image;
-                if (strStatus.section(" ", 0, 0).toInt() < 0)
-                  image.load(":/images/bulletError");
-                else if (strStatus.section(" ", 0, 0).toInt() == 1)
-                  image.load(":/images/bulletUpdate");
-                QPainter resultPainter(&resultImage);
-                resultPainter.setCompositionMode(QPainter::CompositionMode_SourceOver);
-                resultPainter.drawImage(0, 0, image);
-                resultPainter.end();
-              }
-              return resultImage;
-            }
-          }
-        }
-        QImage resultImage(":/images/feed");
-        QString strStatus = indexSibling(index, "status").data(Qt::EditRole).toString();
-        if (strStatus.section(" ", 0, 0).toInt() != 0) {
-          QImage image;
-          if (strStatus.section(" ", 0, 0).toInt() < 0)
-            image.load(":/images/bulletError");
-          else if (strStatus.section(" ", 0, 0).toInt() == 1)
-            image.load(":/images/bulletUpdate");
-
-          QPainter resultPainter(&resultImage);
-          resultPainter.setCompositionMode(QPainter::CompositionMode_SourceOver);
-          resultPainter.drawImage(0, 0, image);
-          resultPainter.end();
-        }
-        return resultImage;
-      }
+      if (isFolder(index))
+        return folderIcon_;
+
+      QByteArray hash;
+      if (!defaultIconFeeds_)
+        hash = iconHash(static_cast<UserData*>(index.internalPointer()));
+      QString strStatus = indexSibling(index, "status").data(Qt::EditRole).toString();
+      return statusIcon(hash, strStatus.section(" ", 0, 0).toInt());
     }
   } else if (role == Qt::TextAlignmentRole) {
     if (indexColumnOf("id") == index.column()) {
@@ -263,8 +310,8 @@ QVariant FeedsModel::data(const QModelIndex &index, int role) const
   if (!((role == Qt::EditRole) || (role == Qt::DisplayRole)))
     return QVariant();
 
-  QSqlRecord record = static_cast<UserData*>(index.internalPointer())->record;
-  return record.value(indexColumnOf(index.column()));
+  return fieldValue(static_cast<UserData*>(index.internalPointer()),
+                    indexColumnOf(index.column()));
 }
 
 bool FeedsModel::setData(const QModelIndex &index, const QVariant &value, int)
@@ -272,8 +319,15 @@ bool FeedsModel::setData(const QModelIndex &index, const QVariant &value, int)
   if (!index.isValid())
     return false;
 
-  QSqlRecord *record = &static_cast<UserData*>(index.internalPointer())->record;
-  record->setValue(indexColumnOf(index.column()), value);
+  UserData *userData = static_cast<UserData*>(index.internalPointer());
+  int column = indexColumnOf(index.column());
+  if (column == indexImage_) {
+    invalidateIcon(userData->id);
+    return true;
+  }
+  userData->record.setValue(column, value);
+  if (!treeColumns_.contains(column))
+    userData->loaded.insert(column);
   return true;
 }
 
@@ -294,15 +348,7 @@ Qt::DropActions FeedsModel::supportedDropActions() const
 
 QModelIndex FeedsModel::indexById(int id) const
 {
-  QModelIndex parentIndex = QModelIndex();
-  UserData *userData = userDataById(id);
-  if (userData)
-    parentIndex = indexById(userData->parid);
-  for (int i = 0; i < rowCount(parentIndex); i++) {
-    if (idByIndex(index(i, 0, parentIndex)) == id)
-      return index(i,0,parentIndex);
-  }
-  return QModelIndex();
+  return indexOfItem(userDataById(id));
 }
 
 int FeedsModel::idByIndex(const QModelIndex &index) const
@@ -319,6 +365,350 @@ int FeedsModel::paridByIndex(const QModelIndex &index) const
   return 0;
 }
 
+/** @brief Add item which has been added to DB
+ * @return index of item, invalid if it is not found or has no parent
+ *---------------------------------------------------------------------------*/
+QModelIndex FeedsModel::insertItem(int id)
+{
+  if (userDataById(id))
+    return indexById(id);
+
+  QSqlQuery q;
+  q.prepare(QString("SELECT %1 FROM feeds WHERE id=?").arg(treeColumnsStr_));
+  q.addBindValue(id);
+  q.exec();
+  if (!q.first())
+    return QModelIndex();
+
+  QSqlRecord record = treeRecord(q);
+  int parid = record.value(indexParid_).toInt();
+  UserData *userData = new UserData(id, parid, record);
+  userDataList_.insert(id, userData);
+
+  UserData *parentItem = (parid == rootParentId_) ? rootItem_ : userDataById(parid);
+  if (!parentItem)
+    return QModelIndex();
+
+  int row = qBound(0, record.value(indexRowToParent_).toInt(),
+                   parentItem->children.count());
+  beginInsertRows(indexOfItem(parentItem), row, row);
+  userData->parent = parentItem;
+  parentItem->children.insert(row, userData);
+  updateRows(parentItem, row);
+  endInsertRows();
+
+  return indexOfItem(userData);
+}
+
+/** @brief Reload items which have been changed in DB
+ * @details Only tree columns are read again, other columns are read when
+ *   needed. New items are inserted, deleted ones are removed, and moved
+ *   ones are moved. Items are to be in order they were added to DB.
+ *---------------------------------------------------------------------------*/
+void FeedsModel::updateItems(const QList<int> &idList)
+{
+  QList<int> movedList;
+  QSqlQuery q;
+
+  foreach (int id, idList) {
+    UserData *userData = userDataById(id);
+    if (!userData) {
+      insertItem(id);
+      continue;
+    }
+
+    q.prepare(QString("SELECT %1 FROM feeds WHERE id=?").arg(treeColumnsStr_));
+    q.addBindValue(id);
+    q.exec();
+    if (!q.first()) {
+      removeItem(id);
+      continue;
+    }
+
+    QSqlRecord record = treeRecord(q);
+    if ((record.value(indexParid_).toInt() != userData->parid) ||
+        (record.value(indexRowToParent_).toInt() != userData->row)) {
+      movedList.append(id);
+    }
+    // Parent and row are changed when item is moved
+    foreach (int column, treeColumns_) {
+      if ((column != indexParid_) && (column != indexRowToParent_))
+        userData->record.setValue(column, record.value(column));
+    }
+    userData->loaded.clear();
+
+    QModelIndex index = indexOfItem(userData);
+    if (index.isValid()) {
+      emit dataChanged(index, this->index(index.row(), columnCount() - 1, index.parent()));
+    }
+  }
+
+  if (!movedList.isEmpty())
+    moveItems(movedList);
+}
+
+/** @brief Remove item and its children which have been deleted from DB
+ *---------------------------------------------------------------------------*/
+void FeedsModel::removeItem(int id)
+{
+  UserData *userData = userDataById(id);
+  if (!userData)
+    return;
+
+  UserData *parentItem = userData->parent;
+  if (parentItem) {
+    int row = userData->row;
+    beginRemoveRows(indexOfItem(parentItem), row, row);
+    parentItem->children.removeAt(row);
+    userData->parent = 0;
+    updateRows(parentItem, row);
+    endRemoveRows();
+  }
+
+  deleteItem(userData);
+}
+
+void FeedsModel::deleteItem(UserData *userData)
+{
+  foreach (UserData *child, userData->children) {
+    deleteItem(child);
+  }
+  userDataList_.remove(userData->id);
+  invalidateIcon(userData->id);
+  delete userData;
+}
+
+/** @brief Move items to parent and row they have in DB
+ * @details Siblings are reordered as in DB too, so it is enough to pass
+ *   items whose parent has been changed or which have been moved.
+ *---------------------------------------------------------------------------*/
+void FeedsModel::moveItems(const QList<int> &idList)
+{
+  QList<UserData*> parentsList;
+  QSqlQuery q;
+
+  foreach (int id, idList) {
+    UserData *userData = userDataById(id);
+    if (!userData || !userData->parent)
+      continue;
+
+    q.prepare("SELECT parentId FROM feeds WHERE id=?");
+    q.addBindValue(id);
+    q.exec();
+    if (!q.first())
+      continue;
+
+    int parid = q.value(0).toInt();
+    UserData *parentItem = (parid == rootParentId_) ? rootItem_ : userDataById(parid);
+    if (!parentItem)
+      continue;
+
+    if (!parentsList.contains(userData->parent))
+      parentsList.append(userData->parent);
+    if (!parentsList.contains(parentItem))
+      parentsList.append(parentItem);
+
+    if (parentItem != userData->parent) {
+      moveItem(userData, parentItem, parentItem->children.count());
+      if (userData->parent == parentItem) {
+        userData->parid = parid;
+        userData->record.setValue(indexParid_, parid);
+      }
+    }
+  }
+
+  foreach (UserData *parentItem, parentsList) {
+    q.prepare("SELECT id FROM feeds WHERE parentId=? ORDER BY rowToParent");
+    q.addBindValue(parentItem->id);
+    q.exec();
+    int row = 0;
+    while (q.next() && (row < parentItem->children.count())) {
+      UserData *userData = userDataById(q.value(0).toInt());
+      if (!userData || (userData->parent != parentItem))
+        continue;
+      if (userData->row != row)
+        moveItem(userData, parentItem, row);
+      ++row;
+    }
+    updateRows(parentItem, 0);
+  }
+}
+
+/** @brief Move item to \a row of \a parentItem notifying views
+ *---------------------------------------------------------------------------*/
+void FeedsModel::moveItem(UserData *userData, UserData *parentItem, int row)
+{
+  // Folder can not be moved into itself
+  for (UserData *item = parentItem; item; item = item->parent) {
+    if (item == userData)
+      return;
+  }
+
+  UserData *oldParentItem = userData->parent;
+  int oldRow = userData->row;
+  int destinationRow = row;
+  if ((oldParentItem == parentItem) && (row > oldRow))
+    ++destinationRow;
+
+  if (!beginMoveRows(indexOfItem(oldParentItem), oldRow, oldRow,
+                     indexOfItem(parentItem), destinationRow))
+    return;
+
+  oldParentItem->children.removeAt(oldRow);
+  parentItem->children.insert(qMin(row, parentItem->children.count()), userData);
+  userData->parent = parentItem;
+  updateRows(oldParentItem, 0);
+  if (parentItem != oldParentItem)
+    updateRows(parentItem, 0);
+
+  endMoveRows();
+}
+
+/** @brief Decoded icon of feed or folder
+ * @return default icon if feed has no image, null if there is no such id
+ *---------------------------------------------------------------------------*/
+QPixmap FeedsModel::iconById(int id) const
+{
+  UserData *userData = userDataById(id);
+  if (!userData)
+    return QPixmap();
+  if (userData->record.value(indexXmlUrl_).toString().isEmpty())
+    return folderIcon_;
+
+  QByteArray hash = iconHash(userData);
+  if (hash.isEmpty())
+    return feedIcon_;
+  return icons_.value(hash);
+}
+
+/** @brief Data of feed icon, chosen by user or favicon of its site
+ * @return empty if feed has no icon
+ *---------------------------------------------------------------------------*/
+QByteArray FeedsModel::iconDataById(int id) const
+{
+  QSqlQuery q;
+  q.prepare("SELECT feeds.image, icons.data FROM feeds "
+            "LEFT JOIN favicons ON favicons.site=feeds.faviconSite "
+            "LEFT JOIN icons ON icons.hash=favicons.iconHash "
+            "WHERE feeds.id=?");
+  q.addBindValue(id);
+  q.exec();
+  if (!q.first())
+    return QByteArray();
+
+  QByteArray byteArray = QByteArray::fromBase64(q.value(0).toByteArray());
+  if (byteArray.isEmpty())
+    byteArray = q.value(1).toByteArray();
+  return byteArray;
+}
+
+/** @brief Decode feed icon again next time it is shown
+ * @details Decoded icon is dropped when no other feed shows it.
+ *---------------------------------------------------------------------------*/
+void FeedsModel::invalidateIcon(int id)
+{
+  QByteArray hash = iconHashes_.take(id);
+  if (hash.isEmpty())
+    return;
+
+  QHash<QByteArray,int>::iterator it = iconUsers_.find(hash);
+  if ((it != iconUsers_.end()) && (--it.value() > 0))
+    return;
+
+  iconUsers_.remove(hash);
+  icons_.remove(hash);
+  statusIcons_.remove(hash + "-");
+  statusIcons_.remove(hash + "+");
+}
+
+/** @brief Decode favicon again for all feeds of site
+ * @details Feeds are taken from DB as site of new feed may be not read yet.
+ *---------------------------------------------------------------------------*/
+void FeedsModel::invalidateSiteIcon(const QString &site)
+{
+  QSqlQuery q;
+  q.setForwardOnly(true);
+  q.prepare("SELECT id FROM feeds WHERE faviconSite=?");
+  q.addBindValue(site);
+  q.exec();
+  while (q.next()) {
+    invalidateIcon(q.value(0).toInt());
+  }
+}
+
+/** @brief Hash of feed icon, icon is decoded when it is seen first time
+ * @details Image chosen by user is taken before favicon of feed site.
+ *   Favicon is read from icons table only if its hash is not decoded yet.
+ * @return empty if feed has no icon or it could not be decoded
+ *---------------------------------------------------------------------------*/
+QByteArray FeedsModel::iconHash(UserData *userData) const
+{
+  QHash<int,QByteArray>::const_iterator it = iconHashes_.constFind(userData->id);
+  if (it != iconHashes_.constEnd())
+    return it.value();
+
+  QByteArray hash;
+  QSqlQuery q;
+  q.prepare("SELECT feeds.image, favicons.iconHash FROM feeds "
+            "LEFT JOIN favicons ON favicons.site=feeds.faviconSite "
+            "WHERE feeds.id=?");
+  q.addBindValue(userData->id);
+  q.exec();
+  if (q.first()) {
+    QByteArray byteArray = QByteArray::fromBase64(q.value(0).toByteArray());
+    if (!byteArray.isEmpty()) {
+      hash = QCryptographicHash::hash(byteArray, QCryptographicHash::Sha1).toHex();
+    } else {
+      hash = q.value(1).toByteArray();
+      if (!hash.isEmpty() && !icons_.contains(hash)) {
+        q.prepare("SELECT data FROM icons WHERE hash=?");
+        q.addBindValue(QString::fromLatin1(hash));
+        q.exec();
+        if (q.first())
+          byteArray = q.value(0).toByteArray();
+      }
+    }
+
+    if (!hash.isEmpty() && !icons_.contains(hash)) {
+      QPixmap icon;
+      if (icon.loadFromData(byteArray))
+        icons_.insert(hash, icon);
+      else
+        hash.clear();
+    }
+  }
+  iconHashes_.insert(userData->id, hash);
+  if (!hash.isEmpty())
+    iconUsers_[hash]++;
+  return hash;
+}
+
+/** @brief Feed icon with mark of update status drawn over it
+ * @param hash - hash of feed image, default icon is used if empty
+ * @param status - less than 0 on error, 1 while updating
+ *---------------------------------------------------------------------------*/
+QPixmap FeedsModel::statusIcon(const QByteArray &hash, int status) const
+{
+  QPixmap icon = hash.isEmpty() ? feedIcon_ : icons_.value(hash);
+  if ((status == 0) || (status > 1))
+    return icon;
+
+  QByteArray key = hash + ((status < 0) ? "-" : "+");
+  QHash<QByteArray,QPixmap>::const_iterator it = statusIcons_.constFind(key);
+  if (it != statusIcons_.constEnd())
+    return it.value();
+
+  QImage resultImage = icon.toImage().convertToFormat(QImage::Format_ARGB32_Premultiplied);
+  QPainter resultPainter(&resultImage);
+  resultPainter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+  resultPainter.drawPixmap(0, 0, (status < 0) ? errorBullet_ : updateBullet_);
+  resultPainter.end();
+
+  QPixmap resultIcon = QPixmap::fromImage(resultImage);
+  statusIcons_.insert(key, resultIcon);
+  return resultIcon;
+}
+
 int FeedsModel::indexColumnOf(int column) const
 {
   return columnsList_.value(column, column);
@@ -326,7 +716,7 @@ int FeedsModel::indexColumnOf(int column) const
 
 int FeedsModel::indexColumnOf(const QString &name) const
 {
-  return indexColumnOf(queryModel_.record().indexOf(name));
+  return indexColumnOf(record_.indexOf(name));
 }
 
 void FeedsModel::setView(QTreeView *view)
@@ -1,8 +1,9 @@
 #ifndef FEEDSMODEL_H
 #define FEEDSMODEL_H
 
+#include <QPixmap>
+#include <QSet>
 #include <QSqlRecord>
-#include <QSqlQueryModel>
 #include <QTreeView>
 
 struct UserData
@@ -10,13 +11,19 @@ struct UserData
   UserData(int id, int parid, const QSqlRecord &record)
     : id(id)
     , parid(parid),
-      record(record) {
+      record(record)
+    , parent(0)
+    , row(-1) {
   }
   ~UserData() {
   }
   int id;
   int parid;
   QSqlRecord record;
+  UserData *parent;            // NULL while item is not in tree
+  QList<UserData*> children;   // ordered by rowToParent
+  int row;                     // row in parent
+  QSet<int> loaded;            // columns read besides columns of tree
 };
 
 class FeedsModel : public QAbstractItemModel
@@ -45,6 +52,16 @@ public:
   QModelIndex indexById(int id) const;
   int paridByIndex(const QModelIndex &index) const;
 
+  QModelIndex insertItem(int id);
+  void updateItems(const QList<int> &idList);
+  void removeItem(int id);
+  void moveItems(const QList<int> &idList);
+
+  QPixmap iconById(int id) const;
+  QByteArray iconDataById(int id) const;
+  void invalidateIcon(int id);
+  void invalidateSiteIcon(const QString &site);
+
   int indexColumnOf(int column) const;
   int indexColumnOf(const QString &name) const;
 
@@ -65,21 +82,41 @@ public slots:
 
 private:
   void clear();
-  int rowById(int id) const;
-  int rowByParid(int parid) const;
   UserData * userDataById(int id) const;
+  UserData * itemByIndex(const QModelIndex &index) const;
+  QModelIndex indexOfItem(UserData *userData) const;
+  void updateRows(UserData *parentItem, int first);
+  void moveItem(UserData *userData, UserData *parentItem, int row);
+  void deleteItem(UserData *userData);
+  QSqlRecord treeRecord(const QSqlQuery &q) const;
+  QVariant fieldValue(UserData *userData, int column) const;
+  QByteArray iconHash(UserData *userData) const;
+  QPixmap statusIcon(const QByteArray &hash, int status) const;
 
   QTreeView *view_;
-  QSqlQueryModel queryModel_;
+  QSqlRecord record_;          // all columns of feeds table
+  QList<int> treeColumns_;     // columns read for all items
+  QString treeColumnsStr_;
   int rootParentId_;
   int indexId_;
   int indexParid_;
+  int indexRowToParent_;
+  int indexImage_;
+  int indexXmlUrl_;
 
-  QMap<int,int> id2RowList_;
-  QMap<int,int> parid2RowList_;
-  QMap<int,UserData*> userDataList_;
+  UserData *rootItem_;
+  QHash<int,UserData*> userDataList_;
   QHash<int,int> columnsList_;
 
+  // Decoded icons are shared by feeds with the same image
+  mutable QHash<int,QByteArray> iconHashes_;       // feed id -> hash of icon
+  mutable QHash<QByteArray,int> iconUsers_;        // hash of icon -> feeds
+  mutable QHash<QByteArray,QPixmap> icons_;        // hash of icon -> icon
+  mutable QHash<QByteArray,QPixmap> statusIcons_;  // hash and status -> icon
+  QPixmap folderIcon_;
+  QPixmap feedIcon_;
+  QPixmap errorBullet_;
+  QPixmap updateBullet_;
 
 };
 
@@ -0,0 +1,244 @@
+#include "contentdecoder.h"
+
+#include <QDebug>
+#include <QList>
+#include <zlib.h>
+#ifdef HAVE_BROTLI
+#include <brotli/decode.h>
+#endif
+
+#define DECODE_BUFFER_SIZE 16384
+
+ContentDecoder::ContentDecoder(const QByteArray &contentEncoding)
+  : stream_(NULL)
+  , rawDeflate_(false)
+  , error_(false)
+  , encodedBytes_(0)
+  , decodedBytes_(0)
+{
+  // "identity" may be listed along with real coding, e.g. "identity, gzip"
+  QList<QByteArray> encodings;
+  foreach (const QByteArray &value, contentEncoding.toLower().split(',')) {
+    QByteArray encoding = value.trimmed();
+    if (!encoding.isEmpty() && (encoding != "identity"))
+      encodings.append(encoding);
+  }
+
+  QByteArray encoding = encodings.isEmpty() ? QByteArray() : encodings.first();
+  if (encodings.isEmpty()) {
+    encoding_ = Identity;
+  } else if (encodings.count() > 1) {
+    encoding_ = Unsupported;
+  } else if ((encoding == "gzip") || (encoding == "x-gzip")) {
+    encoding_ = Gzip;
+  } else if (encoding == "deflate") {
+    encoding_ = Deflate;
+#ifdef HAVE_BROTLI
+  } else if (encoding == "br") {
+    encoding_ = Brotli;
+#endif
+  } else {
+    encoding_ = Unsupported;
+  }
+
+  // Servers send bogus values like "UTF-8" or "none" for plain data.
+  // Data is passed as is, the same as QNetworkAccessManager did.
+  if (encoding_ == Unsupported) {
+    qWarning() << "Unsupported Content-Encoding, data is passed as is:"
+               << contentEncoding;
+    encoding_ = Identity;
+  }
+
+  switch (encoding_) {
+  case Gzip:
+  case Deflate:
+    // Detect gzip or zlib header automatically
+    if (!initInflate(MAX_WBITS + 32))
+      error_ = true;
+    break;
+#ifdef HAVE_BROTLI
+  case Brotli:
+    stream_ = BrotliDecoderCreateInstance(NULL, NULL, NULL);
+    if (!stream_)
+      error_ = true;
+    break;
+#endif
+  default:
+    break;
+  }
+}
+
+ContentDecoder::~ContentDecoder()
+{
+#ifdef HAVE_BROTLI
+  if (encoding_ == Brotli) {
+    if (stream_)
+      BrotliDecoderDestroyInstance(static_cast<BrotliDecoderState*>(stream_));
+    return;
+  }
+#endif
+  endInflate();
+}
+
+/** @brief Value of Accept-Encoding header for supported encodings
+ *----------------------------------------------------------------------------*/
+QByteArray ContentDecoder::acceptEncoding()
+{
+#ifdef HAVE_BROTLI
+  return "gzip, deflate, br";
+#else
+  return "gzip, deflate";
+#endif
+}
+
+/** @brief Decode next part of received data
+ * @return false on decoding error
+ *----------------------------------------------------------------------------*/
+bool ContentDecoder::write(const QByteArray &data)
+{
+  if (error_)
+    return false;
+  if (data.isEmpty())
+    return true;
+
+  encodedBytes_ += data.size();
+
+  switch (encoding_) {
+  case Gzip:
+  case Deflate:
+    // Keep data until it is clear which kind of "deflate" server sends
+    if ((encoding_ == Deflate) && !rawDeflate_ && (decodedBytes_ == 0))
+      pending_.append(data);
+    return inflateData(data);
+#ifdef HAVE_BROTLI
+  case Brotli:
+    return brotliData(data);
+#endif
+  default:
+    data_.append(data);
+    decodedBytes_ += data.size();
+    return true;
+  }
+}
+
+/** @brief Take decoded data accumulated so far
+ *----------------------------------------------------------------------------*/
+QByteArray ContentDecoder::takeData()
+{
+  QByteArray data = data_;
+  data_.clear();
+  return data;
+}
+
+bool ContentDecoder::initInflate(int windowBits)
+{
+  z_stream *stream = new z_stream;
+  stream->zalloc = Z_NULL;
+  stream->zfree = Z_NULL;
+  stream->opaque = Z_NULL;
+  stream->next_in = Z_NULL;
+  stream->avail_in = 0;
+  if (inflateInit2(stream, windowBits) != Z_OK) {
+    delete stream;
+    return false;
+  }
+  stream_ = stream;
+  return true;
+}
+
+void ContentDecoder::endInflate()
+{
+  if (!stream_)
+    return;
+
+  z_stream *stream = static_cast<z_stream*>(stream_);
+  inflateEnd(stream);
+  delete stream;
+  stream_ = NULL;
+}
+
+bool ContentDecoder::inflateData(const QByteArray &data)
+{
+  QByteArray input = data;
+  if (!tail_.isEmpty()) {
+    input.prepend(tail_);
+    tail_.clear();
+  }
+
+  z_stream *stream = static_cast<z_stream*>(stream_);
+  stream->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.constData()));
+  stream->avail_in = input.size();
+
+  char buffer[DECODE_BUFFER_SIZE];
+  forever {
+    stream->next_out = reinterpret_cast<Bytef*>(buffer);
+    stream->avail_out = sizeof(buffer);
+
+    int ret = inflate(stream, Z_NO_FLUSH);
+    int size = sizeof(buffer) - stream->avail_out;
+    data_.append(buffer, size);
+    decodedBytes_ += size;
+    if (decodedBytes_ > 0)
+      pending_.clear();
+
+    if (ret == Z_STREAM_END) {
+      // Next gzip member may follow, anything else is trailing garbage.
+      // Magic bytes of next member may be split between two chunks.
+      if (stream->avail_in < 2) {
+        tail_ = QByteArray(reinterpret_cast<const char*>(stream->next_in),
+                           stream->avail_in);
+        return true;
+      }
+      if ((stream->next_in[0] != 0x1f) || (stream->next_in[1] != 0x8b))
+        return true;
+      inflateReset(stream);
+      continue;
+    }
+    if ((ret == Z_BUF_ERROR) && (stream->avail_in == 0))
+      return true;
+    if (ret != Z_OK) {
+      // Some servers send "deflate" without zlib header
+      if ((encoding_ == Deflate) && !rawDeflate_ && (decodedBytes_ == 0)) {
+        rawDeflate_ = true;
+        endInflate();
+        if (initInflate(-MAX_WBITS)) {
+          QByteArray pending = pending_;
+          pending_.clear();
+          return inflateData(pending);
+        }
+      }
+      error_ = true;
+      return false;
+    }
+    if ((stream->avail_in == 0) && (stream->avail_out != 0))
+      return true;
+  }
+}
+
+#ifdef HAVE_BROTLI
+bool ContentDecoder::brotliData(const QByteArray &data)
+{
+  BrotliDecoderState *state = static_cast<BrotliDecoderState*>(stream_);
+  size_t availIn = data.size();
+  const uint8_t *nextIn = reinterpret_cast<const uint8_t*>(data.constData());
+
+  uint8_t buffer[DECODE_BUFFER_SIZE];
+  forever {
+    size_t availOut = sizeof(buffer);
+    uint8_t *nextOut = buffer;
+    BrotliDecoderResult result =
+        BrotliDecoderDecompressStream(state, &availIn, &nextIn,
+                                      &availOut, &nextOut, NULL);
+    int size = sizeof(buffer) - availOut;
+    data_.append(reinterpret_cast<const char*>(buffer), size);
+    decodedBytes_ += size;
+
+    if (result == BROTLI_DECODER_RESULT_ERROR) {
+      error_ = true;
+      return false;
+    }
+    if (result != BROTLI_DECODER_RESULT_NEEDS_MORE_OUTPUT)
+      return true;
+  }
+}
+#endif
@@ -0,0 +1,55 @@
+#ifndef CONTENTDECODER_H
+#define CONTENTDECODER_H
+
+#include <QByteArray>
+
+/** @brief Streaming decoder of HTTP content encodings (gzip, deflate, br)
+ *
+ * Used with explicit Accept-Encoding, when QNetworkAccessManager does not
+ * decompress reply itself. Data of unknown encoding is passed as is.
+ * Counts bytes before and after decoding.
+ *----------------------------------------------------------------------------*/
+class ContentDecoder
+{
+public:
+  explicit ContentDecoder(const QByteArray &contentEncoding);
+  ~ContentDecoder();
+
+  static QByteArray acceptEncoding();
+
+  bool write(const QByteArray &data);
+  QByteArray takeData();
+
+  bool hasError() const { return error_; }
+  qint64 encodedBytes() const { return encodedBytes_; }
+  qint64 decodedBytes() const { return decodedBytes_; }
+
+private:
+  enum Encoding {
+    Identity,
+    Gzip,
+    Deflate,
+    Brotli,
+    Unsupported
+  };
+
+  bool inflateData(const QByteArray &data);
+  bool initInflate(int windowBits);
+  void endInflate();
+#ifdef HAVE_BROTLI
+  bool brotliData(const QByteArray &data);
+#endif
+
+  Encoding encoding_;
+  void *stream_;
+  bool rawDeflate_;
+  QByteArray pending_;
+  QByteArray tail_;  // bytes after gzip member, too few to see next member
+  QByteArray data_;
+  bool error_;
+  qint64 encodedBytes_;
+  qint64 decodedBytes_;
+
+};
+
+#endif // CONTENTDECODER_H
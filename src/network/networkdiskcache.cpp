@@ -0,0 +1,87 @@
+#include "networkdiskcache.h"
+
+#include "mainapplication.h"
+
+NetworkDiskCache::NetworkDiskCache(QObject *parent)
+  : QAbstractNetworkCache(parent)
+{
+}
+
+/** @brief Lock of shared QNetworkDiskCache
+ *----------------------------------------------------------------------------*/
+QMutex *NetworkDiskCache::mutex()
+{
+  static QMutex mutex;
+  return &mutex;
+}
+
+QNetworkCacheMetaData NetworkDiskCache::metaData(const QUrl &url)
+{
+  QMutexLocker locker(mutex());
+  QNetworkDiskCache *diskCache = mainApp->diskCache();
+  if (!diskCache) return QNetworkCacheMetaData();
+  return diskCache->metaData(url);
+}
+
+void NetworkDiskCache::updateMetaData(const QNetworkCacheMetaData &metaData)
+{
+  QMutexLocker locker(mutex());
+  QNetworkDiskCache *diskCache = mainApp->diskCache();
+  if (!diskCache) return;
+  diskCache->updateMetaData(metaData);
+}
+
+/** @brief Cached data of \a url
+ * @details Returned device has no parent and is used in caller thread.
+ *----------------------------------------------------------------------------*/
+QIODevice *NetworkDiskCache::data(const QUrl &url)
+{
+  QMutexLocker locker(mutex());
+  QNetworkDiskCache *diskCache = mainApp->diskCache();
+  if (!diskCache) return 0;
+  return diskCache->data(url);
+}
+
+bool NetworkDiskCache::remove(const QUrl &url)
+{
+  QMutexLocker locker(mutex());
+  QNetworkDiskCache *diskCache = mainApp->diskCache();
+  if (!diskCache) return false;
+  return diskCache->remove(url);
+}
+
+qint64 NetworkDiskCache::cacheSize() const
+{
+  QMutexLocker locker(mutex());
+  QNetworkDiskCache *diskCache = mainApp->diskCache();
+  if (!diskCache) return 0;
+  return diskCache->cacheSize();
+}
+
+/** @brief Start caching of reply data
+ * @details Device is written by manager of caller thread and passed back
+ *   to insert() or remove().
+ *----------------------------------------------------------------------------*/
+QIODevice *NetworkDiskCache::prepare(const QNetworkCacheMetaData &metaData)
+{
+  QMutexLocker locker(mutex());
+  QNetworkDiskCache *diskCache = mainApp->diskCache();
+  if (!diskCache) return 0;
+  return diskCache->prepare(metaData);
+}
+
+void NetworkDiskCache::insert(QIODevice *device)
+{
+  QMutexLocker locker(mutex());
+  QNetworkDiskCache *diskCache = mainApp->diskCache();
+  if (!diskCache) return;
+  diskCache->insert(device);
+}
+
+void NetworkDiskCache::clear()
+{
+  QMutexLocker locker(mutex());
+  QNetworkDiskCache *diskCache = mainApp->diskCache();
+  if (!diskCache) return;
+  diskCache->clear();
+}
@@ -0,0 +1,37 @@
+#ifndef NETWORKDISKCACHE_H
+#define NETWORKDISKCACHE_H
+
+#include <QAbstractNetworkCache>
+#include <QMutex>
+#include <QNetworkDiskCache>
+
+/** @brief Disk cache shared by network managers of all threads
+ *
+ * QNetworkAccessManager owns its cache, so each manager gets its own
+ * NetworkDiskCache. All of them pass calls to MainApplication::diskCache()
+ * under a common lock, which is taken also to create or change that cache.
+ * Calls do nothing while disk cache has not been created.
+ *----------------------------------------------------------------------------*/
+class NetworkDiskCache : public QAbstractNetworkCache
+{
+  Q_OBJECT
+public:
+  explicit NetworkDiskCache(QObject *parent = 0);
+
+  static QMutex *mutex();
+
+  QNetworkCacheMetaData metaData(const QUrl &url);
+  void updateMetaData(const QNetworkCacheMetaData &metaData);
+  QIODevice *data(const QUrl &url);
+  bool remove(const QUrl &url);
+  qint64 cacheSize() const;
+
+  QIODevice *prepare(const QNetworkCacheMetaData &metaData);
+  void insert(QIODevice *device);
+
+public slots:
+  void clear();
+
+};
+
+#endif // NETWORKDISKCACHE_H
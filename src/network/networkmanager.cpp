@@ -4,6 +4,7 @@
 #include "common.h"
 #include "settings.h"
 #include "authenticationdialog.h"
+#include "networkdiskcache.h"
 #include "adblockmanager.h"
 #include "sslerrordialog.h"
 #if defined(Q_OS_OS2)
@@ -46,6 +47,10 @@ NetworkManager::NetworkManager(bool isThread, QObject* parent)
   connect(this, SIGNAL(sslErrors(QNetworkReply*, QList<QSslError>)),
           this, SLOT(slotSslError(QNetworkReply*, QList<QSslError>)));
 
+  // Disk cache is shared by managers of all threads. It is looked up on
+  // each call, so managers use it also when it is enabled later.
+  setCache(new NetworkDiskCache(this));
+
   if (isThread) {
     connect(this, SIGNAL(authenticationRequired(QNetworkReply*,QAuthenticator*)),
             mainApp->networkManager(), SLOT(slotAuthentication(QNetworkReply*,QAuthenticator*)),
@@ -53,7 +58,6 @@ NetworkManager::NetworkManager(bool isThread, QObject* parent)
     connect(this, SIGNAL(proxyAuthenticationRequired(QNetworkProxy,QAuthenticator*)),
             mainApp->networkManager(), SLOT(slotProxyAuthentication(QNetworkProxy,QAuthenticator*)),
             Qt::BlockingQueuedConnection);
-
   } else {
     connect(this, SIGNAL(authenticationRequired(QNetworkReply*,QAuthenticator*)),
             SLOT(slotAuthentication(QNetworkReply*,QAuthenticator*)));
@@ -1,12 +1,28 @@
 #ifndef NETWORKMANAGER_H
 #define NETWORKMANAGER_H
 
+#include <QMetaType>
 #include <QNetworkAccessManager>
 #include <QSslError>
 #include <QStringList>
 
 class AdBlockManager;
 
+/** @brief Replies of update thread manager since its queue was empty
+ * @details Bytes are received ones, before and after content decoding.
+ *----------------------------------------------------------------------------*/
+struct TransferStats {
+  qint64 receivedBytes;
+  qint64 decodedBytes;
+  int repliesCount;
+  int cachedRepliesCount;
+
+  TransferStats()
+    : receivedBytes(0), decodedBytes(0), repliesCount(0), cachedRepliesCount(0) {}
+};
+
+Q_DECLARE_METATYPE(TransferStats)
+
 class NetworkManager : public QNetworkAccessManager
 {
   Q_OBJECT
@@ -2,6 +2,7 @@
 
 #include "mainapplication.h"
 #include "settings.h"
+#include "userfilters.h"
 
 FilterRulesDialog::FilterRulesDialog(QWidget *parent, int filterId, int feedId)
   : Dialog(parent, Qt::WindowMinMaxButtonsHint)
@@ -33,14 +34,13 @@ FilterRulesDialog::FilterRulesDialog(QWidget *parent, int filterId, int feedId)
   parentIds.enqueue(0);
   while (!parentIds.empty()) {
     int parentId = parentIds.dequeue();
-    QString qStr = QString("SELECT text, id, image, xmlUrl FROM feeds WHERE parentId='%1' ORDER BY rowToParent").
+    QString qStr = QString("SELECT text, id, xmlUrl FROM feeds WHERE parentId='%1' ORDER BY rowToParent").
         arg(parentId);
     q.exec(qStr);
     while (q.next()) {
       QString feedText = q.value(0).toString();
       QString feedIdT = q.value(1).toString();
-      QByteArray byteArray = q.value(2).toByteArray();
-      QString xmlUrl = q.value(3).toString();
+      QString xmlUrl = q.value(2).toString();
 
       treeItem.clear();
       treeItem << feedText << feedIdT;
@@ -55,10 +55,10 @@ FilterRulesDialog::FilterRulesDialog(QWidget *parent, int filterId, int feedId)
       if (xmlUrl.isEmpty()) {
         iconItem.load(":/images/folder");
       } else {
-        if (byteArray.isNull() || mainApp->mainWindow()->defaultIconFeeds_) {
+        if (mainApp->mainWindow()->defaultIconFeeds_) {
           iconItem.load(":/images/feed");
         } else {
-          iconItem.loadFromData(QByteArray::fromBase64(byteArray));
+          iconItem = mainApp->mainWindow()->feedsModel_->iconById(feedIdT.toInt());
         }
       }
       treeWidgetItem->setIcon(0, iconItem);
@@ -422,6 +422,7 @@ void FilterRulesDialog::acceptDialog()
       q.exec();
     }
   }
+  UserFilters::invalidate();
   accept();
 }
 
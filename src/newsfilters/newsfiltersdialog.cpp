@@ -4,6 +4,7 @@
 #include "filterrulesdialog.h"
 #include "parseobject.h"
 #include "settings.h"
+#include "userfilters.h"
 
 NewsFiltersDialog::NewsFiltersDialog(QWidget *parent)
   : Dialog(parent, Qt::WindowMinMaxButtonsHint)
@@ -251,6 +252,7 @@ void NewsFiltersDialog::deleteFilter()
   q.exec(QString("DELETE FROM filterConditions WHERE idFilter='%1'").arg(filterId));
   q.exec(QString("DELETE FROM filterActions WHERE idFilter='%1'").arg(filterId));
   q.finish();
+  UserFilters::invalidate();
 
   filtersTree_->takeTopLevelItem(filterRow);
 
@@ -289,6 +291,7 @@ void NewsFiltersDialog::moveUpFilter()
   qStr = QString("UPDATE filters SET num='%1' WHERE id=='%2'").
       arg(filterNum).arg(filterId);
   q.exec(qStr);
+  UserFilters::invalidate();
 }
 
 void NewsFiltersDialog::moveDownFilter()
@@ -320,6 +323,7 @@ void NewsFiltersDialog::moveDownFilter()
   qStr = QString("UPDATE filters SET num='%1' WHERE id=='%2'").
       arg(filterNum).arg(filterId);
   q.exec(qStr);
+  UserFilters::invalidate();
 }
 
 void NewsFiltersDialog::slotCurrentItemChanged(QTreeWidgetItem *current,
@@ -387,5 +391,6 @@ void NewsFiltersDialog::slotItemChanged(QTreeWidgetItem *item, int column)
     QString qStr = QString("UPDATE filters SET enable='%1' WHERE id=='%2'").
         arg(enable).arg(item->text(0).toInt());
     q.exec(qStr);
+    UserFilters::invalidate();
   }
 }
@@ -0,0 +1,402 @@
+#include "userfilters.h"
+
+#include <QDebug>
+
+QMutex UserFilters::mutex_;
+bool UserFilters::valid_ = false;
+QList<UserFilterPtr> UserFilters::filters_;
+
+namespace {
+
+enum FilterField {
+  FieldTitle = 0,
+  FieldDescription,
+  FieldAuthor,
+  FieldCategory,
+  FieldStatus,
+  FieldLink,
+  FieldNews
+};
+
+enum FilterOperation {
+  OpContains,
+  OpNotContains,
+  OpIs,
+  OpIsNot,
+  OpBeginsWith,
+  OpEndsWith,
+  OpRegExp
+};
+
+// Conditions offered by filter rules dialog for every field
+const FilterOperation kFullOperations[] = {
+  OpContains, OpNotContains, OpIs, OpIsNot, OpBeginsWith, OpEndsWith, OpRegExp
+};
+const FilterOperation kAuthorOperations[] = {
+  OpContains, OpNotContains, OpIs, OpIsNot, OpRegExp
+};
+const FilterOperation kTextOperations[] = {
+  OpContains, OpNotContains, OpRegExp
+};
+
+// SQLite LIKE ignores case of ASCII letters only
+QString asciiUpper(const QString &text)
+{
+  QString str = text;
+  for (int i = 0; i < str.length(); ++i) {
+    ushort c = str.at(i).unicode();
+    if ((c >= 'a') && (c <= 'z'))
+      str[i] = QChar(c - ('a' - 'A'));
+  }
+  return str;
+}
+
+QString foldValue(int field, const QString &value)
+{
+  if (field == FieldLink)
+    return asciiUpper(value);
+  return value.toUpper();
+}
+
+/** @brief Match \a str against SQL LIKE-pattern with '%' and '_' wildcards
+ *----------------------------------------------------------------------------*/
+bool likeMatch(const QString &str, const QString &pattern)
+{
+  int s = 0;
+  int p = 0;
+  int starP = -1;
+  int starS = 0;
+  while (s < str.length()) {
+    if ((p < pattern.length()) &&
+        ((pattern.at(p) == QLatin1Char('_')) || (pattern.at(p) == str.at(s)))) {
+      ++s;
+      ++p;
+    } else if ((p < pattern.length()) && (pattern.at(p) == QLatin1Char('%'))) {
+      starP = p++;
+      starS = s;
+    } else if (starP != -1) {
+      p = starP + 1;
+      s = ++starS;
+    } else {
+      return false;
+    }
+  }
+  while ((p < pattern.length()) && (pattern.at(p) == QLatin1Char('%')))
+    ++p;
+  return (p == pattern.length());
+}
+
+bool likeMatch(const UserFilterCondition &condition, const QString &value)
+{
+  const QString str = foldValue(condition.field, value);
+  if (condition.hasWildcards)
+    return likeMatch(str, condition.pattern);
+
+  // Pattern is literal text surrounded by wildcards added for the condition
+  const QString &pattern = condition.pattern;
+  bool leading = pattern.startsWith(QLatin1Char('%'));
+  bool trailing = pattern.endsWith(QLatin1Char('%'));
+  if (leading && trailing)
+    return str.contains(pattern.mid(1, pattern.length() - 2));
+  if (leading)
+    return str.endsWith(pattern.mid(1));
+  if (trailing)
+    return str.startsWith(pattern.left(pattern.length() - 1));
+  return (str == pattern);
+}
+
+} // namespace
+
+/** @brief Check news by filter conditions
+ *----------------------------------------------------------------------------*/
+bool UserFilter::matches(const UserFilterNews &news) const
+{
+  if (!valid)
+    return false;
+
+  // Filter for all news
+  if ((type != 1) && (type != 2))
+    return true;
+  if (conditions.isEmpty())
+    return false;
+
+  foreach (const UserFilterCondition &condition, conditions) {
+    bool match = matchCondition(condition, news);
+    if ((type == 1) && !match) return false;
+    if ((type == 2) && match) return true;
+  }
+  return (type == 1);
+}
+
+/** @brief Check news by one condition
+ * @details Follows SQL semantics of conditions: NULL field never matches.
+ *----------------------------------------------------------------------------*/
+bool UserFilter::matchCondition(const UserFilterCondition &condition,
+                                const UserFilterNews &news) const
+{
+  if (condition.field == FieldStatus) {
+    QVariant value;
+    switch (condition.status) {
+    case 0: value = news.isNew; break;
+    case 1: value = news.read; break;
+    case 2: value = news.starred; break;
+    }
+    if (value.isNull())
+      return false;
+
+    int v = value.toInt();
+    if (condition.match == UserFilterCondition::StatusIs)
+      return (condition.status == 1) ? (v >= 1) : (v == 1);
+    return (v == 0);
+  }
+
+  QStringList values;
+  switch (condition.field) {
+  case FieldTitle: values << news.title; break;
+  case FieldDescription: values << news.description; break;
+  case FieldAuthor: values << news.author; break;
+  case FieldCategory: values << news.category; break;
+  case FieldLink: values << news.link; break;
+  case FieldNews: values << news.title << news.description; break;
+  }
+
+  foreach (const QString &value, values) {
+    if (value.isNull())
+      continue;
+
+    bool match = false;
+    switch (condition.match) {
+    case UserFilterCondition::Like:
+      match = likeMatch(condition, value);
+      break;
+    case UserFilterCondition::NotLike:
+      match = !likeMatch(condition, value);
+      break;
+    case UserFilterCondition::RegExp:
+      match = condition.regExp.match(value).hasMatch();
+      break;
+    default:
+      break;
+    }
+    if (match) return true;
+  }
+  return false;
+}
+
+/** @brief Apply filter actions changing news flags and labels
+ *----------------------------------------------------------------------------*/
+void UserFilter::apply(UserFilterNews *news, const QString &deleteDate) const
+{
+  if (markRead || markDeleted) {
+    news->isNew = 0;
+    news->read = 2;
+  }
+  if (addStar)
+    news->starred = 1;
+  if (markDeleted) {
+    news->deleted = true;
+    news->deleteDate = deleteDate;
+  }
+
+  foreach (int idLabel, labels) {
+    if (news->label.contains(QString(",%1,").arg(idLabel))) continue;
+    if (news->label.isEmpty()) news->label.append(",");
+    news->label.append(QString("%1,").arg(idLabel));
+  }
+}
+
+/** @brief Get compiled filters to run for feed \a feedId
+ * @param filterId - run only this filter (even if disabled), -1 - run all
+ *   enabled filters
+ *----------------------------------------------------------------------------*/
+QList<UserFilterPtr> UserFilters::filtersForFeed(QSqlDatabase &db, int feedId,
+                                                 int filterId)
+{
+  QMutexLocker locker(&mutex_);
+
+  if (!valid_) {
+    load(db);
+    valid_ = true;
+  }
+
+  QList<UserFilterPtr> filters;
+  foreach (const UserFilterPtr &filter, filters_) {
+    if (!filter->feeds.contains(feedId)) continue;
+
+    if (filterId != -1) {
+      if (filter->id == filterId) filters.append(filter);
+    } else if (filter->enabled) {
+      filters.append(filter);
+    }
+  }
+  return filters;
+}
+
+/** @brief Drop compiled filters, they are loaded again on next use
+ * @details Must be called after filters have been changed in base.
+ *----------------------------------------------------------------------------*/
+void UserFilters::invalidate()
+{
+  QMutexLocker locker(&mutex_);
+  valid_ = false;
+  filters_.clear();
+}
+
+void UserFilters::load(QSqlDatabase &db)
+{
+  filters_.clear();
+
+  QSqlQuery q(db);
+  q.setForwardOnly(true);
+  if (!q.exec("SELECT id, enable, type, feeds FROM filters ORDER BY num")) {
+    qWarning() << __PRETTY_FUNCTION__ << __LINE__
+               << "q.lastError(): " << q.lastError().text();
+    return;
+  }
+
+  while (q.next()) {
+    UserFilter *filter = new UserFilter;
+    filter->id = q.value(0).toInt();
+    filter->enabled = (q.value(1).toInt() != 0);
+    filter->type = q.value(2).toInt();
+    filter->valid = true;
+    filter->markRead = false;
+    filter->addStar = false;
+    filter->markDeleted = false;
+    foreach (const QString &idFeed, q.value(3).toString().split(",", Qt::SkipEmptyParts)) {
+      filter->feeds.insert(idFeed.toInt());
+    }
+
+    QSqlQuery q1(db);
+    q1.setForwardOnly(true);
+    if ((filter->type == 1) || (filter->type == 2)) {
+      q1.exec(QString("SELECT field, condition, content FROM filterConditions "
+                      "WHERE idFilter=='%1' ORDER BY id").arg(filter->id));
+      while (q1.next()) {
+        bool ok;
+        UserFilterCondition condition =
+            compileCondition(q1.value(0).toInt(), q1.value(1).toInt(),
+                             q1.value(2).toString(), &ok);
+        // Unknown condition made SQL of filter invalid, so filter never matched
+        if (!ok) filter->valid = false;
+        filter->conditions.append(condition);
+      }
+    }
+
+    q1.exec(QString("SELECT action, params FROM filterActions "
+                    "WHERE idFilter=='%1' ORDER BY id").arg(filter->id));
+    while (q1.next()) {
+      switch (q1.value(0).toInt()) {
+      case 0: // action -> Mark news as read
+        filter->markRead = true;
+        break;
+      case 1: // action -> Add star
+        filter->addStar = true;
+        break;
+      case 2: // action -> Delete
+        filter->markDeleted = true;
+        break;
+      case 3: // action -> Add Label
+        filter->labels.append(q1.value(1).toInt());
+        break;
+      case 4: // action -> Play Sound
+        filter->sounds.append(q1.value(1).toString());
+        break;
+      case 5: // action -> Show News in Notifier
+        filter->colors.append(q1.value(1).toString());
+        break;
+      }
+    }
+
+    filters_.append(UserFilterPtr(filter));
+  }
+
+  qDebug() << "User filters compiled:" << filters_.count();
+}
+
+UserFilterCondition UserFilters::compileCondition(int field, int condition,
+                                                  const QString &content,
+                                                  bool *ok)
+{
+  UserFilterCondition c;
+  c.field = field;
+  c.match = UserFilterCondition::Like;
+  c.hasWildcards = false;
+  c.status = -1;
+  *ok = true;
+
+  if (field == FieldStatus) {
+    c.match = (condition == 0) ? UserFilterCondition::StatusIs
+                               : UserFilterCondition::StatusIsNot;
+    c.status = content.toInt();
+    if ((c.status < 0) || (c.status > 2))
+      *ok = false;
+    return c;
+  }
+
+  const FilterOperation *operations;
+  int count;
+  switch (field) {
+  case FieldTitle:
+  case FieldCategory:
+  case FieldLink:
+    operations = kFullOperations;
+    count = sizeof(kFullOperations) / sizeof(kFullOperations[0]);
+    break;
+  case FieldAuthor:
+    operations = kAuthorOperations;
+    count = sizeof(kAuthorOperations) / sizeof(kAuthorOperations[0]);
+    break;
+  case FieldDescription:
+  case FieldNews:
+    operations = kTextOperations;
+    count = sizeof(kTextOperations) / sizeof(kTextOperations[0]);
+    break;
+  default:
+    *ok = false;
+    return c;
+  }
+  if ((condition < 0) || (condition >= count)) {
+    *ok = false;
+    return c;
+  }
+
+  FilterOperation operation = operations[condition];
+  if (operation == OpRegExp) {
+    c.match = UserFilterCondition::RegExp;
+    c.regExp = QRegularExpression(content,
+                                  QRegularExpression::DotMatchesEverythingOption |
+                                  QRegularExpression::CaseInsensitiveOption);
+    c.regExp.optimize();
+    return c;
+  }
+
+  QString text = foldValue(field, content);
+  c.hasWildcards = text.isEmpty() ||
+      text.contains(QLatin1Char('%')) || text.contains(QLatin1Char('_'));
+  switch (operation) {
+  case OpContains:
+    c.pattern = "%" + text + "%";
+    break;
+  case OpNotContains:
+    c.match = UserFilterCondition::NotLike;
+    c.pattern = "%" + text + "%";
+    break;
+  case OpIs:
+    c.pattern = text;
+    break;
+  case OpIsNot:
+    c.match = UserFilterCondition::NotLike;
+    c.pattern = text;
+    break;
+  case OpBeginsWith:
+    c.pattern = text + "%";
+    break;
+  case OpEndsWith:
+    c.pattern = "%" + text;
+    break;
+  default:
+    break;
+  }
+  return c;
+}
@@ -0,0 +1,91 @@
+#ifndef USERFILTERS_H
+#define USERFILTERS_H
+
+#include <QtSql>
+#include <QMutex>
+#include <QRegularExpression>
+#include <QSharedPointer>
+
+/** @brief News fields used by user filters
+ *----------------------------------------------------------------------------*/
+struct UserFilterNews {
+  int id;
+  QString title;
+  QString description;
+  QString author;
+  QString category;
+  QString link;
+  QVariant isNew;
+  QVariant read;
+  QVariant starred;
+  bool deleted;
+  QVariant deleteDate;
+  QString label;
+};
+
+/** @brief Condition of user filter compiled from filterConditions row
+ *----------------------------------------------------------------------------*/
+struct UserFilterCondition {
+  enum Match { Like, NotLike, RegExp, StatusIs, StatusIsNot };
+
+  int field;
+  Match match;
+  QString pattern;      // LIKE-pattern folded the same way as field value
+  bool hasWildcards;
+  QRegularExpression regExp;
+  int status;
+};
+
+/** @brief User filter compiled from filters, filterConditions and
+ *    filterActions tables
+ *----------------------------------------------------------------------------*/
+class UserFilter
+{
+public:
+  int id;
+  bool enabled;
+  int type;
+  QSet<int> feeds;
+  bool valid;
+  QList<UserFilterCondition> conditions;
+
+  bool markRead;
+  bool addStar;
+  bool markDeleted;
+  QList<int> labels;
+  QStringList sounds;
+  QStringList colors;
+
+  bool matches(const UserFilterNews &news) const;
+  void apply(UserFilterNews *news, const QString &deleteDate) const;
+
+private:
+  bool matchCondition(const UserFilterCondition &condition,
+                      const UserFilterNews &news) const;
+
+};
+
+typedef QSharedPointer<const UserFilter> UserFilterPtr;
+
+/** @brief Cache of compiled user filters shared by all parse workers
+ *----------------------------------------------------------------------------*/
+class UserFilters
+{
+public:
+  static QList<UserFilterPtr> filtersForFeed(QSqlDatabase &db, int feedId,
+                                             int filterId = -1);
+  static void invalidate();
+
+private:
+  static void load(QSqlDatabase &db);
+  static UserFilterCondition compileCondition(int field, int condition,
+                                              const QString &content,
+                                              bool *ok);
+
+  static QMutex mutex_;
+  static bool valid_;
+  static QList<UserFilterPtr> filters_;
+
+};
+
+#endif // USERFILTERS_H
@@ -1,6 +1,7 @@
 #include "newstabwidget.h"
 
 #include "mainapplication.h"
+#include "database.h"
 #include "adblockicon.h"
 #include "settings.h"
 #include "webpage.h"
@@ -1673,7 +1674,7 @@ void NewsTabWidget::loadNewspaper(int refresh)
           arg(newsId).arg(iconStr).arg(tr("Mark Read/Unread"));
 
       QString feedImg;
-      QByteArray byteArray = feedsModel_->dataField(feedIndex, "image").toByteArray();
+      QByteArray byteArray = feedsModel_->iconDataById(feedId.toInt()).toBase64();
       if (!byteArray.isEmpty())
         feedImg = QString("<img class='internal-img' src=\"data:image/png;base64,") % byteArray % "\"/>";
       else
@@ -2259,9 +2260,27 @@ void NewsTabWidget::slotFindText(const QString &text)
     }
 
     if (!text.isEmpty()) {
+      QStringList ftsColumns;
+      if (objectName == "findTitleAct") {
+        ftsColumns << "title";
+      } else if (objectName == "findAuthorAct") {
+        ftsColumns << "author_name";
+      } else if (objectName == "findCategoryAct") {
+        ftsColumns << "category";
+      } else if (objectName == "findContentAct") {
+        ftsColumns << "content" << "description";
+      }
+
+      // Full-text index is used if available, link isn't indexed
+      QString ftsStr;
+      if (objectName != "findLinkAct")
+        ftsStr = Database::fullTextCondition(text, ftsColumns);
+
       QString findText = text;
       findText = findText.replace("'", "''").toUpper();
-      if (objectName == "findTitleAct") {
+      if (!ftsStr.isEmpty()) {
+        filterStr.append(QString(" AND %1").arg(ftsStr));
+      } else if (objectName == "findTitleAct") {
         filterStr.append(
               QString(" AND UPPER(title) LIKE '%%1%'").arg(findText));
       } else if (objectName == "findAuthorAct") {
@@ -6,6 +6,11 @@ NewsModel::NewsModel(QObject *parent, QTreeView *view)
   : QSqlTableModel(parent)
   , simplifiedDateTime_(true)
   , view_(view)
+  , newIcon_(":/images/bulletNew")
+  , unreadIcon_(":/images/bulletUnread")
+  , readIcon_(":/images/bulletRead")
+  , starOnIcon_(":/images/starOn")
+  , starOffIcon_(":/images/starOff")
 {
   setEditStrategy(QSqlTableModel::OnManualSubmit);
 }
@@ -19,37 +24,18 @@ QVariant NewsModel::data(const QModelIndex &index, int role) const
 
   if (role == Qt::DecorationRole) {
     if (QSqlTableModel::fieldIndex("read") == index.column()) {
-      QPixmap icon;
       if (1 == QSqlTableModel::index(index.row(), fieldIndex("new")).data(Qt::EditRole).toInt())
-        icon.load(":/images/bulletNew");
+        return newIcon_;
       else if (0 == index.data(Qt::EditRole).toInt())
-        icon.load(":/images/bulletUnread");
-      else icon.load(":/images/bulletRead");
-      return icon;
+        return unreadIcon_;
+      else return readIcon_;
     } else if (QSqlTableModel::fieldIndex("starred") == index.column()) {
-      QPixmap icon;
       if (0 == index.data(Qt::EditRole).toInt())
-        icon.load(":/images/starOff");
-      else icon.load(":/images/starOn");
-      return icon;
+        return starOffIcon_;
+      else return starOnIcon_;
     } else if (QSqlTableModel::fieldIndex("feedId") == index.column()) {
-      QPixmap icon;
       int feedId = QSqlTableModel::index(index.row(), fieldIndex("feedId")).data(Qt::EditRole).toInt();
-      QModelIndex feedIndex = mainWindow->feedsModel_->indexById(feedId);
-      bool isFeed = (feedIndex.isValid() && mainWindow->feedsModel_->isFolder(feedIndex)) ? false : true;
-
-      if (feedIndex.isValid()) {
-        QByteArray byteArray = mainWindow->feedsModel_->dataField(feedIndex, "image").toByteArray();
-        if (!byteArray.isNull()) {
-          icon.loadFromData(QByteArray::fromBase64(byteArray));
-        } else if (isFeed) {
-          icon.load(":/images/feed");
-        } else {
-          icon.load(":/images/folder");
-        }
-      }
-
-      return icon;
+      return mainWindow->feedsModel_->iconById(feedId);
     } else if (QSqlTableModel::fieldIndex("label") == index.column()) {
       QIcon icon;
       QString strIdLabels = index.data(Qt::EditRole).toString();
@@ -36,6 +36,11 @@ signals:
 
 private:
   QTreeView *view_;
+  QPixmap newIcon_;
+  QPixmap unreadIcon_;
+  QPixmap readIcon_;
+  QPixmap starOnIcon_;
+  QPixmap starOffIcon_;
 
 };
 
@@ -209,21 +209,18 @@ NotificationWidget::NotificationWidget(QList<int> idFeedList,
       int idFeed = idFeedList[i];
       int cntNews;
 
-      qStr = QString("SELECT text, image, newCount FROM feeds WHERE id=='%1'").
+      qStr = QString("SELECT text, newCount FROM feeds WHERE id=='%1'").
           arg(idFeed);
       q.exec(qStr);
       if (q.next()) {
-        cntNews = q.value(2).toInt();
+        cntNews = q.value(1).toInt();
         if (!cntNews)
           continue;
 
         titleFeed = q.value(0).toString();
-        QByteArray byteArray = q.value(1).toByteArray();
-        if (!byteArray.isNull()) {
-          icon.loadFromData(QByteArray::fromBase64(byteArray));
-        } else {
+        icon = mainApp->mainWindow()->feedsModel_->iconById(idFeed);
+        if (icon.isNull())
           icon.load(":/images/feed");
-        }
       } else {
         continue;
       }
@@ -462,8 +462,13 @@ void OptionsDialog::createNetworkConnectionsWidget()
   timeoutRequest_->setRange(0, 300);
   numberRequests_ = new QSpinBox();
   numberRequests_->setRange(1, 10);
+  // QNetworkAccessManager keeps up to 6 connections per host
+  numberRequestsPerHost_ = new QSpinBox();
+  numberRequestsPerHost_->setRange(1, 6);
   numberRepeats_ = new QSpinBox();
   numberRepeats_->setRange(1, 10);
+  numberParseThreads_ = new QSpinBox();
+  numberParseThreads_->setRange(1, 16);
 
   /*
    * User agent
@@ -490,8 +495,12 @@ void OptionsDialog::createNetworkConnectionsWidget()
   requestLayout->addWidget(timeoutRequest_, 0, 1, 1, 1, Qt::AlignLeft);
   requestLayout->addWidget(new QLabel(tr("Number of requests:")), 1, 0);
   requestLayout->addWidget(numberRequests_, 1, 1, 1, 1, Qt::AlignLeft);
-  requestLayout->addWidget(new QLabel(tr("Number of retries:")), 2, 0);
-  requestLayout->addWidget(numberRepeats_, 2, 1, 1, 1, Qt::AlignLeft);
+  requestLayout->addWidget(new QLabel(tr("Number of requests per host:")), 2, 0);
+  requestLayout->addWidget(numberRequestsPerHost_, 2, 1, 1, 1, Qt::AlignLeft);
+  requestLayout->addWidget(new QLabel(tr("Number of retries:")), 3, 0);
+  requestLayout->addWidget(numberRepeats_, 3, 1, 1, 1, Qt::AlignLeft);
+  requestLayout->addWidget(new QLabel(tr("Number of parsing threads:")), 4, 0);
+  requestLayout->addWidget(numberParseThreads_, 4, 1, 1, 1, Qt::AlignLeft);
 
   networkConnectionsLayout->addWidget(new QLabel(tr("Options network requests when updating feeds (requires program restart):")));
   networkConnectionsLayout->addLayout(requestLayout);
@@ -2631,14 +2640,13 @@ void OptionsDialog::loadNotifier()
   parentIds.enqueue(0);
   while (!parentIds.empty()) {
     int parentId = parentIds.dequeue();
-    QString qStr = QString("SELECT text, id, image, xmlUrl FROM feeds WHERE parentId='%1' ORDER BY rowToParent").
+    QString qStr = QString("SELECT text, id, xmlUrl FROM feeds WHERE parentId='%1' ORDER BY rowToParent").
         arg(parentId);
     q.exec(qStr);
     while (q.next()) {
       QString feedText = q.value(0).toString();
       QString feedId = q.value(1).toString();
-      QByteArray byteArray = q.value(2).toByteArray();
-      QString xmlUrl = q.value(3).toString();
+      QString xmlUrl = q.value(2).toString();
 
       QStringList treeItem;
       treeItem << feedText << feedId;
@@ -2664,10 +2672,10 @@ void OptionsDialog::loadNotifier()
       if (xmlUrl.isEmpty()) {
         iconItem.load(":/images/folder");
       } else {
-        if (byteArray.isNull() || mainApp->mainWindow()->defaultIconFeeds_) {
+        if (mainApp->mainWindow()->defaultIconFeeds_) {
           iconItem.load(":/images/feed");
         } else {
-          iconItem.loadFromData(QByteArray::fromBase64(byteArray));
+          iconItem = mainApp->mainWindow()->feedsModel_->iconById(feedId.toInt());
         }
       }
       treeWidgetItem->setIcon(0, iconItem);
@@ -52,7 +52,9 @@ public:
 
   QSpinBox *timeoutRequest_;
   QSpinBox *numberRequests_;
+  QSpinBox *numberRequestsPerHost_;
   QSpinBox *numberRepeats_;
+  QSpinBox *numberParseThreads_;
 
   LineEdit *editUserAgent_;
 
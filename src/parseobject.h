@@ -3,42 +3,15 @@
 
 #include <QtSql>
 #include <QDateTime>
-#include <QDomDocument>
 #include <QQueue>
+#include <QSet>
+#include <QPair>
 #include <QObject>
 #include <QUrl>
 #include <QMutex>
+#include <QRecursiveMutex>
 
-struct FeedItemStruct {
-  QString title;
-  QString updated;
-  QString link;
-  QString linkBase;
-  QString language;
-  QString author;
-  QString authorUri;
-  QString authorEmail;
-  QString description;
-};
-
-struct NewsItemStruct {
-  QString id;
-  QString title;
-  QString updated;
-  QString link;
-  QString linkAlternate;
-  QString language;
-  QString author;
-  QString authorUri;
-  QString authorEmail;
-  QString description;
-  QString content;
-  QString category;
-  QString eUrl;
-  QString eType;
-  QString eLength;
-  QString comments;
-};
+#include "feedparser.h"
 
 struct FeedCountStruct{
   int feedId;
@@ -58,7 +31,7 @@ class ParseObject : public QObject
 {
   Q_OBJECT
 public:
-  explicit ParseObject(QObject *parent = 0);
+  explicit ParseObject(int workerId = 0, QObject *parent = 0);
   ~ParseObject();
 
   void disconnectObjects();
@@ -66,7 +39,7 @@ public:
 public slots:
   void parseXml(QByteArray data, int feedId,
                 QDateTime dtReply, QString codecName);
-  void runUserFilter(int feedId, int filterId = -1);
+  void runUserFilter(int feedId, int filterId = -1, int afterNewsId = 0);
 
 signals:
   void signalReadyParse(const QByteArray &xml, const int &feedId,
@@ -80,20 +53,28 @@ private slots:
   void getQueuedXml();
   void slotParse(const QByteArray &xmlData, const int &feedId,
                  const QDateTime &dtReply, const QString &codecName);
-  void addAtomNewsIntoBase(NewsItemStruct *newsItem);
-  void addRssNewsIntoBase(NewsItemStruct *newsItem);
 
 private:
-  void parseAtom(const QString &feedUrl, const QDomDocument &doc);
-  void parseRss(const QString &feedUrl, const QDomDocument &doc);
-  QString toPlainText(const QString &text);
-  QString fromPlainText(QString text);
-  QString getCommunity(const QDomNode &nodeContent);
-  QString parseDate(const QString &dateString, const QString &urlString);
+  bool isAtomNewsDuplicate(const NewsItemStruct &newsItem);
+  bool isRssNewsDuplicate(const NewsItemStruct &newsItem);
+  bool isOldNews(const NewsItemStruct &newsItem);
+  void buildDuplicateIndexes();
+  void clearDuplicateIndexes();
+  void updateFeedIntoBase();
+  void updatePublishInterval();
+  void prepareNewsQueries();
+  void addNewsIntoBase();
   int recountFeedCounts(int feedId, const QString &feedUrl,
-                        const QString &updated, const QString &lastBuildDate);
+                        const QString &updated, const QString &lastBuildDate,
+                        const FeedCountStruct &countsOld);
+
+  // Serialises the write phase of all parse workers
+  static QRecursiveMutex writeMutex_;
 
   QSqlDatabase db_;
+  QSqlQuery *identicalNewsQuery_;
+  QSqlQuery *insertAtomNewsQuery_;
+  QSqlQuery *insertRssNewsQuery_;
   QTimer *parseTimer_;
   QMutex mutex_;
   QQueue<int> idsQueue_;
@@ -108,10 +89,22 @@ private:
   bool avoidedOldSingleNews_;
   QDate avoidedOldSingleNewsDate_;
 
-  QStringList guidList_;
-  QStringList linkList_;
-  QStringList titleList_;
-  QStringList publishedList_;
+  // Duplicate search indexes over news stored for the feed being parsed
+  typedef QPair<QString, QString> NewsKey;
+  int storedNewsCount_;
+  QSet<QString> guidIndex_;
+  QSet<QString> linkIndex_;
+  QSet<QString> titleIndex_;
+  QSet<QString> publishedIndex_;
+  QSet<NewsKey> guidPublishedIndex_;
+  QSet<NewsKey> guidTitleIndex_;
+  QSet<NewsKey> linkPublishedIndex_;
+  QSet<NewsKey> linkTitleIndex_;
+  QSet<NewsKey> publishedTitleIndex_;
+
+  QString feedType_;
+  FeedItemStruct feedItem_;
+  QList<NewsItemStruct> newsList_;
 
   QDateTime lastBuildDate_;
 
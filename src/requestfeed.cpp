@@ -2,36 +2,47 @@
 #include "VersionNo.h"
 #include "mainapplication.h"
 #include "globals.h"
-#include "common.h"
+#include "contentdecoder.h"
+#include "feedsanitizer.h"
 
 #include <QDebug>
+#include <QRandomGenerator>
 #include <QtSql>
 #include <qzregexp.h>
 
 #define REPLY_MAX_COUNT 10
+#define RETRY_DELAY_BASE 1000   // ms
+#define RETRY_DELAY_MAX 60000   // ms
+#define HOST_FAILURES_MAX 5
 
 RequestFeed::RequestFeed(int timeoutRequest, int numberRequests,
-                         int numberRepeats, QObject *parent)
+                         int numberRepeats, int numberRequestsPerHost,
+                         QObject *parent)
   : QObject(parent)
   , networkManager_(NULL)
   , timeoutRequest_(timeoutRequest)
-  , numberRequests_(numberRequests)
+  , numberRequests_(qMin(numberRequests, REPLY_MAX_COUNT))
   , numberRepeats_(numberRepeats)
+  , numberRequestsPerHost_(qMax(1, numberRequestsPerHost))
+  , queuedCount_(0)
 {
   setObjectName("requestFeed_");
 
+  clock_.start();
   timeout_ = new QTimer(this);
-  timeout_->setInterval(1000);
+  timeout_->setSingleShot(true);
   connect(timeout_, SIGNAL(timeout()), this, SLOT(slotRequestTimeout()));
 
+  // Collects feeds queued at once before the first requests are sent,
+  // and waits for hosts to be retried
   getUrlTimer_ = new QTimer(this);
   getUrlTimer_->setSingleShot(true);
-  getUrlTimer_->setInterval(50);
   connect(getUrlTimer_, SIGNAL(timeout()), this, SLOT(getQueuedUrl()));
 
-  connect(this, SIGNAL(signalHead(QUrl,int,QString,QDateTime,int)),
-          SLOT(slotHead(QUrl,int,QString,QDateTime,int)),
-          Qt::QueuedConnection);
+  // Request is finished when its result is reported, next one can be sent
+  connect(this, SIGNAL(getUrlDone(int,int,QString,QString,QByteArray,QDateTime,QString,QString,QString)),
+          SLOT(slotRequestDone(int,int)));
+
   connect(this, SIGNAL(signalGet(QUrl,int,QString,QDateTime,int)),
           SLOT(slotGet(QUrl,int,QString,QDateTime,int)),
           Qt::QueuedConnection);
@@ -39,7 +50,10 @@ RequestFeed::RequestFeed(int timeoutRequest, int numberRequests,
 
 RequestFeed::~RequestFeed()
 {
-
+  foreach (const RequestState &state, requests_) {
+    delete state.decoder;
+    delete state.sanitizer;
+  }
 }
 
 void RequestFeed::disconnectObjects()
@@ -50,9 +64,12 @@ void RequestFeed::disconnectObjects()
 }
 
 /** @brief Put URL in request queue
+ * @details Feed already requested or queued is not queued again, its result
+ *   is reported once. State of request in progress is kept by feed id.
  *----------------------------------------------------------------------------*/
 void RequestFeed::requestUrl(int id, QString urlString,
-                              QDateTime date, QString userInfo)
+                              QDateTime date, QString userInfo,
+                              QString etag, QString lastModified)
 {
   if (!networkManager_) {
     networkManager_ = new NetworkManager(true, this);
@@ -60,98 +77,279 @@ void RequestFeed::requestUrl(int id, QString urlString,
             this, SLOT(finished(QNetworkReply*)));
   }
 
-  if (!timeout_->isActive())
-    timeout_->start();
+  QString host = QUrl(urlString).host();
+  bool queued = activeFeeds_.contains(id);
+  if (!queued) {
+    foreach (const QueuedFeed &queuedFeed, hostQueues_.value(host)) {
+      if (queuedFeed.id == id) {
+        queued = true;
+        break;
+      }
+    }
+  }
+  if (queued) {
+    qDebug() << "requestUrl() already queued:" << urlString;
+    return;
+  }
+
+  QueuedFeed feed;
+  feed.id = id;
+  feed.url = urlString;
+  feed.date = date;
+  feed.userInfo = userInfo;
+  feed.etag = etag;
+  feed.lastModified = lastModified;
+  feed.count = 0;
 
-  idsQueue_.enqueue(id);
-  feedsQueue_.enqueue(urlString);
-  dateQueue_.enqueue(date);
-  userInfo_.enqueue(userInfo);
+  if (!hostQueues_.contains(host))
+    hostsOrder_.enqueue(host);
+  hostQueues_[host].enqueue(feed);
+  queuedCount_++;
 
-  if (!getUrlTimer_->isActive())
-    getUrlTimer_->start();
+  getUrlTimer_->start(0);
 
-  qDebug() << "requestUrl() <<" << urlString << "countQueue=" << feedsQueue_.count();
+  qDebug() << "requestUrl() <<" << urlString << "countQueue=" << queuedCount_;
 }
 
 void RequestFeed::stopRequest()
 {
-  while (!feedsQueue_.isEmpty()) {
-    int feedId = idsQueue_.dequeue();
-    QString feedUrl = feedsQueue_.dequeue();
-    dateQueue_.clear();
-    userInfo_.clear();
-
-    emit getUrlDone(feedsQueue_.count(), feedId, feedUrl);
+  while (!hostsOrder_.isEmpty()) {
+    QQueue<QueuedFeed> queue = hostQueues_.take(hostsOrder_.dequeue());
+    while (!queue.isEmpty()) {
+      QueuedFeed feed = queue.dequeue();
+      queuedCount_--;
+      emit getUrlDone(queuedCount_, feed.id, feed.url);
+    }
   }
 }
 
-/** @brief Process request queue on timer timeouts
+/** @brief Number of simultaneous requests allowed for \a host
+ *----------------------------------------------------------------------------*/
+int RequestFeed::hostLimit(const QString &host) const
+{
+  // Host has replied "Service Temporarily Unavailable" before
+  if (hostList_.contains(host))
+    return 1;
+  return numberRequestsPerHost_;
+}
+
+/** @brief Send queued requests while there are free slots
+ * @details Hosts take turns, so a busy host does not hold back the others.
+ *   Hosts waiting for retry are skipped until their time comes.
  *----------------------------------------------------------------------------*/
 void RequestFeed::getQueuedUrl()
 {
-  if ((currentFeeds_.count() >= numberRequests_) ||
-      (currentFeeds_.count() >= REPLY_MAX_COUNT)) {
-    getUrlTimer_->start();
-    return;
-  }
+  qint64 now = clock_.elapsed();
+  qint64 waitUntil = -1;
+  int hostsCount = hostsOrder_.count();
+  while ((activeFeeds_.count() < numberRequests_) && hostsCount) {
+    QString host = hostsOrder_.dequeue();
+    HostState hostState = hosts_.value(host, HostState{0, 0});
+    if (hostState.failures >= HOST_FAILURES_MAX) {
+      failQueuedFeeds(host);
+      hostsCount = hostsOrder_.count();
+      continue;
+    }
+    if (hostState.retryAt > now) {
+      if ((waitUntil < 0) || (hostState.retryAt < waitUntil))
+        waitUntil = hostState.retryAt;
+      hostsOrder_.enqueue(host);
+      hostsCount--;
+      continue;
+    }
+    if (activeHosts_.value(host) >= hostLimit(host)) {
+      hostsOrder_.enqueue(host);
+      hostsCount--;
+      continue;
+    }
 
-  if (!feedsQueue_.isEmpty()) {
-    getUrlTimer_->start();
-    QString feedUrl = feedsQueue_.head();
+    QQueue<QueuedFeed> &queue = hostQueues_[host];
+    QueuedFeed feed = queue.dequeue();
+    queuedCount_--;
+    if (queue.isEmpty()) {
+      hostQueues_.remove(host);
+    } else {
+      hostsOrder_.enqueue(host);
+    }
+    hostsCount = hostsOrder_.count();
 
-    if (hostList_.contains(QUrl(feedUrl).host())) {
-      foreach (QString url, currentFeeds_) {
-        if (QUrl(url).host() == QUrl(feedUrl).host()) {
-          return;
-        }
+    activeFeeds_.insert(feed.id, host);
+    activeHosts_[host]++;
+
+    emit setStatusFeed(feed.id, "1 Update");
+
+    QUrl getUrl = feed.getUrl;
+    if (getUrl.isEmpty()) {
+      getUrl = QUrl::fromEncoded(feed.url.toUtf8());
+      if (!feed.userInfo.isEmpty()) {
+        getUrl.setUserInfo(feed.userInfo);
+//        getUrl.addQueryItem("auth", getUrl.scheme());
       }
     }
-    int feedId = idsQueue_.dequeue();
-    feedUrl = feedsQueue_.dequeue();
 
-    emit setStatusFeed(feedId, "1 Update");
+    qDebug() << "getQueuedUrl() >>" << feed.url << "countQueue=" << queuedCount_;
+    // Replaces validators left from previous update of the feed
+    validators_.insert(feed.id, qMakePair(feed.etag, feed.lastModified));
+    emit signalGet(getUrl, feed.id, feed.url, feed.date, feed.count);
+  }
+
+  if ((waitUntil >= 0) && (activeFeeds_.count() < numberRequests_))
+    getUrlTimer_->start(qMax(qint64(0), waitUntil - now));
+}
+
+/** @brief Free slot of finished request and send next one
+ *----------------------------------------------------------------------------*/
+void RequestFeed::slotRequestDone(int result, int feedId)
+{
+  Q_UNUSED(result)
+
+  if (!activeFeeds_.contains(feedId))
+    return;
+
+  releaseRequest(feedId);
+  getQueuedUrl();
+}
+
+void RequestFeed::releaseRequest(int feedId)
+{
+  QString host = activeFeeds_.take(feedId);
+  if (--activeHosts_[host] <= 0)
+    activeHosts_.remove(host);
+}
+
+/** @brief Delay before next retry of request
+ * @param retryAfter - value of Retry-After header (seconds or HTTP-date)
+ * @param count - number of the retry
+ * @return delay in ms, -1 if server asks to wait too long
+ *----------------------------------------------------------------------------*/
+qint64 RequestFeed::retryDelay(const QByteArray &retryAfter, int count) const
+{
+  if (!retryAfter.isEmpty()) {
+    bool ok;
+    qint64 delay = retryAfter.trimmed().toLongLong(&ok) * 1000;
+    if (!ok) {
+      QDateTime date = QDateTime::fromString(QString::fromLatin1(retryAfter.trimmed()),
+                                             Qt::RFC2822Date);
+      ok = date.isValid();
+      if (ok)
+        delay = QDateTime::currentDateTimeUtc().msecsTo(date);
+    }
+    if (ok) {
+      if (delay > RETRY_DELAY_MAX)
+        return -1;
+      return qMax(qint64(0), delay);
+    }
+  }
+
+  // Exponential backoff with jitter of +-25%
+  qint64 delay = qMin(qint64(RETRY_DELAY_BASE) << qBound(0, count - 1, 6),
+                      qint64(RETRY_DELAY_MAX));
+  delay += QRandomGenerator::global()->bounded(int(delay / 2) + 1) - delay / 4;
+  return delay;
+}
 
-    QUrl getUrl = QUrl::fromEncoded(feedUrl.toUtf8());
-    QString userInfo = userInfo_.dequeue();
-    if (!userInfo.isEmpty()) {
-      getUrl.setUserInfo(userInfo);
-//      getUrl.addQueryItem("auth", getUrl.scheme());
+/** @brief Time until received feed data stays fresh
+ * @details Taken from Cache-Control max-age (less Age) or from Expires.
+ * @return invalid date if server does not tell or forbids caching
+ *----------------------------------------------------------------------------*/
+QDateTime RequestFeed::cacheExpires(QNetworkReply *reply) const
+{
+  QDateTime currentDate = QDateTime::currentDateTimeUtc();
+
+  QList<QByteArray> directives = reply->rawHeader("Cache-Control").toLower().split(',');
+  foreach (QByteArray directive, directives) {
+    directive = directive.trimmed();
+    if ((directive == "no-cache") || (directive == "no-store"))
+      return QDateTime();
+    if (directive.startsWith("max-age=")) {
+      bool ok;
+      qint64 maxAge = directive.mid(8).toLongLong(&ok);
+      if (ok) {
+        qint64 age = reply->rawHeader("Age").trimmed().toLongLong();
+        return currentDate.addSecs(qMax(qint64(0), maxAge - age));
+      }
     }
+  }
 
-    qDebug() << "getQueuedUrl() >>" << feedUrl << "countQueue=" << feedsQueue_.count();
-    QDateTime currentDate = dateQueue_.dequeue();
-    if (currentDate.isValid())
-      emit signalHead(getUrl, feedId, feedUrl, currentDate);
-    else
-      emit signalGet(getUrl, feedId, feedUrl, currentDate);
+  QByteArray expires = reply->rawHeader("Expires").trimmed();
+  if (!expires.isEmpty()) {
+    QDateTime date = QDateTime::fromString(QString::fromLatin1(expires), Qt::RFC2822Date);
+    if (date.isValid())
+      return date.toUTC();
   }
+  return QDateTime();
 }
 
-/** @brief Prepare and send network request to get head
+/** @brief Check if reply from cache holds data which has been received before
+ * @details Cache answers so on its own freshness or on 304 from server, when
+ *   it has the same validators that were sent with conditional GET.
  *----------------------------------------------------------------------------*/
-void RequestFeed::slotHead(const QUrl &getUrl, const int &id, const QString &feedUrl,
-                            const QDateTime &date, const int &count)
+bool RequestFeed::isCachedUnchanged(QNetworkReply *reply) const
 {
-  if (count)
-    Common::sleep(30);
+  if (!reply->attribute(QNetworkRequest::SourceIsFromCacheAttribute).toBool())
+    return false;
+
+  QByteArray etag = reply->request().rawHeader("If-None-Match");
+  if (!etag.isEmpty() && (etag == reply->rawHeader("ETag")))
+    return true;
+  QByteArray lastModified = reply->request().rawHeader("If-Modified-Since");
+  if (!lastModified.isEmpty() && (lastModified == reply->rawHeader("Last-Modified")))
+    return true;
+  return false;
+}
 
-  qDebug() << objectName() << "::head:" << getUrl.toEncoded() << "feed:" << feedUrl << "countRepeats:" << count;
-  QNetworkRequest request(getUrl);
-  request.setRawHeader("User-Agent", globals.userAgent().toUtf8());
+/** @brief Count failure of host of feed \a feedId
+ * @return true if host has failed too many times during this update
+ *----------------------------------------------------------------------------*/
+bool RequestFeed::hostFailed(int feedId)
+{
+  HostState &hostState = hosts_[activeFeeds_.value(feedId)];
+  hostState.failures++;
+  return (hostState.failures >= HOST_FAILURES_MAX);
+}
 
-  currentUrls_.append(getUrl);
-  currentIds_.append(id);
-  currentFeeds_.append(feedUrl);
-  currentDates_.append(date);
-  currentCount_.append(count);
-  currentHead_.append(true);
-  currentTime_.append(timeoutRequest_);
+/** @brief Put request back in host queue to be sent after \a delay ms
+ * @details Request slot is freed while it waits, and other requests to the
+ *   same host wait too.
+ *----------------------------------------------------------------------------*/
+void RequestFeed::retryRequest(const QUrl &getUrl, int feedId, const QString &feedUrl,
+                               const QDateTime &date, int count, qint64 delay)
+{
+  QString host = activeFeeds_.value(feedId);
+  HostState &hostState = hosts_[host];
+  hostState.retryAt = qMax(hostState.retryAt, clock_.elapsed() + delay);
+  qDebug() << objectName() << "  retry in" << delay << "ms:" << feedUrl;
+
+  QPair<QString, QString> validators = validators_.value(feedId);
+  QueuedFeed feed;
+  feed.id = feedId;
+  feed.url = feedUrl;
+  feed.date = date;
+  feed.etag = validators.first;
+  feed.lastModified = validators.second;
+  feed.getUrl = getUrl;
+  feed.count = count;
+
+  if (!hostQueues_.contains(host))
+    hostsOrder_.enqueue(host);
+  hostQueues_[host].prepend(feed);
+  queuedCount_++;
+
+  releaseRequest(feedId);
+  getQueuedUrl();
+}
 
-  QNetworkReply *reply = networkManager_->head(request);
-  reply->setProperty("feedReply", QVariant(true));
-  requestUrl_.append(reply->url());
-  networkReply_.append(reply);
+/** @brief Fail queued feeds of host that does not respond
+ *----------------------------------------------------------------------------*/
+void RequestFeed::failQueuedFeeds(const QString &host)
+{
+  hostsOrder_.removeAll(host);
+  QQueue<QueuedFeed> queue = hostQueues_.take(host);
+  while (!queue.isEmpty()) {
+    QueuedFeed feed = queue.dequeue();
+    queuedCount_--;
+    emit getUrlDone(-1, feed.id, feed.url, tr("Server is not responding!"));
+  }
 }
 
 /** @brief Prepare and send network request to get all data
@@ -159,26 +357,40 @@ void RequestFeed::slotHead(const QUrl &getUrl, const int &id, const QString &fee
 void RequestFeed::slotGet(const QUrl &getUrl, const int &id, const QString &feedUrl,
                            const QDateTime &date, const int &count)
 {
-  if (count)
-    Common::sleep(30);
-
   qDebug() << objectName() << "::get:" << getUrl.toEncoded() << "feed:" << feedUrl << "countRepeats:" <<count;
   QNetworkRequest request(getUrl);
   request.setRawHeader("Accept", "application/atom+xml,application/rss+xml;q=0.9,application/xml;q=0.8,text/xml;q=0.7,*/*;q=0.6");
   request.setRawHeader("User-Agent", globals.userAgent().toUtf8());
+  // Reply is decoded by ContentDecoder, QNetworkAccessManager leaves it as is
+  request.setRawHeader("Accept-Encoding", ContentDecoder::acceptEncoding());
 
-  currentUrls_.append(getUrl);
-  currentIds_.append(id);
-  currentFeeds_.append(feedUrl);
-  currentDates_.append(date);
-  currentCount_.append(count);
-  currentHead_.append(false);
-  currentTime_.append(timeoutRequest_);
+  // Reply may come from shared disk cache only while it is fresh
+  request.setAttribute(QNetworkRequest::CacheLoadControlAttribute,
+                       QNetworkRequest::PreferNetwork);
+
+  // Conditional GET, server replies 304 if feed is unchanged
+  QPair<QString, QString> validators = validators_.value(id);
+  if (!validators.first.isEmpty())
+    request.setRawHeader("If-None-Match", validators.first.toLatin1());
+  if (!validators.second.isEmpty())
+    request.setRawHeader("If-Modified-Since", validators.second.toLatin1());
 
   QNetworkReply *reply = networkManager_->get(request);
   reply->setProperty("feedReply", QVariant(true));
-  requestUrl_.append(reply->url());
-  networkReply_.append(reply);
+  connect(reply, SIGNAL(readyRead()), this, SLOT(slotReadyRead()));
+
+  RequestState state;
+  state.url = getUrl;
+  state.feedId = id;
+  state.feedUrl = feedUrl;
+  state.date = date;
+  state.count = count;
+  state.deadline = clock_.elapsed() + qMax(1, timeoutRequest_) * 1000;
+  state.decoder = NULL;
+  state.sanitizer = NULL;
+  requests_.insert(reply, state);
+  deadlines_.insert(state.deadline, reply);
+  startTimeoutTimer();
 }
 
 /** @brief Process network reply
@@ -195,159 +407,197 @@ void RequestFeed::finished(QNetworkReply *reply)
   qDebug() << reply->header(QNetworkRequest::CookieHeader);
   qDebug() << reply->header(QNetworkRequest::SetCookieHeader);
 
-  int currentReplyIndex = currentUrls_.indexOf(replyUrl);
-
-  if (currentReplyIndex >= 0) {
-    currentTime_.removeAt(currentReplyIndex);
-    currentUrls_.removeAt(currentReplyIndex);
-    int feedId    = currentIds_.takeAt(currentReplyIndex);
-    QString feedUrl    = currentFeeds_.takeAt(currentReplyIndex);
-    QDateTime feedDate = currentDates_.takeAt(currentReplyIndex);
-    int count = currentCount_.takeAt(currentReplyIndex) + 1;
-    bool headOk = currentHead_.takeAt(currentReplyIndex);
-
-    if (reply->error() != QNetworkReply::NoError) {
-      qDebug() << "  error retrieving RSS feed:" << reply->error() << reply->errorString();
-      if (!headOk) {
-        if (reply->error() == QNetworkReply::AuthenticationRequiredError)
-          emit getUrlDone(-2, feedId, feedUrl, tr("Server requires authentication!"));
-        else if (reply->error() == QNetworkReply::ContentNotFoundError)
-          emit getUrlDone(-5, feedId, feedUrl, tr("Server replied: Not Found!"));
-        else {
-          if (reply->errorString().contains("Service Temporarily Unavailable")) {
-            if (!hostList_.contains(QUrl(feedUrl).host())) {
-              hostList_.append(QUrl(feedUrl).host());
-              count--;
-            }
-          }
-
-          if (count < numberRepeats_) {
-            emit signalGet(replyUrl, feedId, feedUrl, feedDate, count);
-          } else {
-            emit getUrlDone(-1, feedId, feedUrl, QString("%1 (%2)").arg(reply->errorString()).arg(reply->error()));
-          }
+  QHash<QNetworkReply*, RequestState>::iterator it = requests_.find(reply);
+  if (it == requests_.end()) {
+    // Request has been dropped on timeout
+    qDebug() << "  request has been dropped:" << replyUrl.toString();
+    reply->deleteLater();
+    return;
+  }
+  RequestState state = it.value();
+  requests_.erase(it);
+  deadlines_.remove(state.deadline, reply);
+  startTimeoutTimer();
+
+  ContentDecoder *decoder = state.decoder;
+  FeedSanitizer *sanitizer = state.sanitizer;
+  if (!decoder) {
+    decoder = new ContentDecoder(reply->rawHeader("Content-Encoding"));
+    sanitizer = new FeedSanitizer();
+  }
+  decoder->write(reply->readAll());
+  sanitizer->write(decoder->takeData());
+  bool fromCache = reply->attribute(QNetworkRequest::SourceIsFromCacheAttribute).toBool();
+  transfer_.repliesCount++;
+  if (fromCache)
+    transfer_.cachedRepliesCount++;
+  else
+    transfer_.receivedBytes += decoder->encodedBytes();
+  transfer_.decodedBytes += decoder->decodedBytes();
+
+  int feedId = state.feedId;
+  QString feedUrl = state.feedUrl;
+  QDateTime feedDate = state.date;
+  int count = state.count + 1;
+
+  if (reply->error() != QNetworkReply::NoError) {
+    qDebug() << "  error retrieving RSS feed:" << reply->error() << reply->errorString();
+    if (reply->error() == QNetworkReply::AuthenticationRequiredError)
+      emit getUrlDone(-2, feedId, feedUrl, tr("Server requires authentication!"));
+    else if (reply->error() == QNetworkReply::ContentNotFoundError)
+      emit getUrlDone(-5, feedId, feedUrl, tr("Server replied: Not Found!"));
+    else {
+      if (reply->errorString().contains("Service Temporarily Unavailable")) {
+        if (!hostList_.contains(QUrl(feedUrl).host())) {
+          hostList_.append(QUrl(feedUrl).host());
+          count--;
         }
+      }
+
+      bool hostBroken = hostFailed(feedId);
+      qint64 delay = retryDelay(reply->rawHeader("Retry-After"), count);
+      if ((count < numberRepeats_) && (delay >= 0) && !hostBroken) {
+        retryRequest(replyUrl, feedId, feedUrl, feedDate, count, delay);
       } else {
-        emit signalGet(replyUrl, feedId, feedUrl, feedDate);
+        emit getUrlDone(-1, feedId, feedUrl, QString("%1 (%2)").arg(reply->errorString()).arg(reply->error()));
       }
-    } else {
-      QUrl redirectionTarget = reply->attribute(QNetworkRequest::RedirectionTargetAttribute).toUrl();
-      if (redirectionTarget.isValid()) {
-        if (count < (numberRepeats_ + 3)) {
-          if (headOk && (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 302)) {
-            emit signalGet(replyUrl, feedId, feedUrl, feedDate);
-          } else {
-            QString host(QUrl::fromEncoded(feedUrl.toUtf8()).host());
-            if (redirectionTarget.host().isEmpty()) {
-              if (redirectionTarget.path() == ".") {
-                if (redirectionTarget.hasQuery()) {
-                  QString query = redirectionTarget.query();
-                  redirectionTarget.setUrl(replyUrl.scheme() + "://" + host + replyUrl.path());
-                  redirectionTarget.setQuery(query);
-                }
-              } else {
-                redirectionTarget.setUrl(replyUrl.scheme() + "://" + host + redirectionTarget.toString());
-              }
-            }
-            if (redirectionTarget.scheme().isEmpty())
-              redirectionTarget.setScheme(QUrl(feedUrl).scheme());
-            if (reply->operation() == QNetworkAccessManager::HeadOperation) {
-              qDebug() << objectName() << "  head redirect..." << redirectionTarget.toString();
-              emit signalHead(redirectionTarget, feedId, feedUrl, feedDate, count);
-            }
-            else {
-              qDebug() << objectName() << "  get redirect..." << redirectionTarget.toString();
-              emit signalGet(redirectionTarget, feedId, feedUrl, feedDate, count);
+    }
+  } else {
+    // Host responds again, but waits out retry time asked by it before
+    QHash<QString, HostState>::iterator hostIt = hosts_.find(activeFeeds_.value(feedId));
+    if (hostIt != hosts_.end())
+      hostIt->failures = 0;
+
+    QUrl redirectionTarget = reply->attribute(QNetworkRequest::RedirectionTargetAttribute).toUrl();
+    if (redirectionTarget.isValid()) {
+      if (count < (numberRepeats_ + 3)) {
+        QString host(QUrl::fromEncoded(feedUrl.toUtf8()).host());
+        if (redirectionTarget.host().isEmpty()) {
+          if (redirectionTarget.path() == ".") {
+            if (redirectionTarget.hasQuery()) {
+              QString query = redirectionTarget.query();
+              redirectionTarget.setUrl(replyUrl.scheme() + "://" + host + replyUrl.path());
+              redirectionTarget.setQuery(query);
             }
+          } else {
+            redirectionTarget.setUrl(replyUrl.scheme() + "://" + host + redirectionTarget.toString());
           }
-        } else {
-          emit getUrlDone(-4, feedId, feedUrl, tr("Redirect error!"));
         }
+        if (redirectionTarget.scheme().isEmpty())
+          redirectionTarget.setScheme(QUrl(feedUrl).scheme());
+        qDebug() << objectName() << "  get redirect..." << redirectionTarget.toString();
+        emit signalGet(redirectionTarget, feedId, feedUrl, feedDate, count);
       } else {
-        QDateTime replyDate = reply->header(QNetworkRequest::LastModifiedHeader).toDateTime();
-        QDateTime replyLocalDate = QDateTime(replyDate.date(), replyDate.time());
-
-        qDebug() << feedDate << replyDate << replyLocalDate;
-        qDebug() << feedDate.toMSecsSinceEpoch() << replyDate.toMSecsSinceEpoch() << replyLocalDate.toMSecsSinceEpoch();
-        if ((reply->operation() == QNetworkAccessManager::HeadOperation) &&
-            ((!feedDate.isValid()) || (!replyLocalDate.isValid()) ||
-             (feedDate != replyLocalDate) || !replyDate.toMSecsSinceEpoch())) {
-          emit signalGet(replyUrl, feedId, feedUrl, feedDate);
+        emit getUrlDone(-4, feedId, feedUrl, tr("Redirect error!"));
+      }
+    } else {
+      QDateTime replyDate = reply->header(QNetworkRequest::LastModifiedHeader).toDateTime();
+      QDateTime replyLocalDate = QDateTime(replyDate.date(), replyDate.time());
+
+      qDebug() << feedDate << replyDate << replyLocalDate;
+      qDebug() << feedDate.toMSecsSinceEpoch() << replyDate.toMSecsSinceEpoch() << replyLocalDate.toMSecsSinceEpoch();
+      if ((reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 304) ||
+          isCachedUnchanged(reply)) {
+        qDebug() << objectName() << "  not modified:" << feedUrl;
+        emit getUrlDone(queuedCount_, feedId, feedUrl, "", QByteArray(), QDateTime(), "",
+                        "", "", cacheExpires(reply));
+      }
+      else if (decoder->hasError()) {
+        emit getUrlDone(-1, feedId, feedUrl, tr("Error decoding content (%1)!").
+                        arg(QString::fromLatin1(reply->rawHeader("Content-Encoding"))));
+      }
+      else {
+        QString codecName;
+        QzRegExp rx("charset=([^\t]+)$", Qt::CaseInsensitive);
+        int pos = rx.indexIn(reply->header(QNetworkRequest::ContentTypeHeader).toString());
+        if (pos > -1) {
+          codecName = rx.cap(1);
         }
-        else {
-          QString codecName;
-          QzRegExp rx("charset=([^\t]+)$", Qt::CaseInsensitive);
-          int pos = rx.indexIn(reply->header(QNetworkRequest::ContentTypeHeader).toString());
-          if (pos > -1) {
-            codecName = rx.cap(1);
-          }
 
-          QByteArray data = reply->readAll();
-          data = data.trimmed();
+        QByteArray data = sanitizer->finish();
 
-          rx.setPattern("&(?!([a-z0-9#]+;))");
-          pos = 0;
-          while ((pos = rx.indexIn(QString::fromLatin1(data), pos)) != -1) {
-            data.replace(pos, 1, "&amp;");
-            pos += 1;
-          }
+        qDebug() << objectName() << "  received:" << decoder->encodedBytes()
+                 << "decoded:" << decoder->decodedBytes() << feedUrl;
 
-          data.replace("<br>", "<br/>");
+        emit getUrlDone(queuedCount_, feedId, feedUrl, "", data, replyLocalDate, codecName,
+                        QString::fromLatin1(reply->rawHeader("ETag")),
+                        QString::fromLatin1(reply->rawHeader("Last-Modified")),
+                        cacheExpires(reply));
+      }
+    }
+  }
 
-          if (data.indexOf("</rss>") > 0)
-            data.resize(data.indexOf("</rss>") + 6);
-          if (data.indexOf("</feed>") > 0)
-            data.resize(data.indexOf("</feed>") + 7);
-          if (data.indexOf("</rdf:RDF>") > 0)
-            data.resize(data.indexOf("</rdf:RDF>") + 10);
+  delete decoder;
+  delete sanitizer;
+  reply->abort();
+  reply->deleteLater();
 
-          emit getUrlDone(feedsQueue_.count(), feedId, feedUrl, "", data, replyLocalDate, codecName);
-        }
-      }
+  if (activeFeeds_.isEmpty() && !queuedCount_) {
+    // Failed hosts are tried again on next update
+    hosts_.clear();
+    if (transfer_.repliesCount) {
+      qDebug() << "Feeds transfer: received" << transfer_.receivedBytes << "bytes, decoded"
+               << transfer_.decodedBytes << "bytes," << transfer_.cachedRepliesCount << "of"
+               << transfer_.repliesCount << "replies from cache";
+      emit transferDone(transfer_);
+      transfer_ = TransferStats();
     }
-  } else {
-    qCritical() << "Request Url error: " << replyUrl.toString() << reply->errorString();
   }
+}
 
-  int replyIndex = requestUrl_.indexOf(replyUrl);
-  if (replyIndex >= 0) {
-    requestUrl_.removeAt(replyIndex);
-    networkReply_.removeAt(replyIndex);
+/** @brief Decode and fix reply data as it arrives
+ *----------------------------------------------------------------------------*/
+void RequestFeed::slotReadyRead()
+{
+  QNetworkReply *reply = qobject_cast<QNetworkReply*>(sender());
+  if (!reply) return;
+
+  QHash<QNetworkReply*, RequestState>::iterator it = requests_.find(reply);
+  if (it == requests_.end()) return;
+
+  if (!it->decoder) {
+    it->decoder = new ContentDecoder(reply->rawHeader("Content-Encoding"));
+    it->sanitizer = new FeedSanitizer();
   }
+  it->decoder->write(reply->readAll());
+  it->sanitizer->write(it->decoder->takeData());
+}
 
-  reply->abort();
-  reply->deleteLater();
+/** @brief Start timer for the earliest request deadline
+ *----------------------------------------------------------------------------*/
+void RequestFeed::startTimeoutTimer()
+{
+  if (deadlines_.isEmpty()) {
+    timeout_->stop();
+    return;
+  }
+  timeout_->start(qMax(qint64(0), deadlines_.firstKey() - clock_.elapsed()));
 }
 
 /** @brief Timeout to delete network requests which has no answer
  *----------------------------------------------------------------------------*/
 void RequestFeed::slotRequestTimeout()
 {
-  for (int i = currentTime_.count() - 1; i >= 0; i--) {
-    int time = currentTime_.at(i) - 1;
-    if (time <= 0) {
-      QUrl url = currentUrls_.takeAt(i);
-      int feedId    = currentIds_.takeAt(i);
-      QString feedUrl = currentFeeds_.takeAt(i);
-      QDateTime feedDate = currentDates_.takeAt(i);
-      int count = currentCount_.takeAt(i) + 1;
-      currentTime_.removeAt(i);
-      currentHead_.removeAt(i);
-
-      int replyIndex = requestUrl_.indexOf(url);
-      if (replyIndex >= 0) {
-        QUrl replyUrl = requestUrl_.takeAt(replyIndex);
-        QNetworkReply *reply = networkReply_.takeAt(replyIndex);
-        reply->deleteLater();
-
-        if (count < numberRepeats_) {
-          emit signalGet(replyUrl, feedId, feedUrl, feedDate, count);
-        } else {
-          emit getUrlDone(-3, feedId, feedUrl, tr("Request timeout!"));
-        }
-      }
+  qint64 now = clock_.elapsed();
+  while (!deadlines_.isEmpty() && (deadlines_.firstKey() <= now)) {
+    QNetworkReply *reply = deadlines_.begin().value();
+    deadlines_.erase(deadlines_.begin());
+
+    RequestState state = requests_.take(reply);
+    delete state.decoder;
+    delete state.sanitizer;
+    // Aborted reply is not in requests_ anymore, so finished() skips it
+    reply->abort();
+    reply->deleteLater();
+
+    int count = state.count + 1;
+    bool hostBroken = hostFailed(state.feedId);
+    if ((count < numberRepeats_) && !hostBroken) {
+      retryRequest(state.url, state.feedId, state.feedUrl, state.date, count,
+                   retryDelay(QByteArray(), count));
     } else {
-      currentTime_.replace(i, time);
+      emit getUrlDone(-3, state.feedId, state.feedUrl, tr("Request timeout!"));
     }
   }
+  startTimeoutTimer();
 }
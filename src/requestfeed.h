@@ -2,6 +2,8 @@
 #define REQUESTFEED_H
 
 #include <QDateTime>
+#include <QHash>
+#include <QMap>
 #include <QObject>
 #include <QQueue>
 #include <QNetworkReply>
@@ -10,64 +12,116 @@
 
 #include "networkmanager.h"
 
+class ContentDecoder;
+class FeedSanitizer;
+
 class RequestFeed : public QObject
 {
   Q_OBJECT
 public:
   explicit RequestFeed(int timeoutRequest, int numberRequests,
-                       int numberRepeats, QObject *parent = 0);
+                       int numberRepeats, int numberRequestsPerHost,
+                       QObject *parent = 0);
   ~RequestFeed();
 
   void disconnectObjects();
 
 public slots:
-  void requestUrl(int id, QString urlString, QDateTime date, QString userInfo = "");
+  void requestUrl(int id, QString urlString, QDateTime date, QString userInfo = "",
+                  QString etag = "", QString lastModified = "");
   void stopRequest();
-  void slotHead(const QUrl &getUrl, const int &id, const QString &feedUrl,
-                const QDateTime &date, const int &count);
   void slotGet(const QUrl &getUrl, const int &id, const QString &feedUrl,
                const QDateTime &date, const int &count);
 
 signals:
   void getUrlDone(int result, int feedId, QString feedUrl = "",
                   QString error = "", QByteArray data = NULL,
-                  QDateTime dtReply = QDateTime(), QString codecName = "");
-  void signalHead(const QUrl &getUrl, const int &id, const QString &feedUrl,
-                  const QDateTime &date, const int &count = 0);
+                  QDateTime dtReply = QDateTime(), QString codecName = "",
+                  QString etag = "", QString lastModified = "",
+                  QDateTime cacheExpires = QDateTime());
   void signalGet(const QUrl &getUrl, const int &id, const QString &feedUrl,
                  const QDateTime &date, const int &count = 0);
   void setStatusFeed(int feedId, QString status);
+  void transferDone(TransferStats stats);
 
 private slots:
   void getQueuedUrl();
+  void slotRequestDone(int result, int feedId);
   void finished(QNetworkReply *reply);
   void slotRequestTimeout();
+  void slotReadyRead();
 
 private:
+  struct QueuedFeed {
+    int id;
+    QString url;
+    QDateTime date;
+    QString userInfo;
+    QString etag;
+    QString lastModified;
+    QUrl getUrl;  // URL to retry, empty for first request
+    int count;    // number of retries
+  };
+
+  // Failures of host during current update
+  struct HostState {
+    int failures;
+    qint64 retryAt;
+  };
+
+  // State of request in progress
+  struct RequestState {
+    QUrl url;
+    int feedId;
+    QString feedUrl;
+    QDateTime date;
+    int count;
+    qint64 deadline;
+    ContentDecoder *decoder;
+    FeedSanitizer *sanitizer;
+  };
+
+  int hostLimit(const QString &host) const;
+  void releaseRequest(int feedId);
+  qint64 retryDelay(const QByteArray &retryAfter, int count) const;
+  QDateTime cacheExpires(QNetworkReply *reply) const;
+  bool isCachedUnchanged(QNetworkReply *reply) const;
+  bool hostFailed(int feedId);
+  void retryRequest(const QUrl &getUrl, int feedId, const QString &feedUrl,
+                    const QDateTime &date, int count, qint64 delay);
+  void failQueuedFeeds(const QString &host);
+  void startTimeoutTimer();
+
   NetworkManager *networkManager_;
 
   int timeoutRequest_;
   int numberRequests_;
   int numberRepeats_;
+  int numberRequestsPerHost_;
   QTimer *timeout_;
   QTimer *getUrlTimer_;
 
-  QQueue<int> idsQueue_;
-  QQueue<QString> feedsQueue_;
-  QQueue<QDateTime> dateQueue_;
-  QQueue<QString> userInfo_;
-
-  QList<QUrl> currentUrls_;
-  QList<int> currentIds_;
-  QList<QString> currentFeeds_;
-  QList<QDateTime> currentDates_;
-  QList<int> currentCount_;
-  QList<bool> currentHead_;
-  QList<int> currentTime_;
-  QList<QUrl> requestUrl_;
-  QList<QNetworkReply*> networkReply_;
+  // Queued feeds by host, hosts are served round-robin
+  QHash<QString, QQueue<QueuedFeed> > hostQueues_;
+  QQueue<QString> hostsOrder_;
+  int queuedCount_;
+  // Feeds being requested: feedId -> host
+  QHash<int, QString> activeFeeds_;
+  QHash<QString, int> activeHosts_;
+  QHash<QString, HostState> hosts_;
+
+  // Validators for conditional GET: feedId -> (ETag, Last-Modified)
+  QHash<int, QPair<QString, QString> > validators_;
+
+  QHash<QNetworkReply*, RequestState> requests_;
+  // Requests ordered by deadline, timer is set to the earliest one
+  QMultiMap<qint64, QNetworkReply*> deadlines_;
+  QElapsedTimer clock_;
   QList<QString> hostList_;
 
+  // Transfer since queue was empty
+  TransferStats transfer_;
+
 };
 
 #endif // REQUESTFEED_H
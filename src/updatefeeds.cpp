@@ -4,17 +4,40 @@
 #include "database.h"
 #include "settings.h"
 
+#include <QCryptographicHash>
 #include <QDebug>
 #include <qzregexp.h>
 
 #define UPDATE_INTERVAL 3000
 #define UPDATE_INTERVAL_MIN 500
 
+#define FAVICON_REFRESH_INTERVAL 14      // days
+#define FAVICON_FAILURE_TTL_MAX 30       // days
+#define FAVICON_REVALIDATE_INTERVAL 3600000  // ms
+#define FAVICON_REVALIDATE_COUNT 5
+
+namespace {
+
+/** @brief Time when favicon of site is to be requested again
+ * @details Found icon is refreshed periodically. Site without favicon is
+ *   retried after 1 day, and the time doubles with every failure.
+ *----------------------------------------------------------------------------*/
+QDateTime faviconExpires(const QDateTime &checked, int failures, bool found)
+{
+  if (!checked.isValid())
+    return QDateTime();
+  if (found)
+    return checked.addDays(FAVICON_REFRESH_INTERVAL);
+  int ttl = qMin(1 << qBound(0, failures - 1, 5), FAVICON_FAILURE_TTL_MAX);
+  return checked.addDays(ttl);
+}
+
+} // namespace
+
 UpdateFeeds::UpdateFeeds(QObject *parent, bool addFeed)
   : QObject(parent)
   , updateObject_(NULL)
   , requestFeed_(NULL)
-  , parseObject_(NULL)
   , faviconObject_(NULL)
   , updateFeedThread_(NULL)
   , getFaviconThread_(NULL)
@@ -30,21 +53,37 @@ UpdateFeeds::UpdateFeeds(QObject *parent, bool addFeed)
   int timeoutRequest = settings.value("Settings/timeoutRequest", 15).toInt();
   int numberRequests = settings.value("Settings/numberRequest", 10).toInt();
   int numberRepeats = settings.value("Settings/numberRepeats", 2).toInt();
-
-  requestFeed_ = new RequestFeed(timeoutRequest, numberRequests, numberRepeats);
-
-  parseObject_ = new ParseObject();
+  int numberRequestsPerHost = settings.value("Settings/numberRequestsPerHost", 2).toInt();
+  int numberParseThreads = settings.value("Settings/numberParseThreads",
+                                          qBound(1, QThread::idealThreadCount(), 4)).toInt();
+  // Memory database is a single connection shared by all threads
+  if (addFeed_ || mainApp->storeDBMemory())
+    numberParseThreads = 1;
+  numberParseThreads = qMax(1, numberParseThreads);
+
+  requestFeed_ = new RequestFeed(timeoutRequest, numberRequests, numberRepeats,
+                                 numberRequestsPerHost);
+
+  for (int i = 0; i < numberParseThreads; ++i) {
+    QThread *parseFeedThread = new QThread();
+    parseFeedThread->setObjectName(QString("parseFeedThread_%1").arg(i));
+    parseFeedThreads_.append(parseFeedThread);
+    parseObjects_.append(new ParseObject(i));
+  }
 
   if (addFeed_) {
     connect(parent, SIGNAL(signalRequestUrl(int,QString,QDateTime,QString)),
             requestFeed_, SLOT(requestUrl(int,QString,QDateTime,QString)));
-    connect(requestFeed_, SIGNAL(getUrlDone(int,int,QString,QString,QByteArray,QDateTime,QString)),
+    connect(requestFeed_, SIGNAL(getUrlDone(int,int,QString,QString,QByteArray,QDateTime,QString,QString,QString,QDateTime)),
             parent, SLOT(getUrlDone(int,int,QString,QString,QByteArray,QDateTime,QString)));
 
     connect(parent, SIGNAL(xmlReadyParse(QByteArray,int,QDateTime,QString)),
-            parseObject_, SLOT(parseXml(QByteArray,int,QDateTime,QString)));
-    connect(parseObject_, SIGNAL(signalFinishUpdate(int,bool,int,QString)),
-            parent, SLOT(slotUpdateFeed(int,bool,int,QString)));
+            this, SLOT(parseXml(QByteArray,int,QDateTime,QString)),
+            Qt::DirectConnection);
+    foreach (ParseObject *parseObject, parseObjects_) {
+      connect(parseObject, SIGNAL(signalFinishUpdate(int,bool,int,QString)),
+              parent, SLOT(slotUpdateFeed(int,bool,int,QString)));
+    }
   } else {
     getFaviconThread_ = new QThread();
     getFaviconThread_->setObjectName("getFaviconThread_");
@@ -52,19 +91,20 @@ UpdateFeeds::UpdateFeeds(QObject *parent, bool addFeed)
     updateObject_ = new UpdateObject();
     faviconObject_ = new FaviconObject();
 
-    connect(updateObject_, SIGNAL(signalRequestUrl(int,QString,QDateTime,QString)),
-            requestFeed_, SLOT(requestUrl(int,QString,QDateTime,QString)));
-    connect(requestFeed_, SIGNAL(getUrlDone(int,int,QString,QString,QByteArray,QDateTime,QString)),
-            updateObject_, SLOT(getUrlDone(int,int,QString,QString,QByteArray,QDateTime,QString)));
+    connect(updateObject_, SIGNAL(signalRequestUrl(int,QString,QDateTime,QString,QString,QString)),
+            requestFeed_, SLOT(requestUrl(int,QString,QDateTime,QString,QString,QString)));
+    connect(requestFeed_, SIGNAL(getUrlDone(int,int,QString,QString,QByteArray,QDateTime,QString,QString,QString,QDateTime)),
+            updateObject_, SLOT(getUrlDone(int,int,QString,QString,QByteArray,QDateTime,QString,QString,QString,QDateTime)));
     connect(requestFeed_, SIGNAL(setStatusFeed(int,QString)),
             parent, SLOT(setStatusFeed(int,QString)));
+    qRegisterMetaType<TransferStats>("TransferStats");
+    connect(requestFeed_, SIGNAL(transferDone(TransferStats)),
+            parent, SLOT(slotFeedsTransferDone(TransferStats)));
     connect(parent, SIGNAL(signalStopUpdate()),
             requestFeed_, SLOT(stopRequest()));
 
     connect(parent, SIGNAL(signalGetFeedTimer(int)),
             updateObject_, SLOT(slotGetFeedTimer(int)));
-    connect(parent, SIGNAL(signalGetAllFeedsTimer()),
-            updateObject_, SLOT(slotGetAllFeedsTimer()));
     connect(parent, SIGNAL(signalGetAllFeeds()),
             updateObject_, SLOT(slotGetAllFeeds()));
     connect(parent, SIGNAL(signalGetFeed(int,QString,QDateTime,int)),
@@ -79,29 +119,32 @@ UpdateFeeds::UpdateFeeds(QObject *parent, bool addFeed)
             parent, SLOT(slotSetValue(int)));
     connect(updateObject_, SIGNAL(signalMessageStatusBar(QString,int)),
             parent, SLOT(showMessageStatusBar(QString,int)));
-    connect(updateObject_, SIGNAL(signalUpdateFeedsModel()),
-            parent, SLOT(feedsModelReload()),
-            Qt::BlockingQueuedConnection);
+    connect(updateObject_, SIGNAL(signalUpdateFeedsModel(QList<int>)),
+            parent, SLOT(feedsModelUpdate(QList<int>)));
 
     connect(updateObject_, SIGNAL(xmlReadyParse(QByteArray,int,QDateTime,QString)),
-            parseObject_, SLOT(parseXml(QByteArray,int,QDateTime,QString)),
-            Qt::QueuedConnection);
-    connect(parseObject_, SIGNAL(signalFinishUpdate(int,bool,int,QString)),
-            updateObject_, SLOT(finishUpdate(int,bool,int,QString)),
-            Qt::QueuedConnection);
+            this, SLOT(parseXml(QByteArray,int,QDateTime,QString)),
+            Qt::DirectConnection);
+    foreach (ParseObject *parseObject, parseObjects_) {
+      connect(parseObject, SIGNAL(signalFinishUpdate(int,bool,int,QString)),
+              updateObject_, SLOT(finishUpdate(int,bool,int,QString)),
+              Qt::QueuedConnection);
+    }
     connect(updateObject_, SIGNAL(feedUpdated(int,bool,int,bool)),
             parent, SLOT(slotUpdateFeed(int,bool,int,bool)));
     connect(updateObject_, SIGNAL(setStatusFeed(int,QString)),
             parent, SLOT(setStatusFeed(int,QString)));
 
     qRegisterMetaType<FeedCountStruct>("FeedCountStruct");
-    connect(parseObject_, SIGNAL(feedCountsUpdate(FeedCountStruct)),
-            parent, SLOT(slotFeedCountsUpdate(FeedCountStruct)));
-
-    connect(parseObject_, SIGNAL(signalPlaySound(QString)),
-            parent, SLOT(slotPlaySound(QString)));
-    connect(parseObject_, SIGNAL(signalAddColorList(int,QString)),
-            parent, SLOT(slotAddColorList(int,QString)));
+    foreach (ParseObject *parseObject, parseObjects_) {
+      connect(parseObject, SIGNAL(feedCountsUpdate(FeedCountStruct)),
+              parent, SLOT(slotFeedCountsUpdate(FeedCountStruct)));
+
+      connect(parseObject, SIGNAL(signalPlaySound(QString)),
+              parent, SLOT(slotPlaySound(QString)));
+      connect(parseObject, SIGNAL(signalAddColorList(int,QString)),
+              parent, SLOT(slotAddColorList(int,QString)));
+    }
 
     connect(parent, SIGNAL(signalNextUpdate(bool)),
             updateObject_, SLOT(slotNextUpdateFeed(bool)));
@@ -154,19 +197,26 @@ UpdateFeeds::UpdateFeeds(QObject *parent, bool addFeed)
     connect(mainApp, SIGNAL(signalSqlQueryExec(QString)),
             updateObject_, SLOT(slotSqlQueryExec(QString)));
     connect(mainApp, SIGNAL(signalRunUserFilter(int, int)),
-            parseObject_, SLOT(runUserFilter(int, int)));
+            this, SLOT(runUserFilter(int, int)),
+            Qt::DirectConnection);
 
     // faviconObject_
-    connect(parent, SIGNAL(faviconRequestUrl(QString,QString)),
-            faviconObject_, SLOT(requestUrl(QString,QString)));
+    connect(parent, SIGNAL(faviconRequestUrl(QString,QString,bool)),
+            updateObject_, SLOT(slotFaviconRequest(QString,QString,bool)));
+    connect(updateObject_, SIGNAL(signalFaviconRequestUrl(QString,QString,bool)),
+            faviconObject_, SLOT(requestUrl(QString,QString,bool)));
     connect(faviconObject_, SIGNAL(signalIconRecived(QString,QByteArray,QString)),
             parent, SLOT(slotIconFeedPreparing(QString,QByteArray,QString)));
+    connect(faviconObject_, SIGNAL(signalIconFailed(QString)),
+            updateObject_, SLOT(slotIconFailed(QString)));
+    connect(faviconObject_, SIGNAL(transferDone(TransferStats)),
+            parent, SLOT(slotFaviconsTransferDone(TransferStats)));
     connect(parent, SIGNAL(signalIconFeedReady(QString,QByteArray)),
             updateObject_, SLOT(slotIconSave(QString,QByteArray)));
-    connect(updateObject_, SIGNAL(signalIconUpdate(int,QByteArray)),
-            parent, SLOT(slotIconFeedUpdate(int,QByteArray)));
-    connect(updateObject_, SIGNAL(signalImportFeedsGetFavicon(QString,QString)),
-            faviconObject_, SLOT(requestUrl(QString,QString)));
+    connect(parent, SIGNAL(signalIconFeedFailed(QString)),
+            updateObject_, SLOT(slotIconFailed(QString)));
+    connect(updateObject_, SIGNAL(signalIconUpdate(QString)),
+            parent, SLOT(slotIconSiteUpdate(QString)));
 
     connect(parent, SIGNAL(signalQuitApp()),
             updateObject_, SLOT(quitApp()));
@@ -182,16 +232,23 @@ UpdateFeeds::UpdateFeeds(QObject *parent, bool addFeed)
   }
 
   requestFeed_->moveToThread(getFeedThread_);
-  parseObject_->moveToThread(updateFeedThread_);
+  for (int i = 0; i < parseObjects_.count(); ++i) {
+    parseObjects_.at(i)->moveToThread(parseFeedThreads_.at(i));
+  }
 
   getFeedThread_->start(QThread::LowPriority);
   updateFeedThread_->start(QThread::LowPriority);
+  foreach (QThread *parseFeedThread, parseFeedThreads_) {
+    parseFeedThread->start(QThread::LowPriority);
+  }
 }
 
 UpdateFeeds::~UpdateFeeds()
 {
   requestFeed_->deleteLater();
-  parseObject_->deleteLater();
+  foreach (ParseObject *parseObject, parseObjects_) {
+    parseObject->deleteLater();
+  }
 
   if (!addFeed_) {
     updateObject_->deleteLater();
@@ -209,13 +266,22 @@ UpdateFeeds::~UpdateFeeds()
   updateFeedThread_->exit();
   updateFeedThread_->wait();
   delete updateFeedThread_;
+
+  foreach (QThread *parseFeedThread, parseFeedThreads_) {
+    parseFeedThread->exit();
+    parseFeedThread->wait();
+    delete parseFeedThread;
+  }
 }
 
 void UpdateFeeds::disconnectObjects()
 {
   if (!addFeed_) {
     updateObject_->disconnect(updateObject_);
-    updateObject_->disconnect(parseObject_);
+    updateObject_->disconnect(this);
+    foreach (ParseObject *parseObject, parseObjects_) {
+      updateObject_->disconnect(parseObject);
+    }
     updateObject_->disconnect(requestFeed_);
     updateObject_->disconnect(parent());
     faviconObject_->disconnectObjects();
@@ -223,7 +289,9 @@ void UpdateFeeds::disconnectObjects()
 
   requestFeed_->disconnectObjects();
   requestFeed_->disconnect(parent());
-  parseObject_->disconnectObjects();
+  foreach (ParseObject *parseObject, parseObjects_) {
+    parseObject->disconnectObjects();
+  }
 }
 
 void UpdateFeeds::startSaveTimer()
@@ -248,6 +316,32 @@ void UpdateFeeds::saveMemoryDatabase()
   emit signalSaveMemoryDatabase();
 }
 
+/** @brief Pass xml-data to parse worker of the feed
+ *
+ * Called directly in the thread of sender. The same feed is always parsed
+ * by the same worker to keep order of its updates.
+ *----------------------------------------------------------------------------*/
+void UpdateFeeds::parseXml(QByteArray data, int feedId,
+                           QDateTime dtReply, QString codecName)
+{
+  QMetaObject::invokeMethod(parseObjectForFeed(feedId), "parseXml",
+                            Qt::QueuedConnection,
+                            Q_ARG(QByteArray, data), Q_ARG(int, feedId),
+                            Q_ARG(QDateTime, dtReply), Q_ARG(QString, codecName));
+}
+
+void UpdateFeeds::runUserFilter(int feedId, int filterId)
+{
+  QMetaObject::invokeMethod(parseObjectForFeed(feedId), "runUserFilter",
+                            Qt::QueuedConnection,
+                            Q_ARG(int, feedId), Q_ARG(int, filterId));
+}
+
+ParseObject *UpdateFeeds::parseObjectForFeed(int feedId) const
+{
+  return parseObjects_.at(qAbs(feedId) % parseObjects_.count());
+}
+
 //------------------------------------------------------------------------------
 UpdateObject::UpdateObject(QObject *parent)
   : QObject(parent)
@@ -268,6 +362,9 @@ UpdateObject::UpdateObject(QObject *parent)
   timerUpdateNews_->setSingleShot(true);
   connect(timerUpdateNews_, SIGNAL(timeout()), this, SIGNAL(signalUpdateNews()));
 
+  faviconTimer_ = new QTimer(this);
+  connect(faviconTimer_, SIGNAL(timeout()), this, SLOT(slotRevalidateFavicons()));
+  faviconTimer_->start(FAVICON_REVALIDATE_INTERVAL);
 }
 
 UpdateObject::~UpdateObject()
@@ -287,19 +384,6 @@ void UpdateObject::slotGetFeedTimer(int feedId)
   emit showProgressBar(updateFeedsCount_);
 }
 
-void UpdateObject::slotGetAllFeedsTimer()
-{
-  QSqlQuery q(db_);
-  q.exec("SELECT id, xmlUrl, lastBuildDate, authentication FROM feeds "
-         "WHERE xmlUrl!='' AND disableUpdate=0 "
-         "AND (updateIntervalEnable==-1 OR updateIntervalEnable IS NULL)");
-  while (q.next()) {
-    addFeedInQueue(q.value(0).toInt(), q.value(1).toString(),
-                   q.value(2).toDateTime(), q.value(3).toInt());
-  }
-  emit showProgressBar(updateFeedsCount_);
-}
-
 /** @brief Process update feed action
  *---------------------------------------------------------------------------*/
 void UpdateObject::slotGetFeed(int feedId, QString feedUrl, QDateTime date, int auth)
@@ -347,6 +431,7 @@ void UpdateObject::slotImportFeeds(QByteArray xmlData)
   int outlineCount = 0;
   QSqlQuery q(db_);
   QList<int> idsList;
+  QList<int> addedIdsList;  // folders and feeds in order of adding
   QList<QString> urlsList;
   QList<QString> htmlsList;
   QXmlStreamReader xml;
@@ -421,6 +506,7 @@ void UpdateObject::slotImportFeeds(QByteArray xmlData)
           q.bindValue(":parentId", parentIdsStack.top());
           q.bindValue(":rowToParent", rowToParent);
           q.exec();
+          addedIdsList.append(q.lastInsertId().toInt());
           parentIdsStack.push(q.lastInsertId().toInt());
         }
         // Feed finded
@@ -462,6 +548,7 @@ void UpdateObject::slotImportFeeds(QByteArray xmlData)
             q.exec();
 
             idsList.append(q.lastInsertId().toInt());
+            addedIdsList.append(q.lastInsertId().toInt());
             urlsList.append(xmlUrlString);
             htmlsList.append(xml.attributes().value("htmlUrl").toString());
           }
@@ -488,12 +575,12 @@ void UpdateObject::slotImportFeeds(QByteArray xmlData)
 
   db_.commit();
 
-  emit signalUpdateFeedsModel();
+  emit signalUpdateFeedsModel(addedIdsList);
 
   for (int i = 0; i < idsList.count(); i++) {
     updateFeedsCount_ = updateFeedsCount_ + 2;
-    emit signalRequestUrl(idsList.at(i), urlsList.at(i), QDateTime(), "");
-    emit signalImportFeedsGetFavicon(htmlsList.at(i), urlsList.at(i));
+    emit signalRequestUrl(idsList.at(i), urlsList.at(i), QDateTime(), "", "", "");
+    slotFaviconRequest(htmlsList.at(i), urlsList.at(i));
   }
   emit showProgressBar(updateFeedsCount_);
 }
@@ -508,9 +595,19 @@ bool UpdateObject::addFeedInQueue(int feedId, const QString &feedUrl,
   } else {
     feedIdList_.append(feedId);
     updateFeedsCount_ = updateFeedsCount_ + 2;
+    QSqlQuery q(db_);
+    QString etag;
+    QString lastModified;
+    q.prepare("SELECT etag, lastModified FROM feeds WHERE id=?");
+    q.addBindValue(feedId);
+    q.exec();
+    if (q.next()) {
+      etag = q.value(0).toString();
+      lastModified = q.value(1).toString();
+    }
+
     QString userInfo;
     if (auth == 1) {
-      QSqlQuery q(db_);
       QUrl url(feedUrl);
       q.prepare("SELECT username, password FROM passwords WHERE server=?");
       q.addBindValue(url.host());
@@ -520,7 +617,7 @@ bool UpdateObject::addFeedInQueue(int feedId, const QString &feedUrl,
             arg(QString::fromUtf8(QByteArray::fromBase64(q.value(1).toByteArray())));
       }
     }
-    emit signalRequestUrl(feedId, feedUrl, date, userInfo);
+    emit signalRequestUrl(feedId, feedUrl, date, userInfo, etag, lastModified);
     return true;
   }
 }
@@ -529,7 +626,8 @@ bool UpdateObject::addFeedInQueue(int feedId, const QString &feedUrl,
  *---------------------------------------------------------------------------*/
 void UpdateObject::getUrlDone(int result, int feedId, QString feedUrlStr,
                               QString error, QByteArray data, QDateTime dtReply,
-                              QString codecName)
+                              QString codecName, QString etag, QString lastModified,
+                              QDateTime cacheExpires)
 {
   qDebug() << "getUrl result = " << result << "error: " << error << "url: " << feedUrlStr;
 
@@ -538,7 +636,11 @@ void UpdateObject::getUrlDone(int result, int feedId, QString feedUrlStr,
     emit loadProgress(updateFeedsCount_);
   }
 
+  if (result >= 0)
+    cacheExpires_.insert(feedId, cacheExpires);
+
   if (!data.isEmpty()) {
+    validators_.insert(feedId, qMakePair(etag, lastModified));
     emit xmlReadyParse(data, feedId, dtReply, codecName);
   } else {
     QString status = "0";
@@ -572,6 +674,34 @@ void UpdateObject::finishUpdate(int feedId, bool changed, int newCount, QString
       arg(status).arg(feedId);
   q.exec(qStr);
 
+  // Feed has been checked whatever the outcome, next one is counted from now
+  q.prepare("UPDATE feeds SET lastChecked=? WHERE id=?");
+  q.addBindValue(QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+  q.addBindValue(feedId);
+  q.exec();
+
+  // Data has been stored, so next update may ask only for changes.
+  // Data which could not be parsed is to be received again in full.
+  if (status != "0") {
+    validators_.remove(feedId);
+    cacheExpires_.remove(feedId);
+  }
+  if (validators_.contains(feedId)) {
+    QPair<QString, QString> validators = validators_.take(feedId);
+    q.prepare("UPDATE feeds SET etag=?, lastModified=? WHERE id=?");
+    q.addBindValue(validators.first);
+    q.addBindValue(validators.second);
+    q.addBindValue(feedId);
+    q.exec();
+  }
+  if (cacheExpires_.contains(feedId)) {
+    QDateTime cacheExpires = cacheExpires_.take(feedId);
+    q.prepare("UPDATE feeds SET cacheExpires=? WHERE id=?");
+    q.addBindValue(cacheExpires.isValid() ? cacheExpires.toString(Qt::ISODate) : QString());
+    q.addBindValue(feedId);
+    q.exec();
+  }
+
   if (changed) {
     if (mainWindow_->currentNewsTab->type_ == NewsTabWidget::TabTypeFeed) {
       bool folderUpdate = false;
@@ -676,206 +806,67 @@ void UpdateObject::slotRecountFeedCounts(int feedId, bool updateViewport)
       isFolder = true;
   }
 
-  int undeleteCount = 0;
-  int unreadCount = 0;
-  int newCount = 0;
-
+  // Counters are kept up to date by triggers, only pass them to the view
   if (!isFolder) {
-    // Calculate all news (not mark deleted)
-    qStr = QString("SELECT count(id) FROM news WHERE feedId=='%1' AND deleted==0").
-        arg(feedId);
-    q.exec(qStr);
-    if (q.next()) undeleteCount = q.value(0).toInt();
-
-    // Calculate unread news
-    qStr = QString("SELECT count(read) FROM news WHERE feedId=='%1' AND read==0 AND deleted==0").
-        arg(feedId);
-    q.exec(qStr);
-    if (q.next()) unreadCount = q.value(0).toInt();
-
-    // Calculate new news
-    qStr = QString("SELECT count(new) FROM news WHERE feedId=='%1' AND new==1 AND deleted==0").
-        arg(feedId);
-    q.exec(qStr);
-    if (q.next()) newCount = q.value(0).toInt();
-
-    int unreadCountOld = 0;
-    int newCountOld = 0;
-    int undeleteCountOld = 0;
-    qStr = QString("SELECT unread, newCount, undeleteCount FROM feeds WHERE id=='%1'").
-        arg(feedId);
-    q.exec(qStr);
-    if (q.next()) {
-      unreadCountOld = q.value(0).toInt();
-      newCountOld = q.value(1).toInt();
-      undeleteCountOld = q.value(2).toInt();
-    }
-
-    if ((unreadCount == unreadCountOld) && (newCount == newCountOld) &&
-        (undeleteCount == undeleteCountOld)) {
-      db_.commit();
-      return;
-    }
-
-    // Save unread and new news number for feed
-    qStr = QString("UPDATE feeds SET unread='%1', newCount='%2', undeleteCount='%3' "
-                   "WHERE id=='%4'").
-        arg(unreadCount).arg(newCount).arg(undeleteCount).arg(feedId);
-    q.exec(qStr);
-
-    // Update view of the feed
-    FeedCountStruct counts;
-    counts.feedId = feedId;
-    counts.unreadCount = unreadCount;
-    counts.newCount = newCount;
-    counts.undeleteCount = undeleteCount;
-    emit feedCountsUpdate(counts);
+    refreshFeedCounts(q, feedId, false);
   } else {
-    bool changed = false;
     QList<int> idParList;
-    QList<int> idList = getIdFeedsInList(db_, feedId);
-    if (idList.count()) {
-      foreach (int id, idList) {
-        int parId = 0;
-        q.exec(QString("SELECT parentId FROM feeds WHERE id=='%1'").arg(id));
-        if (q.next())
-          parId = q.value(0).toInt();
-
-        if (parId) {
-          if (idParList.indexOf(parId) == -1) {
-            idParList.append(parId);
-          }
-        }
-
-        // Calculate all news (not mark deleted)
-        qStr = QString("SELECT count(id) FROM news WHERE feedId=='%1' AND deleted==0").
-            arg(id);
-        q.exec(qStr);
-        if (q.next()) undeleteCount = q.value(0).toInt();
-
-        // Calculate unread news
-        qStr = QString("SELECT count(read) FROM news WHERE feedId=='%1' AND read==0 AND deleted==0").
-            arg(id);
-        q.exec(qStr);
-        if (q.next()) unreadCount = q.value(0).toInt();
-
-        // Calculate new news
-        qStr = QString("SELECT count(new) FROM news WHERE feedId=='%1' AND new==1 AND deleted==0").
-            arg(id);
-        q.exec(qStr);
-        if (q.next()) newCount = q.value(0).toInt();
-
-        int unreadCountOld = 0;
-        int newCountOld = 0;
-        int undeleteCountOld = 0;
-        qStr = QString("SELECT unread, newCount, undeleteCount FROM feeds WHERE id=='%1'").
-            arg(id);
-        q.exec(qStr);
-        if (q.next()) {
-          unreadCountOld = q.value(0).toInt();
-          newCountOld = q.value(1).toInt();
-          undeleteCountOld = q.value(2).toInt();
-        }
-
-        if ((unreadCount == unreadCountOld) && (newCount == newCountOld) &&
-            (undeleteCount == undeleteCountOld)) {
-          continue;
-        }
-        changed = true;
-
-        // Save unread and new news number for parent
-        qStr = QString("UPDATE feeds SET unread='%1', newCount='%2', undeleteCount='%3' "
-                       "WHERE id=='%4'").
-            arg(unreadCount).arg(newCount).arg(undeleteCount).arg(id);
-        q.exec(qStr);
-
-        // Update view of the parent
-        FeedCountStruct counts;
-        counts.feedId = id;
-        counts.unreadCount = unreadCount;
-        counts.newCount = newCount;
-        counts.undeleteCount = undeleteCount;
-        emit feedCountsUpdate(counts);
-      }
-
-      if (!changed) {
-        db_.commit();
-        return;
-      }
+    foreach (int id, getIdFeedsInList(db_, feedId)) {
+      int parId = refreshFeedCounts(q, id, false);
+      if (parId && (idParList.indexOf(parId) == -1))
+        idParList.append(parId);
+    }
 
-      foreach (int l_feedParId, idParList) {
-        while (l_feedParId) {
-          QString updated;
-
-          qStr = QString("SELECT sum(unread), sum(newCount), sum(undeleteCount), "
-                         "max(updated) FROM feeds WHERE parentId=='%1'").
-              arg(l_feedParId);
-          q.exec(qStr);
-          if (q.next()) {
-            unreadCount   = q.value(0).toInt();
-            newCount      = q.value(1).toInt();
-            undeleteCount = q.value(2).toInt();
-            updated       = q.value(3).toString();
-          }
-          qStr = QString("UPDATE feeds SET unread='%1', newCount='%2', undeleteCount='%3', "
-                         "updated='%4' WHERE id=='%5'").
-              arg(unreadCount).arg(newCount).arg(undeleteCount).arg(updated).
-              arg(l_feedParId);
-          q.exec(qStr);
-
-          // Update view
-          FeedCountStruct counts;
-          counts.feedId = l_feedParId;
-          counts.unreadCount = unreadCount;
-          counts.newCount = newCount;
-          counts.undeleteCount = undeleteCount;
-          counts.updated = updated;
-          emit feedCountsUpdate(counts);
-
-          if (feedId == l_feedParId) break;
-          q.exec(QString("SELECT parentId FROM feeds WHERE id==%1").arg(l_feedParId));
-          if (q.next()) l_feedParId = q.value(0).toInt();
-        }
+    foreach (int l_feedParId, idParList) {
+      while (l_feedParId) {
+        int parId = refreshFeedCounts(q, l_feedParId, true);
+        if (feedId == l_feedParId) break;
+        l_feedParId = parId;
       }
     }
   }
 
-  // Recalculate counters for all parents
+  // Refresh all parents
   int l_feedParId = feedParId;
   while (l_feedParId) {
-    QString updated;
+    l_feedParId = refreshFeedCounts(q, l_feedParId, true);
+  }
+  db_.commit();
 
-    qStr = QString("SELECT sum(unread), sum(newCount), sum(undeleteCount), "
-                   "max(updated) FROM feeds WHERE parentId=='%1'").
-        arg(l_feedParId);
-    q.exec(qStr);
-    if (q.next()) {
-      unreadCount   = q.value(0).toInt();
-      newCount      = q.value(1).toInt();
-      undeleteCount = q.value(2).toInt();
-      updated       = q.value(3).toString();
-    }
-    qStr = QString("UPDATE feeds SET unread='%1', newCount='%2', undeleteCount='%3', "
-                   "updated='%4' WHERE id=='%5'").
-        arg(unreadCount).arg(newCount).arg(undeleteCount).arg(updated).
-        arg(l_feedParId);
-    q.exec(qStr);
+  if (updateViewport) emit signalFeedsViewportUpdate();
+}
 
-    // Update view
-    FeedCountStruct counts;
-    counts.feedId = l_feedParId;
-    counts.unreadCount = unreadCount;
-    counts.newCount = newCount;
-    counts.undeleteCount = undeleteCount;
-    counts.updated = updated;
-    emit feedCountsUpdate(counts);
+/** @brief Pass stored counters of feed \a feedId to the view
+ * @param isFolder For categories last update timestamp is recalculated
+ * @return parent identifier of the feed
+ *----------------------------------------------------------------------------*/
+int UpdateObject::refreshFeedCounts(QSqlQuery &q, int feedId, bool isFolder)
+{
+  if (isFolder) {
+    q.exec(QString("UPDATE feeds SET updated=(SELECT max(updated) FROM feeds "
+                   "WHERE parentId=='%1') WHERE id=='%1'").arg(feedId));
+  }
 
-    q.exec(QString("SELECT parentId FROM feeds WHERE id==%1").arg(l_feedParId));
-    if (q.next()) l_feedParId = q.value(0).toInt();
+  FeedCountStruct counts;
+  counts.feedId = feedId;
+  counts.unreadCount = 0;
+  counts.newCount = 0;
+  counts.undeleteCount = 0;
+
+  int parentId = 0;
+  q.exec(QString("SELECT parentId, unread, newCount, undeleteCount, updated "
+                 "FROM feeds WHERE id=='%1'").arg(feedId));
+  if (q.next()) {
+    parentId = q.value(0).toInt();
+    counts.unreadCount = q.value(1).toInt();
+    counts.newCount = q.value(2).toInt();
+    counts.undeleteCount = q.value(3).toInt();
+    if (isFolder)
+      counts.updated = q.value(4).toString();
   }
-  db_.commit();
 
-  if (updateViewport) emit signalFeedsViewportUpdate();
+  emit feedCountsUpdate(counts);
+  return parentId;
 }
 
 /** @brief Get feeds ids list string of folder \a idFolder
@@ -1107,26 +1098,180 @@ void UpdateObject::slotMarkReadCategory(int type, int idLabel)
   }
 }
 
-/** @brief Save icon in DB and emit signal to update it
+/** @brief Request favicon of feed site unless it is known
+ * @details Feeds of the same site share one icon. Site without favicon is
+ *   not requested again until its negative result expires. Only first
+ *   request of site may be answered from disk cache, expired and forced
+ *   ones are sent to server.
+ * @param force - request icon even if it is known
  *----------------------------------------------------------------------------*/
-void UpdateObject::slotIconSave(QString feedUrl, QByteArray faviconData)
+void UpdateObject::slotFaviconRequest(QString urlString, QString feedUrl, bool force)
 {
-  int feedId = 0;
+  QString site = FaviconObject::siteUrl(urlString, feedUrl).toString();
+  if (site.isEmpty())
+    return;
 
   QSqlQuery q(db_);
-  q.prepare("SELECT id FROM feeds WHERE xmlUrl LIKE :xmlUrl");
-  q.bindValue(":xmlUrl", feedUrl);
+  q.prepare("UPDATE feeds SET faviconSite=? WHERE xmlUrl=? AND faviconSite IS NOT ?");
+  q.addBindValue(site);
+  q.addBindValue(feedUrl);
+  q.addBindValue(site);
   q.exec();
-  if (q.next()) {
-    feedId = q.value(0).toInt();
+  bool siteChanged = (q.numRowsAffected() > 0);
+
+  bool revalidate = force;
+  if (!force) {
+    // Result of request in progress is set to all feeds of site
+    if (faviconPending_.contains(site))
+      return;
+
+    q.prepare("SELECT checked, failures, iconHash FROM favicons WHERE site=?");
+    q.addBindValue(site);
+    q.exec();
+    if (q.first()) {
+      revalidate = true;
+      QDateTime checked = QDateTime::fromString(q.value(0).toString(), Qt::ISODate);
+      bool found = !q.value(2).toString().isEmpty();
+      if (siteChanged && found)
+        emit signalIconUpdate(site);
+
+      QDateTime expires = faviconExpires(checked, q.value(1).toInt(), found);
+      if (expires.isValid() && (expires > QDateTime::currentDateTimeUtc()))
+        return;
+    }
   }
 
-  q.prepare("UPDATE feeds SET image = ? WHERE id == ?");
-  q.addBindValue(faviconData.toBase64());
-  q.addBindValue(feedId);
+  faviconRequests_.insert(feedUrl, site);
+  faviconPending_.insert(site);
+  emit signalFaviconRequestUrl(site, feedUrl, revalidate);
+}
+
+/** @brief Save icon of site in DB and emit signal to update its feeds
+ * @details Icon data is stored once by its hash and shared by sites.
+ *   Feeds refer to it through their site, so they are not changed.
+ *----------------------------------------------------------------------------*/
+void UpdateObject::slotIconSave(QString feedUrl, QByteArray faviconData)
+{
+  QSqlQuery q(db_);
+  bool siteChanged = false;
+
+  QString site = faviconRequests_.take(feedUrl);
+  if (site.isEmpty()) {
+    // Icon was not requested for site, it is taken from feed
+    q.prepare("SELECT htmlUrl, faviconSite FROM feeds WHERE xmlUrl=?");
+    q.addBindValue(feedUrl);
+    q.exec();
+    if (!q.first())
+      return;
+
+    site = q.value(1).toString();
+    if (site.isEmpty()) {
+      site = FaviconObject::siteUrl(q.value(0).toString(), feedUrl).toString();
+      if (site.isEmpty())
+        return;
+
+      q.prepare("UPDATE feeds SET faviconSite=? WHERE xmlUrl=?");
+      q.addBindValue(site);
+      q.addBindValue(feedUrl);
+      q.exec();
+      siteChanged = true;
+    }
+  } else {
+    faviconPending_.remove(site);
+  }
+
+  QString hash = QCryptographicHash::hash(faviconData, QCryptographicHash::Sha1).toHex();
+
+  QString oldHash;
+  q.prepare("SELECT iconHash FROM favicons WHERE site=?");
+  q.addBindValue(site);
+  q.exec();
+  if (q.first())
+    oldHash = q.value(0).toString();
+
+  q.prepare("INSERT OR IGNORE INTO icons(hash, data) VALUES (?, ?)");
+  q.addBindValue(hash);
+  q.addBindValue(faviconData);
+  if (!q.exec()) {
+    qWarning() << __PRETTY_FUNCTION__ << __LINE__
+               << "q.lastError(): " << q.lastError().text();
+  }
+
+  q.prepare("INSERT OR REPLACE INTO favicons(site, iconHash, checked, failures) "
+            "VALUES (?, ?, ?, 0)");
+  q.addBindValue(site);
+  q.addBindValue(hash);
+  q.addBindValue(QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+  if (!q.exec()) {
+    qWarning() << __PRETTY_FUNCTION__ << __LINE__
+               << "q.lastError(): " << q.lastError().text();
+  }
+
+  // Replaced icon is dropped unless another site shares it
+  if (!oldHash.isEmpty() && (oldHash != hash)) {
+    q.prepare("DELETE FROM icons WHERE hash=? AND NOT EXISTS "
+              "(SELECT 1 FROM favicons WHERE iconHash=?)");
+    q.addBindValue(oldHash);
+    q.addBindValue(oldHash);
+    q.exec();
+  }
+
+  if (siteChanged || (oldHash != hash))
+    emit signalIconUpdate(site);
+}
+
+/** @brief Remember that favicon of site was not received
+ *----------------------------------------------------------------------------*/
+void UpdateObject::slotIconFailed(QString feedUrl)
+{
+  QString site = faviconRequests_.take(feedUrl);
+  if (site.isEmpty())
+    return;
+  faviconPending_.remove(site);
+
+  QSqlQuery q(db_);
+  q.prepare("INSERT OR IGNORE INTO favicons(site, failures) VALUES (?, 0)");
+  q.addBindValue(site);
   q.exec();
 
-  emit signalIconUpdate(feedId, faviconData);
+  q.prepare("UPDATE favicons SET checked=?, failures=failures+1 WHERE site=?");
+  q.addBindValue(QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+  q.addBindValue(site);
+  if (!q.exec()) {
+    qWarning() << __PRETTY_FUNCTION__ << __LINE__
+               << "q.lastError(): " << q.lastError().text();
+  }
+}
+
+/** @brief Request again a few favicons of sites which have expired
+ *----------------------------------------------------------------------------*/
+void UpdateObject::slotRevalidateFavicons()
+{
+  QDateTime currentDate = QDateTime::currentDateTimeUtc();
+  QStringList sitesList;
+
+  QSqlQuery q(db_);
+  q.setForwardOnly(true);
+  q.exec("SELECT site, checked, failures, iconHash FROM favicons "
+         "WHERE site IN (SELECT faviconSite FROM feeds) ORDER BY checked");
+  while (q.next() && (sitesList.count() < FAVICON_REVALIDATE_COUNT)) {
+    QString site = q.value(0).toString();
+    if (faviconPending_.contains(site))
+      continue;
+
+    QDateTime checked = QDateTime::fromString(q.value(1).toString(), Qt::ISODate);
+    QDateTime expires = faviconExpires(checked, q.value(2).toInt(),
+                                       !q.value(3).toString().isEmpty());
+    if (!expires.isValid() || (expires <= currentDate))
+      sitesList.append(site);
+  }
+  q.finish();
+
+  foreach (const QString &site, sitesList) {
+    faviconRequests_.insert(site, site);
+    faviconPending_.insert(site);
+    emit signalFaviconRequestUrl(site, site, true);
+  }
 }
 
 void UpdateObject::slotSqlQueryExec(QString query)
@@ -1143,12 +1288,17 @@ void UpdateObject::slotSqlQueryExec(QString query)
 void UpdateObject::slotMarkAllFeedsOld()
 {
   QSqlQuery q(db_);
-  q.exec("UPDATE news SET new=0 WHERE new==1 AND deleted==0");
-
+  // Counters are reset by triggers, feeds which had new news are reread
+  QList<int> idList;
   q.exec("SELECT id FROM feeds WHERE newCount!=0");
   while (q.next()) {
-    slotRecountFeedCounts(q.value(0).toInt());
+    idList.append(q.value(0).toInt());
   }
+
+  q.exec("UPDATE news SET new=0 WHERE new==1 AND deleted==0");
+
+  if (!idList.isEmpty())
+    emit signalUpdateFeedsModel(idList);
   slotRecountCategoryCounts();
 
   if ((mainWindow_->currentNewsTab != NULL) && (mainWindow_->currentNewsTab->type_ < NewsTabWidget::TabTypeWeb)) {
@@ -1182,7 +1332,7 @@ void UpdateObject::saveMemoryDatabase()
 
 /** @brief Delete news from the feed by criteria
  *---------------------------------------------------------------------------*/
-void UpdateObject::startCleanUp(bool isShutdown, QStringList feedsIdList, QList<int> foldersIdList)
+void UpdateObject::startCleanUp(bool isShutdown, QStringList feedsIdList)
 {
   bool cleanupOn = true;
   bool optimizeDB = false;
@@ -1217,7 +1367,6 @@ void UpdateObject::startCleanUp(bool isShutdown, QStringList feedsIdList, QList<
   if (isShutdown) {
     q.exec("UPDATE news SET new=0 WHERE new==1");
     q.exec("UPDATE news SET read=2 WHERE read==1");
-    q.exec("UPDATE feeds SET newCount=0 WHERE newCount!=0");
   }
 
   if (cleanupOn) {
@@ -1287,67 +1436,6 @@ void UpdateObject::startCleanUp(bool isShutdown, QStringList feedsIdList, QList<
           countDelNews++;
         }
       }
-
-      int undeleteCount = 0;
-      qStr = QString("SELECT count(id) FROM news WHERE feedId=='%1' AND deleted==0").
-          arg(feedId);
-      q.exec(qStr);
-      if (q.next()) undeleteCount = q.value(0).toInt();
-
-      int unreadCount = 0;
-      qStr = QString("SELECT count(read) FROM news WHERE feedId=='%1' AND read==0 AND deleted==0").
-          arg(feedId);
-      q.exec(qStr);
-      if (q.next()) unreadCount = q.value(0).toInt();
-
-      int newCount = 0;
-      if (!isShutdown) {
-        qStr = QString("SELECT count(new) FROM news WHERE feedId=='%1' AND new==1 AND deleted==0").
-            arg(feedId);
-        q.exec(qStr);
-        if (q.next()) newCount = q.value(0).toInt();
-        qStr = QString("UPDATE feeds SET unread='%1', newCount='%2', undeleteCount='%3' WHERE id=='%4'").
-            arg(unreadCount).arg(newCount).arg(undeleteCount).arg(feedId);
-      } else {
-        qStr = QString("UPDATE feeds SET unread='%1', undeleteCount='%2' WHERE id=='%3'").
-            arg(unreadCount).arg(undeleteCount).arg(feedId);
-      }
-      q.exec(qStr);
-    }
-
-    // Run categories recount, because cleanup may change counts
-    foreach (int folderIdStart, foldersIdList) {
-      if (folderIdStart < 1) continue;
-
-      int folderId = folderIdStart;
-      // Process all parents
-      while (0 < folderId) {
-        int unreadCount = -1;
-        int undeleteCount = -1;
-        int newCount = -1;
-
-        // Calculate sum of all feeds with same parent
-        qStr = QString("SELECT sum(unread), sum(undeleteCount), sum(newCount) "
-                       "FROM feeds WHERE parentId=='%1'").arg(folderId);
-        q.exec(qStr);
-        if (q.next()) {
-          unreadCount   = q.value(0).toInt();
-          undeleteCount = q.value(1).toInt();
-          newCount = q.value(2).toInt();
-        }
-
-        if (unreadCount != -1) {
-          qStr = QString("UPDATE feeds SET unread='%1', undeleteCount='%2', newCount='%3' WHERE id=='%4'").
-              arg(unreadCount).arg(undeleteCount).arg(newCount).arg(folderId);
-          q.exec(qStr);
-        }
-
-        // go to next parent's parent
-        qStr = QString("SELECT parentId FROM feeds WHERE id=='%1'").arg(folderId);
-        folderId = 0;
-        q.exec(qStr);
-        if (q.next()) folderId = q.value(0).toInt();
-      }
     }
 
     if (cleanUpDeleted) {
@@ -1362,6 +1450,10 @@ void UpdateObject::startCleanUp(bool isShutdown, QStringList feedsIdList, QList<
     }
   }
 
+  // Icons left behind by sites which have been removed
+  q.exec("DELETE FROM icons WHERE hash NOT IN "
+         "(SELECT iconHash FROM favicons WHERE iconHash IS NOT NULL)");
+
   q.finish();
   db_.commit();
 
@@ -1383,19 +1475,13 @@ void UpdateObject::cleanUpShutdown()
 {
   QSqlQuery q(db_);
   QStringList feedsIdList;
-  QList<int> foldersIdList;
-  q.exec("SELECT id, xmlUrl FROM feeds");
+  q.exec("SELECT id FROM feeds WHERE xmlUrl!=''");
   while (q.next()) {
-    if (q.value(1).toString().isEmpty()) {
-      foldersIdList << q.value(0).toInt();
-    }
-    else {
-      feedsIdList << q.value(0).toString();
-    }
+    feedsIdList << q.value(0).toString();
   }
   q.finish();
 
-  startCleanUp(true, feedsIdList, foldersIdList);
+  startCleanUp(true, feedsIdList);
 }
 
 void UpdateObject::quitApp()
@@ -25,19 +25,25 @@ public:
 
   UpdateObject *updateObject_;
   RequestFeed *requestFeed_;
-  ParseObject *parseObject_;
+  QList<ParseObject *> parseObjects_;
   FaviconObject *faviconObject_;
   QThread *getFeedThread_;
   QThread *updateFeedThread_;
+  QList<QThread *> parseFeedThreads_;
   QThread *getFaviconThread_;
 
 public slots:
   void saveMemoryDatabase();
+  void parseXml(QByteArray data, int feedId,
+                QDateTime dtReply, QString codecName);
+  void runUserFilter(int feedId, int filterId);
 
 signals:
   void signalSaveMemoryDatabase();
 
 private:
+  ParseObject *parseObjectForFeed(int feedId) const;
+
   bool addFeed_;
   QTimer *saveMemoryDBTimer_;
 
@@ -56,14 +62,15 @@ public:
 
 public slots:
   void slotGetFeedTimer(int feedId);
-  void slotGetAllFeedsTimer();
   void slotGetFeed(int feedId, QString feedUrl, QDateTime date, int auth);
   void slotGetFeedsFolder(QString query);
   void slotGetAllFeeds();
   void slotImportFeeds(QByteArray xmlData);
   void getUrlDone(int result, int feedId, QString feedUrlStr,
                   QString error, QByteArray data,
-                  QDateTime dtReply, QString codecName);
+                  QDateTime dtReply, QString codecName,
+                  QString etag, QString lastModified,
+                  QDateTime cacheExpires);
   void finishUpdate(int feedId, bool changed, int newCount, QString status);
   void slotNextUpdateFeed(bool finish);
   void slotRecountCategoryCounts();
@@ -73,12 +80,14 @@ public slots:
   void slotUpdateStatus(int feedId, bool changed);
   void slotMarkAllFeedsRead();
   void slotMarkReadCategory(int type, int idLabel);
+  void slotFaviconRequest(QString urlString, QString feedUrl, bool force = false);
   void slotIconSave(QString feedUrl, QByteArray faviconData);
+  void slotIconFailed(QString feedUrl);
   void slotSqlQueryExec(QString query);
   void slotMarkAllFeedsOld();
   void slotRefreshInfoTray();
   void saveMemoryDatabase();
-  void startCleanUp(bool isShutdown, QStringList feedsIdList, QList<int> foldersIdList);
+  void startCleanUp(bool isShutdown, QStringList feedsIdList);
   void cleanUpShutdown();
   void quitApp();
 
@@ -86,10 +95,11 @@ signals:
   void showProgressBar(int value);
   void loadProgress(int value, bool clear = false);
   void signalMessageStatusBar(QString message, int timeout = 0);
-  void signalUpdateFeedsModel();
+  void signalUpdateFeedsModel(QList<int> idList);
   void signalRequestUrl(int feedId, QString urlString,
-                        QDateTime date, QString userInfo);
-  void signalImportFeedsGetFavicon(QString urlString, QString feedUrl);
+                        QDateTime date, QString userInfo,
+                        QString etag, QString lastModified);
+  void signalFaviconRequestUrl(QString urlString, QString feedUrl, bool revalidate);
   void xmlReadyParse(QByteArray data, int feedId,
                      QDateTime dtReply, QString codecName);
   void setStatusFeed(int feedId, QString status);
@@ -103,23 +113,33 @@ signals:
   void signalFeedsViewportUpdate();
   void signalRefreshInfoTray(int newCount, int unreadCount);
   void signalMarkAllFeedsRead(int nextUnread = -1);
-  void signalIconUpdate(int feedId, QByteArray faviconData);
+  void signalIconUpdate(QString site);
   void signalSetFeedsFilter(bool clicked = false);
   void signalFinishCleanUp(int countDeleted);
 
 private slots:
   bool addFeedInQueue(int feedId, const QString &feedUrl,
                       const QDateTime &date, int auth);
+  void slotRevalidateFavicons();
 
 private:
   QString getIdFeedsString(int idFolder, int idException = -1);
+  int refreshFeedCounts(QSqlQuery &q, int feedId, bool isFolder);
 
   MainWindow *mainWindow_;
   QSqlDatabase db_;
   QList<int> feedIdList_;
+  // Validators of received feed data, saved when its parsing is finished
+  QHash<int, QPair<QString, QString> > validators_;
+  // Time until feed data stays fresh, saved with validators
+  QHash<int, QDateTime> cacheExpires_;
   int updateFeedsCount_;
   QTimer *updateModelTimer_;
   QTimer *timerUpdateNews_;
+  // Favicon requests in progress: feed URL -> site, and sites themselves
+  QHash<QString, QString> faviconRequests_;
+  QSet<QString> faviconPending_;
+  QTimer *faviconTimer_;
 
 };
 
@@ -0,0 +1,215 @@
+#include "adblockrule.h"
+#include "adblockruleindex.h"
+#include "webpage.h"
+
+#include <QtTest>
+
+const int kRulesCount = 2000;
+const int kRequestsCount = 5000;
+
+/** @brief Replay of request log against AdBlockRuleIndex and linear rule list
+ *
+ * Rules and requests are generated in EasyList-like style. Real ones can be
+ * replayed instead: QUITERSS_BENCH_ADBLOCK_RULES names a subscription file,
+ * QUITERSS_BENCH_ADBLOCK_LOG a file with "url [referer [type]]" per line.
+ *---------------------------------------------------------------------------*/
+class BenchAdBlockRuleIndex : public QObject
+{
+  Q_OBJECT
+private slots:
+  void initTestCase();
+  void cleanupTestCase();
+  void replay_data();
+  void replay();
+
+private:
+  struct Request {
+    QNetworkRequest request;
+    QString domain;
+    QString urlString;
+  };
+
+  static QStringList generateRules();
+  static QStringList generateLog();
+  static QStringList readLines(const QString &fileName);
+
+  const AdBlockRule* findLinear(const Request &request) const;
+  const AdBlockRule* findIndexed(const Request &request) const;
+  int replayLog(bool indexed) const;
+
+  QVector<AdBlockRule*> m_rules;
+  QVector<const AdBlockRule*> m_exceptionRules;
+  QVector<const AdBlockRule*> m_blockRules;
+  AdBlockRuleIndex m_exceptionIndex;
+  AdBlockRuleIndex m_blockIndex;
+  QVector<Request> m_requests;
+};
+
+void BenchAdBlockRuleIndex::initTestCase()
+{
+  QString rulesFile = qEnvironmentVariable("QUITERSS_BENCH_ADBLOCK_RULES");
+  QString logFile = qEnvironmentVariable("QUITERSS_BENCH_ADBLOCK_LOG");
+  QStringList filters = rulesFile.isEmpty() ? generateRules() : readLines(rulesFile);
+  QStringList log = logFile.isEmpty() ? generateLog() : readLines(logFile);
+  QVERIFY(!filters.isEmpty());
+  QVERIFY(!log.isEmpty());
+
+  // Network rules are split the same way as AdBlockMatcher::update does
+  foreach (const QString &filter, filters) {
+    AdBlockRule* rule = new AdBlockRule(filter);
+    m_rules.append(rule);
+
+    if (rule->isInternalDisabled() || rule->isCssRule() || rule->isDocument() ||
+        rule->isElemhide())
+      continue;
+
+    if (rule->isException()) {
+      m_exceptionRules.append(rule);
+      m_exceptionIndex.add(rule);
+    }
+    else {
+      m_blockRules.append(rule);
+      m_blockIndex.add(rule);
+    }
+  }
+
+  foreach (const QString &line, log) {
+    QStringList fields = line.split(' ', Qt::SkipEmptyParts);
+    if (fields.isEmpty())
+      continue;
+
+    Request request;
+    request.request = QNetworkRequest(QUrl(fields.at(0)));
+    if (fields.count() > 1)
+      request.request.setAttribute(RequestModifiler::RefererString, fields.at(1));
+    if (fields.count() > 2)
+      request.request.setAttribute(RequestModifiler::TypeString, fields.at(2));
+    request.urlString = request.request.url().toEncoded().toLower();
+    request.domain = request.request.url().host().toLower();
+    m_requests.append(request);
+  }
+}
+
+void BenchAdBlockRuleIndex::cleanupTestCase()
+{
+  qDeleteAll(m_rules);
+}
+
+void BenchAdBlockRuleIndex::replay_data()
+{
+  QTest::addColumn<bool>("indexed");
+
+  QTest::newRow("linear") << false;
+  QTest::newRow("index") << true;
+}
+
+void BenchAdBlockRuleIndex::replay()
+{
+  QFETCH(bool, indexed);
+
+  int blocked = 0;
+  QBENCHMARK {
+    blocked = replayLog(indexed);
+  }
+
+  // Index may find other matching rule, but has to block the same requests
+  QCOMPARE(blocked, replayLog(!indexed));
+  QVERIFY(blocked > 0);
+}
+
+/** @brief Count of blocked requests of log
+ *---------------------------------------------------------------------------*/
+int BenchAdBlockRuleIndex::replayLog(bool indexed) const
+{
+  int blocked = 0;
+  foreach (const Request &request, m_requests) {
+    if (indexed ? findIndexed(request) : findLinear(request))
+      ++blocked;
+  }
+  return blocked;
+}
+
+const AdBlockRule* BenchAdBlockRuleIndex::findLinear(const Request &request) const
+{
+  foreach (const AdBlockRule* rule, m_exceptionRules) {
+    if (rule->networkMatch(request.request, request.domain, request.urlString))
+      return 0;
+  }
+  foreach (const AdBlockRule* rule, m_blockRules) {
+    if (rule->networkMatch(request.request, request.domain, request.urlString))
+      return rule;
+  }
+  return 0;
+}
+
+const AdBlockRule* BenchAdBlockRuleIndex::findIndexed(const Request &request) const
+{
+  if (m_exceptionIndex.find(request.request, request.domain, request.urlString))
+    return 0;
+  return m_blockIndex.find(request.request, request.domain, request.urlString);
+}
+
+QStringList BenchAdBlockRuleIndex::generateRules()
+{
+  QStringList rules;
+  rules << "! Generated EasyList-like rules"
+        << "/ad_" << "-ads-" << "_adv/" << "?ad=";
+  for (int i = 0; rules.count() < kRulesCount; ++i) {
+    switch (i % 10) {
+    case 0: rules << QString("||ads%1.example-cdn.com^").arg(i); break;
+    case 1: rules << QString("||tracker%1.net^$third-party").arg(i); break;
+    case 2: rules << QString("/banner%1/*").arg(i); break;
+    case 3: rules << QString("-ad-%1x90.").arg(i); break;
+    case 4: rules << QString("&adslot%1=").arg(i); break;
+    case 5: rules << QString("/adserver/%1/*.js$script").arg(i); break;
+    case 6: rules << QString("@@||cdn%1.example.org/ads.js$script").arg(i); break;
+    case 7: rules << QString("/^https?:\\/\\/[a-z]+%1\\.adnet\\.com\\/serve/").arg(i); break;
+    case 8: rules << QString("example%1.com##.ad-banner").arg(i); break;
+    default: rules << QString("|http://pixel%1.stats.com/").arg(i); break;
+    }
+  }
+  return rules;
+}
+
+QStringList BenchAdBlockRuleIndex::generateLog()
+{
+  QStringList log;
+  for (int i = 0; i < kRequestsCount; ++i) {
+    QString referer = QString("http://news%1.example.com/").arg(i % 50);
+    int n = (i * 37) % (kRulesCount * 2);
+    switch (i % 12) {
+    case 0: log << QString("http://ads%1.example-cdn.com/img/1.gif %2 image").arg(n).arg(referer); break;
+    case 1: log << QString("http://tracker%1.net/t.js %2 script").arg(n).arg(referer); break;
+    case 2: log << QString("http://img.example.com/banner%1/top.png %2 image").arg(n).arg(referer); break;
+    case 3: log << QString("http://cdn%1.example.org/ads.js %2 script").arg(n).arg(referer); break;
+    case 4: log << QString("http://x%1.adnet.com/serve/b.js %2 script").arg(n).arg(referer); break;
+    case 5: log << QString("http://pixel%1.stats.com/p.gif %2 image").arg(n).arg(referer); break;
+    default:
+      log << QString("http://news%1.example.com/article/%2.html?id=%3 %4 subdocument")
+             .arg(i % 50).arg(i).arg(n).arg(referer);
+      break;
+    }
+  }
+  return log;
+}
+
+QStringList BenchAdBlockRuleIndex::readLines(const QString &fileName)
+{
+  QStringList lines;
+  QFile file(fileName);
+  if (!file.open(QFile::ReadOnly)) {
+    qWarning() << __PRETTY_FUNCTION__ << __LINE__ << file.errorString() << fileName;
+    return lines;
+  }
+  QTextStream in(&file);
+  in.setCodec("UTF-8");
+  while (!in.atEnd()) {
+    QString line = in.readLine().trimmed();
+    if (!line.isEmpty())
+      lines.append(line);
+  }
+  return lines;
+}
+
+QTEST_GUILESS_MAIN(BenchAdBlockRuleIndex)
+#include "bench_adblockruleindex.moc"
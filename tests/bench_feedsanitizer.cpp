@@ -0,0 +1,130 @@
+#include "feedsanitizer.h"
+
+#include <QtTest>
+
+/** @brief Benchmark of streaming FeedSanitizer against former fix of whole data
+ *---------------------------------------------------------------------------*/
+class BenchFeedSanitizer : public QObject
+{
+  Q_OBJECT
+private slots:
+  void legacy_data();
+  void legacy();
+  void sanitizer_data();
+  void sanitizer();
+
+private:
+  static QByteArray generateFeed(int itemsCount);
+  static QByteArray legacySanitize(QByteArray data);
+
+  QHash<int, QByteArray> legacyResults_;  // items count -> former fix result
+};
+
+/** @brief Generate RSS with bare '&', entities and "<br>" in every item
+ *---------------------------------------------------------------------------*/
+QByteArray BenchFeedSanitizer::generateFeed(int itemsCount)
+{
+  QByteArray feed("\n  <?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                  "<rss version=\"2.0\"><channel>\n"
+                  "<title>Tom & Jerry news</title>\n"
+                  "<link>http://example.com/?a=1&b=2</link>\n");
+  for (int i = 0; i < itemsCount; ++i) {
+    feed.append("<item>\n<title>Item ").append(QByteArray::number(i))
+        .append(" & more &amp; &#169; &copy;</title>\n"
+                "<link>http://example.com/news?id=")
+        .append(QByteArray::number(i))
+        .append("&lang=en&ref=rss</link>\n"
+                "<description>First line<br>second line & third<br>"
+                "R&D &lt;tag&gt; Q&A</description>\n</item>\n");
+  }
+  feed.append("</channel></rss>\n<!-- trailing garbage & <br> -->\n");
+  return feed;
+}
+
+/** @brief Fix of feed data done by RequestFeed::finished before FeedSanitizer
+ *---------------------------------------------------------------------------*/
+QByteArray BenchFeedSanitizer::legacySanitize(QByteArray data)
+{
+  data = data.trimmed();
+
+  QRegExp rx("&(?!([a-z0-9#]+;))", Qt::CaseInsensitive);
+  int pos = 0;
+  while ((pos = rx.indexIn(QString::fromLatin1(data), pos)) != -1) {
+    data.replace(pos, 1, "&amp;");
+    pos += 1;
+  }
+
+  data.replace("<br>", "<br/>");
+
+  if (data.indexOf("</rss>") > 0)
+    data.resize(data.indexOf("</rss>") + 6);
+  if (data.indexOf("</feed>") > 0)
+    data.resize(data.indexOf("</feed>") + 7);
+  if (data.indexOf("</rdf:RDF>") > 0)
+    data.resize(data.indexOf("</rdf:RDF>") + 10);
+
+  return data;
+}
+
+void BenchFeedSanitizer::legacy_data()
+{
+  QTest::addColumn<int>("itemsCount");
+
+  QTest::newRow("100 items") << 100;
+  QTest::newRow("500 items") << 500;
+  // About 2 MiB with 60000 bare '&', every one of them copies whole data
+  QTest::newRow("10000 items") << 10000;
+}
+
+void BenchFeedSanitizer::legacy()
+{
+  QFETCH(int, itemsCount);
+
+  QByteArray feed = generateFeed(itemsCount);
+  QByteArray data;
+  QBENCHMARK {
+    data = legacySanitize(feed);
+  }
+  QVERIFY(data.endsWith("</rss>"));
+  legacyResults_.insert(itemsCount, data);
+}
+
+void BenchFeedSanitizer::sanitizer_data()
+{
+  QTest::addColumn<int>("itemsCount");
+  QTest::addColumn<int>("chunkSize");
+
+  QTest::newRow("100 items, 1 KiB chunks") << 100 << 1024;
+  QTest::newRow("100 items, 16 KiB chunks") << 100 << 16384;
+  QTest::newRow("10000 items, 1 KiB chunks") << 10000 << 1024;
+  QTest::newRow("10000 items, 16 KiB chunks") << 10000 << 16384;
+}
+
+void BenchFeedSanitizer::sanitizer()
+{
+  QFETCH(int, itemsCount);
+  QFETCH(int, chunkSize);
+
+  QByteArray feed = generateFeed(itemsCount);
+  QList<QByteArray> chunks;
+  for (int pos = 0; pos < feed.size(); pos += chunkSize)
+    chunks.append(feed.mid(pos, chunkSize));
+
+  QByteArray data;
+  QBENCHMARK {
+    FeedSanitizer sanitizer;
+    foreach (const QByteArray &chunk, chunks)
+      sanitizer.write(chunk);
+    data = sanitizer.finish();
+  }
+
+  // Result is checked against the former fix, which is run once outside of
+  // benchmark unless legacy() has already done it for this size
+  if (!legacyResults_.contains(itemsCount))
+    legacyResults_.insert(itemsCount, legacySanitize(feed));
+  QCOMPARE(data, legacyResults_.value(itemsCount));
+  QVERIFY(data.endsWith("</rss>"));
+}
+
+QTEST_GUILESS_MAIN(BenchFeedSanitizer)
+#include "bench_feedsanitizer.moc"
@@ -0,0 +1,84 @@
+#include "sqlitedriver.h"
+
+#include <QtSql>
+#include <QtTest>
+
+const int kRowsCount = 20000;
+const char kPattern[] = "(linux|qt)\\s+\\d+\\.\\d+";
+
+/** @brief Benchmark of REGEXP of SQLite extension with and without cached pattern
+ *---------------------------------------------------------------------------*/
+class BenchRegExp : public QObject
+{
+  Q_OBJECT
+private slots:
+  void initTestCase();
+  void cleanupTestCase();
+  void regexp_data();
+  void regexp();
+};
+
+void BenchRegExp::initTestCase()
+{
+  SQLiteDriver *driver = new SQLiteDriver();
+  QSqlDatabase db = QSqlDatabase::addDatabase(driver);
+  db.setDatabaseName(":memory:");
+  QVERIFY(db.open());
+
+  QSqlQuery q(db);
+  QVERIFY(q.exec("CREATE TABLE news(title varchar, pattern varchar)"));
+
+  QStringList words;
+  words << "Release" << "of" << "Qt" << "Linux" << "kernel" << "desktop"
+        << "update" << "news" << "feed" << "reader";
+
+  db.transaction();
+  q.prepare("INSERT INTO news(title, pattern) VALUES (?, ?)");
+  for (int i = 0; i < kRowsCount; ++i) {
+    QString title;
+    for (int j = 0; j < 8; ++j)
+      title.append(words.at((i + j * 7) % words.count())).append(' ');
+    title.append(QString("%1.%2").arg(i % 7).arg(i % 13));
+    q.addBindValue(title);
+    q.addBindValue(QString(kPattern));
+    QVERIFY(q.exec());
+  }
+  QVERIFY(db.commit());
+}
+
+void BenchRegExp::cleanupTestCase()
+{
+  QSqlDatabase::database().close();
+  QSqlDatabase::removeDatabase(QSqlDatabase::defaultConnection);
+}
+
+void BenchRegExp::regexp_data()
+{
+  QTest::addColumn<QString>("query");
+
+  // Constant pattern is compiled once per statement and kept as auxdata
+  QTest::newRow("constant pattern")
+      << QString("SELECT count(*) FROM news WHERE title REGEXP '%1'").arg(kPattern);
+  // Pattern read from a column is compiled again for every row
+  QTest::newRow("per-row pattern")
+      << QString("SELECT count(*) FROM news WHERE title REGEXP pattern");
+}
+
+void BenchRegExp::regexp()
+{
+  QFETCH(QString, query);
+
+  QSqlQuery q;
+  q.setForwardOnly(true);
+  int count = -1;
+  QBENCHMARK {
+    QVERIFY(q.exec(query));
+    QVERIFY(q.next());
+    count = q.value(0).toInt();
+  }
+  QVERIFY(count > 0);
+  QVERIFY(count < kRowsCount);
+}
+
+QTEST_GUILESS_MAIN(BenchRegExp)
+#include "bench_regexp.moc"
@@ -0,0 +1,416 @@
+#include "legacyfeedparser.h"
+
+#include <QDebug>
+#include <QTextCodec>
+#include <QTextStream>
+#include <QUrl>
+#include <qzregexp.h>
+
+LegacyFeedParser::LegacyFeedParser()
+{
+}
+
+/** @brief Parse feed data the way ParseObject did before FeedParser
+ *----------------------------------------------------------------------------*/
+bool LegacyFeedParser::parse(const QByteArray &xmlData, const QString &feedUrl,
+                             const QString &codecName)
+{
+  feedType_.clear();
+  feedItem_ = FeedItemStruct();
+  newsList_.clear();
+
+  bool codecOk = false;
+  QString convertData(xmlData);
+  QDomDocument doc;
+  QString errorStr;
+  int errorLine;
+  int errorColumn;
+
+  QzRegExp rx("encoding=\"([^\"]+)", Qt::CaseInsensitive);
+  int pos = rx.indexIn(xmlData);
+  if (pos == -1) {
+    rx.setPattern("encoding='([^']+)");
+    pos = rx.indexIn(xmlData);
+  }
+  if (pos > -1) {
+    QString codecNameT = rx.cap(1);
+    qDebug() << "Codec name (1):" << codecNameT;
+    QTextCodec *codec = QTextCodec::codecForName(codecNameT.toUtf8());
+    if (codec) {
+      convertData = codec->toUnicode(xmlData);
+    } else {
+      qWarning() << "Codec not found (1): " << codecNameT << feedUrl;
+      if (codecNameT.contains("us-ascii", Qt::CaseInsensitive)) {
+        QString str(xmlData);
+        convertData = str.remove(rx.cap(0)+"\"");
+      }
+    }
+  } else {
+    if (!codecName.isEmpty()) {
+      qDebug() << "Codec name (2):" << codecName;
+      QTextCodec *codec = QTextCodec::codecForName(codecName.toUtf8());
+      if (codec) {
+        convertData = codec->toUnicode(xmlData);
+        codecOk = true;
+      } else {
+        qWarning() << "Codec not found (2): " << codecName << feedUrl;
+      }
+    }
+    if (!codecOk) {
+      codecOk = false;
+      QStringList codecNameList;
+      codecNameList << "UTF-8" << "Windows-1251" << "KOI8-R" << "KOI8-U"
+                    << "ISO 8859-5" << "IBM 866";
+      foreach (QString codecNameT, codecNameList) {
+        QTextCodec *codec = QTextCodec::codecForName(codecNameT.toUtf8());
+        if (codec && codec->canEncode(xmlData)) {
+          qDebug() << "Codec name (3):" << codecNameT;
+          convertData = codec->toUnicode(xmlData);
+          codecOk = true;
+          break;
+        }
+      }
+      if (!codecOk) {
+        convertData = QString::fromLocal8Bit(xmlData);
+      }
+    }
+  }
+
+  if (!doc.setContent(convertData, false, &errorStr, &errorLine, &errorColumn)) {
+    qWarning() << QString("Parse data error (2): url %1, line %2, column %3: %4").
+                  arg(feedUrl).arg(errorLine).arg(errorColumn).arg(errorStr);
+    return false;
+  }
+
+  QDomElement rootElem = doc.documentElement();
+  feedType_ = rootElem.tagName();
+
+  if (feedType_ == "feed") {
+    parseAtom(feedUrl, doc);
+  } else if ((feedType_ == "rss") || (feedType_ == "rdf:RDF")) {
+    parseRss(feedUrl, doc);
+  }
+  return true;
+}
+
+void LegacyFeedParser::parseAtom(const QString &feedUrl, const QDomDocument &doc)
+{
+  QDomElement rootElem = doc.documentElement();
+  FeedItemStruct feedItem;
+
+  feedItem.linkBase = rootElem.attribute("xml:base");
+  feedItem.title = toPlainText(rootElem.namedItem("title").toElement().text());
+  feedItem.description = rootElem.namedItem("subtitle").toElement().text();
+  feedItem.updated = rootElem.namedItem("updated").toElement().text();
+  feedItem.updated = parseDate(feedItem.updated, feedUrl);
+  QDomElement authorElem = rootElem.namedItem("author").toElement();
+  if (!authorElem.isNull()) {
+    feedItem.author = toPlainText(authorElem.namedItem("name").toElement().text());
+    if (feedItem.author.isEmpty()) feedItem.author = toPlainText(authorElem.text());
+    feedItem.authorUri = authorElem.namedItem("uri").toElement().text();
+    feedItem.authorEmail = authorElem.namedItem("email").toElement().text();
+  }
+  feedItem.language = rootElem.namedItem("language").toElement().text();
+  QDomNodeList linksList = rootElem.elementsByTagName("link");
+  for (int j = 0; j < linksList.size(); j++) {
+    if (linksList.at(j).toElement().attribute("rel") == "alternate") {
+      feedItem.link = linksList.at(j).toElement().attribute("href");
+      break;
+    }
+  }
+  if (feedItem.link.isEmpty()) {
+    for (int j = 0; j < linksList.size(); j++) {
+        if (!(linksList.at(j).toElement().attribute("rel") == "self")) {
+          feedItem.link = linksList.at(j).toElement().attribute("href");
+          break;
+        }
+    }
+  }
+
+  if (QUrl(feedItem.link).host().isEmpty() || (QUrl(feedItem.link).host().indexOf('.')) == -1) {
+    if (!feedItem.linkBase.isEmpty() && !QUrl(feedItem.linkBase).host().isEmpty())
+      feedItem.link = QUrl(feedItem.linkBase).scheme() %  "://" % QUrl(feedItem.linkBase).host();
+    else
+      feedItem.link = QUrl(feedUrl).scheme() %  "://" % QUrl(feedUrl).host();
+  }
+  if (feedItem.linkBase.isEmpty() && !QUrl(feedItem.link).host().isEmpty())
+    feedItem.linkBase = QUrl(feedItem.link).scheme() %  "://" % QUrl(feedItem.link).host();
+  if (QUrl(feedItem.link).host().isEmpty())
+    feedItem.link = feedItem.linkBase + feedItem.link;
+  feedItem.link = toPlainText(feedItem.link);
+  QUrl url = QUrl(feedItem.link);
+  if (url.scheme().isEmpty())
+    url.setScheme(QUrl(feedUrl).scheme());
+  feedItem.link = url.toString();
+
+  feedItem_ = feedItem;
+
+  QDomNodeList newsList = doc.elementsByTagName("entry");
+  for (int i = 0; i < newsList.size(); i++) {
+    NewsItemStruct newsItem;
+    newsItem.id = newsList.item(i).namedItem("id").toElement().text();
+    newsItem.title = toPlainText(newsList.item(i).namedItem("title").toElement().text());
+    newsItem.updated = newsList.item(i).namedItem("published").toElement().text();
+    if (newsItem.updated.isEmpty())
+      newsItem.updated = newsList.item(i).namedItem("updated").toElement().text();
+    if (newsItem.updated.isEmpty())
+      newsItem.updated = newsList.item(i).namedItem("issued").toElement().text();
+    newsItem.updated = parseDate(newsItem.updated, feedUrl);
+    QDomElement authorElem = newsList.item(i).namedItem("author").toElement();
+    if (!authorElem.isNull()) {
+      newsItem.author = toPlainText(authorElem.namedItem("name").toElement().text());
+      if (newsItem.author.isEmpty()) newsItem.author = toPlainText(authorElem.text());
+      newsItem.authorUri = authorElem.namedItem("uri").toElement().text();
+      newsItem.authorEmail = authorElem.namedItem("email").toElement().text();
+    }
+
+    newsItem.description = newsList.item(i).namedItem("summary").toElement().text();
+    QDomNode nodeSummary = newsList.item(i).namedItem("summary");
+    if (!nodeSummary.isNull() && newsItem.description.isEmpty()) {
+      QTextStream in(&newsItem.description);
+      nodeSummary.save(in, 0);
+    }
+    QDomNode nodeContent = newsList.item(i).namedItem("content");
+    if (nodeContent.toElement().attribute("type") == "xhtml") {
+      QTextStream in(&newsItem.content);
+      nodeContent.save(in, 0);
+    } else {
+      newsItem.content = nodeContent.toElement().text();
+    }
+    QString imgUrl = newsList.item(i).namedItem("media:thumbnail").toElement().attribute("url");
+    QString community = getCommunity(newsList.item(i).namedItem("media:community"));
+    nodeContent = newsList.item(i).namedItem("media:group");
+    if (!nodeContent.isNull()) {
+      QString description = nodeContent.namedItem("media:description").toElement().text();
+      if (description.length() > newsItem.content.length())
+        newsItem.content = description;
+      newsItem.content = fromPlainText(newsItem.content);
+      if (imgUrl.isEmpty())
+        imgUrl = nodeContent.namedItem("media:thumbnail").toElement().attribute("url");
+      if (community.isEmpty())
+        community = getCommunity(nodeContent.namedItem("media:community"));
+    }
+    if (!(newsItem.content.isEmpty() ||
+          (newsItem.description.length() > newsItem.content.length()))) {
+      newsItem.description = newsItem.content;
+    }
+    newsItem.content.clear();
+    if (!imgUrl.isEmpty()) {
+      newsItem.description = "<p class=\"description\">" + newsItem.description + "</p>";
+      newsItem.description += "<img src=\"" + imgUrl + "\" alt=\"image\"/>";
+    }
+    if (!community.isEmpty())
+      newsItem.description += community;
+
+    QDomNodeList categoryElem = newsList.item(i).toElement().elementsByTagName("category");
+    for (int j = 0; j < categoryElem.size(); j++) {
+      if (!newsItem.category.isEmpty()) newsItem.category.append(", ");
+      QString category = categoryElem.at(j).toElement().attribute("label");
+      if (category.isEmpty())
+        category = categoryElem.at(j).toElement().attribute("term");
+      newsItem.category.append(toPlainText(category));
+    }
+    QDomElement enclosureElem = newsList.item(i).namedItem("enclosure").toElement();
+    newsItem.eUrl = enclosureElem.attribute("url");
+    newsItem.eType = enclosureElem.attribute("type");
+    newsItem.eLength = enclosureElem.attribute("length");
+    QDomNodeList linksList = newsList.item(i).toElement().elementsByTagName("link");
+    for (int j = 0; j < linksList.size(); j++) {
+      auto parentTagName = linksList.at(j).parentNode().toElement().tagName();
+      if (QString::compare(parentTagName, "source", Qt::CaseInsensitive) == 0)
+      {
+        continue;
+      }
+
+      if (linksList.at(j).toElement().attribute("type") == "text/html") {
+        if (linksList.at(j).toElement().attribute("rel") == "self")
+          newsItem.link = linksList.at(j).toElement().attribute("href");
+        if (linksList.at(j).toElement().attribute("rel") == "alternate")
+          newsItem.linkAlternate = linksList.at(j).toElement().attribute("href");
+        if (linksList.at(j).toElement().attribute("rel") == "replies")
+          newsItem.comments = linksList.at(j).toElement().attribute("href");
+#if 1
+      } else if (newsItem.linkAlternate.isEmpty()) {
+#else
+      } else {
+#endif
+        if (linksList.at(j).toElement().attribute("rel") == "alternate")
+          newsItem.linkAlternate = linksList.at(j).toElement().attribute("href");
+      }
+    }
+    for (int j = 0; j < linksList.size(); j++) {
+      if (newsItem.linkAlternate.isEmpty()) {
+        if (!(linksList.at(j).toElement().attribute("rel") == "self")) {
+          newsItem.linkAlternate = linksList.at(j).toElement().attribute("href");
+          break;
+        }
+      }
+    }
+
+    if (!newsItem.link.isEmpty() && QUrl(newsItem.link).host().isEmpty())
+      newsItem.link = feedItem.linkBase + newsItem.link;
+    newsItem.link = toPlainText(newsItem.link);
+    if (!newsItem.linkAlternate.isEmpty() && QUrl(newsItem.linkAlternate).host().isEmpty())
+      newsItem.linkAlternate = feedItem.linkBase + newsItem.linkAlternate;
+    newsItem.linkAlternate = toPlainText(newsItem.linkAlternate);
+    if (newsItem.link.isEmpty()) {
+      newsItem.link = newsItem.linkAlternate;
+      newsItem.linkAlternate.clear();
+    }
+    url = QUrl(newsItem.link);
+    if (url.scheme().isEmpty())
+      url.setScheme(QUrl(feedUrl).scheme());
+    newsItem.link = url.toString();
+
+    newsList_.append(newsItem);
+  }
+}
+
+void LegacyFeedParser::parseRss(const QString &feedUrl, const QDomDocument &doc)
+{
+  QDomNode channel = doc.documentElement().namedItem("channel");
+  if (channel.isNull())
+    channel = doc.documentElement().namedItem("rss:channel");
+  FeedItemStruct feedItem;
+
+  feedItem.title = toPlainText(channel.namedItem("title").toElement().text());
+  if (feedItem.title.isEmpty())
+    feedItem.title = toPlainText(channel.namedItem("rss:title").toElement().text());
+  feedItem.description = channel.namedItem("description").toElement().text();
+  if (feedItem.description.isEmpty())
+    feedItem.description = toPlainText(channel.namedItem("rss:description").toElement().text());
+  feedItem.link = toPlainText(channel.namedItem("link").toElement().text());
+  if (feedItem.link.isEmpty())
+    feedItem.link = toPlainText(channel.namedItem("rss:link").toElement().text());
+  QUrl url = QUrl(feedItem.link);
+  if (url.host().isEmpty())
+    url.setHost(QUrl(feedUrl).host());
+  if (url.scheme().isEmpty())
+    url.setScheme(QUrl(feedUrl).scheme());
+  feedItem.link = url.toString();
+
+  feedItem.updated = channel.namedItem("pubDate").toElement().text();
+  if (feedItem.updated.isEmpty())
+    feedItem.updated = channel.namedItem("pubdate").toElement().text();
+  feedItem.updated = parseDate(feedItem.updated, feedUrl);
+  feedItem.author = toPlainText(channel.namedItem("author").toElement().text());
+  feedItem.language = channel.namedItem("language").toElement().text();
+  if (feedItem.language.isEmpty())
+    feedItem.language = channel.namedItem("dc:language").toElement().text();
+
+  feedItem_ = feedItem;
+
+  QDomNodeList newsList = doc.elementsByTagName("item");
+  if (newsList.isEmpty())
+    newsList = doc.elementsByTagName("rss:item");
+  for (int i = 0; i < newsList.size(); i++) {
+    NewsItemStruct newsItem;
+    newsItem.id = newsList.item(i).namedItem("guid").toElement().text();
+    newsItem.title = toPlainText(newsList.item(i).namedItem("title").toElement().text());
+    if (newsItem.title.isEmpty())
+      newsItem.title = toPlainText(newsList.item(i).namedItem("rss:title").toElement().text());
+    newsItem.updated = newsList.item(i).namedItem("pubDate").toElement().text();
+    if (newsItem.updated.isEmpty())
+      newsItem.updated = newsList.item(i).namedItem("pubdate").toElement().text();
+    if (newsItem.updated.isEmpty())
+      newsItem.updated = newsList.item(i).namedItem("dc:date").toElement().text();
+    newsItem.updated = parseDate(newsItem.updated, feedUrl);
+    newsItem.author = toPlainText(newsList.item(i).namedItem("author").toElement().text());
+    if (newsItem.author.isEmpty())
+      newsItem.author = toPlainText(newsList.item(i).namedItem("dc:creator").toElement().text());
+    newsItem.link = toPlainText(newsList.item(i).namedItem("link").toElement().text());
+    if (newsItem.link.isEmpty()) {
+        newsItem.link = toPlainText(newsList.item(i).namedItem("rss:link").toElement().text());
+        if (newsItem.link.isEmpty()) {
+            if (newsList.item(i).namedItem("guid").toElement().attribute("isPermaLink") == "true")
+                newsItem.link = newsItem.id;
+        }
+    }
+    url = QUrl(newsItem.link);
+    if (url.host().isEmpty())
+      url.setHost(QUrl(feedUrl).host());
+    if (url.scheme().isEmpty())
+      url.setScheme(QUrl(feedUrl).scheme());
+    newsItem.link = url.toString();
+
+    newsItem.description = newsList.item(i).namedItem("description").toElement().text();
+    QDomNode nodeSummary = newsList.item(i).namedItem("description");
+    if (!nodeSummary.isNull() && newsItem.description.isEmpty()) {
+      QTextStream in(&newsItem.description);
+      nodeSummary.save(in, 0);
+    }
+    newsItem.content = newsList.item(i).namedItem("content:encoded").toElement().text();
+    QDomNode nodeContent = newsList.item(i).namedItem("content:encoded");
+    if (!nodeContent.isNull() && newsItem.content.isEmpty()) {
+      QTextStream in(&newsItem.content);
+      nodeContent.save(in, 0);
+    }
+    QString imgUrl = newsList.item(i).namedItem("media:thumbnail").toElement().attribute("url");
+    QString community = getCommunity(newsList.item(i).namedItem("media:community"));
+    nodeContent = newsList.item(i).namedItem("media:group");
+    if (!nodeContent.isNull()) {
+      QString description = nodeContent.namedItem("media:description").toElement().text();
+      if (description.length() > newsItem.content.length())
+        newsItem.content = description;
+      newsItem.content = fromPlainText(newsItem.content);
+      if (imgUrl.isEmpty())
+        imgUrl = nodeContent.namedItem("media:thumbnail").toElement().attribute("url");
+      if (community.isEmpty())
+        community = getCommunity(nodeContent.namedItem("media:community"));
+    }
+    if (!(newsItem.content.isEmpty() ||
+          (newsItem.description.length() > newsItem.content.length()))) {
+      newsItem.description = newsItem.content;
+    }
+    newsItem.content.clear();
+    if (!imgUrl.isEmpty()) {
+      newsItem.description = "<p class=\"description\">" + newsItem.description + "</p>";
+      newsItem.description += "<img src=\"" + imgUrl + "\" alt=\"image\"/>";
+    }
+    if (!community.isEmpty())
+      newsItem.description += community;
+
+    QDomNodeList categoryElem = newsList.item(i).toElement().elementsByTagName("category");
+    for (int j = 0; j < categoryElem.size(); j++) {
+      if (!newsItem.category.isEmpty()) newsItem.category.append(", ");
+      newsItem.category.append(toPlainText(categoryElem.at(j).toElement().text()));
+    }
+    newsItem.comments = newsList.item(i).namedItem("comments").toElement().text();
+    QDomElement enclosureElem = newsList.item(i).namedItem("enclosure").toElement();
+    newsItem.eUrl = enclosureElem.attribute("url");
+    newsItem.eType = enclosureElem.attribute("type");
+    newsItem.eLength = enclosureElem.attribute("length");
+
+    if (newsItem.title.isEmpty()) {
+      newsItem.title = toPlainText(newsItem.description);
+      if (newsItem.title.size() > 50) {
+        newsItem.title.resize(50);
+        newsItem.title = newsItem.title % "...";
+      }
+    }
+
+    newsList_.append(newsItem);
+  }
+}
+
+QString LegacyFeedParser::getCommunity(const QDomNode &nodeContent)
+{
+  QString community;
+  if (!nodeContent.isNull()) {
+    QString count = nodeContent.namedItem("media:starRating").toElement().attribute("count");
+    QString average = nodeContent.namedItem("media:starRating").toElement().attribute("average");
+    QString min = nodeContent.namedItem("media:starRating").toElement().attribute("min");
+    QString max = nodeContent.namedItem("media:starRating").toElement().attribute("max");
+    QString views = nodeContent.namedItem("media:statistics").toElement().attribute("views");
+    if (!count.isEmpty())
+      community = QString("Count: %1, average: %2, min: %3, max: %4<br>").
+          arg(count).arg(average).arg(min).arg(max);
+    if (!views.isEmpty())
+      community += QString("Views: %1").arg(views);
+    if (!community.isEmpty())
+      community = "<p><i>" + community + "</i></p>";
+  }
+  return community;
+}
+
+/** @brief Date/time string parsing
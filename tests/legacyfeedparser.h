@@ -0,0 +1,47 @@
+#ifndef LEGACYFEEDPARSER_H
+#define LEGACYFEEDPARSER_H
+
+#include "feedparser.h"
+
+#include <QDomDocument>
+
+/** @brief QDomDocument parser used by ParseObject before FeedParser
+ *
+ * Reference for tst_feedparser. Code is kept as it was, only writing into
+ * base is replaced with filling of feed and news items.
+ *----------------------------------------------------------------------------*/
+class LegacyFeedParser
+{
+public:
+  LegacyFeedParser();
+
+  bool parse(const QByteArray &xmlData, const QString &feedUrl,
+             const QString &codecName = QString());
+
+  QString feedType() const { return feedType_; }
+  FeedItemStruct feedItem() const { return feedItem_; }
+  QList<NewsItemStruct> newsList() const { return newsList_; }
+
+private:
+  void parseAtom(const QString &feedUrl, const QDomDocument &doc);
+  void parseRss(const QString &feedUrl, const QDomDocument &doc);
+  QString getCommunity(const QDomNode &nodeContent);
+
+  // Helpers are not changed by FeedParser
+  static QString toPlainText(const QString &text) {
+    return FeedParser::toPlainText(text);
+  }
+  static QString fromPlainText(const QString &text) {
+    return FeedParser::fromPlainText(text);
+  }
+  static QString parseDate(const QString &dateString, const QString &urlString) {
+    return FeedParser::parseDate(dateString, urlString);
+  }
+
+  QString feedType_;
+  FeedItemStruct feedItem_;
+  QList<NewsItemStruct> newsList_;
+
+};
+
+#endif // LEGACYFEEDPARSER_H
@@ -0,0 +1,221 @@
+#include "databaseschema.h"
+#include "sqlitedriver.h"
+
+#include <QtSql>
+#include <QtTest>
+
+/** @brief Checks feed counters kept by triggers against counted news
+ * @details Tree of feeds:
+ *   1 folder
+ *     2 folder
+ *       3 feed
+ *     4 feed
+ *   5 feed
+ *---------------------------------------------------------------------------*/
+class TestFeedCounters : public QObject
+{
+  Q_OBJECT
+private slots:
+  void initTestCase();
+  void cleanupTestCase();
+  void createTriggers();
+  void insertNews();
+  void readNews();
+  void markNewsOld();
+  void deleteNews();
+  void restoreNews();
+  void moveNews();
+  void removeNews();
+  void moveFeed();
+  void removeFeed();
+
+private:
+  void exec(const QString &query);
+  void insertNews(int feedId, int count, int isNew, int read, int deleted = 0);
+  void checkCounters();
+};
+
+void TestFeedCounters::initTestCase()
+{
+  SQLiteDriver *driver = new SQLiteDriver();
+  QSqlDatabase db = QSqlDatabase::addDatabase(driver);
+  db.setDatabaseName(":memory:");
+  QVERIFY(db.open());
+
+  // Counters are passed up the tree by nested triggers
+  exec("PRAGMA recursive_triggers = ON");
+  exec(kCreateNewsTableQuery);
+  exec("CREATE TABLE feeds(id integer primary key, text varchar, "
+       "xmlUrl varchar, parentId integer default 0, unread integer, "
+       "newCount integer, undeleteCount integer)");
+  exec("INSERT INTO feeds(id, text, xmlUrl, parentId) VALUES "
+       "(1, 'folder 1', '', 0), (2, 'folder 2', '', 1), "
+       "(3, 'feed 3', 'http://example.com/3', 2), "
+       "(4, 'feed 4', 'http://example.com/4', 1), "
+       "(5, 'feed 5', 'http://example.com/5', 0)");
+
+  // News received before counters were kept by triggers
+  insertNews(3, 4, 1, 0);
+  insertNews(3, 3, 0, 1);
+  insertNews(4, 2, 0, 2);
+  insertNews(4, 2, 0, 0, 1);
+  insertNews(5, 1, 1, 0, 2);
+  exec("UPDATE feeds SET unread=7, newCount=7, undeleteCount=7");
+}
+
+void TestFeedCounters::cleanupTestCase()
+{
+  QSqlDatabase::database().close();
+  QSqlDatabase::removeDatabase(QSqlDatabase::defaultConnection);
+}
+
+void TestFeedCounters::exec(const QString &query)
+{
+  QSqlQuery q;
+  QVERIFY2(q.exec(query), qPrintable(q.lastError().text()));
+}
+
+void TestFeedCounters::insertNews(int feedId, int count, int isNew, int read, int deleted)
+{
+  QSqlQuery q;
+  q.prepare("INSERT INTO news(feedId, title, new, read, deleted) VALUES (?, ?, ?, ?, ?)");
+  for (int i = 0; i < count; ++i) {
+    q.addBindValue(feedId);
+    q.addBindValue(QString("news %1").arg(i));
+    q.addBindValue(isNew);
+    q.addBindValue(read);
+    q.addBindValue(deleted);
+    QVERIFY2(q.exec(), qPrintable(q.lastError().text()));
+  }
+}
+
+/** @brief Compare counters of every feed and folder with news of its subtree
+ *---------------------------------------------------------------------------*/
+void TestFeedCounters::checkCounters()
+{
+  QSqlQuery q;
+  QVERIFY2(q.exec(
+             "WITH RECURSIVE tree(root, id) AS ("
+             "SELECT id, id FROM feeds UNION ALL "
+             "SELECT tree.root, feeds.id FROM feeds JOIN tree ON feeds.parentId == tree.id) "
+             "SELECT feeds.id, feeds.unread, feeds.newCount, feeds.undeleteCount, "
+             "(SELECT count(news.id) FROM tree JOIN news ON news.feedId == tree.id "
+             "WHERE tree.root == feeds.id AND news.deleted == 0 AND news.read == 0), "
+             "(SELECT count(news.id) FROM tree JOIN news ON news.feedId == tree.id "
+             "WHERE tree.root == feeds.id AND news.deleted == 0 AND news.new == 1), "
+             "(SELECT count(news.id) FROM tree JOIN news ON news.feedId == tree.id "
+             "WHERE tree.root == feeds.id AND news.deleted == 0) "
+             "FROM feeds ORDER BY feeds.id"),
+           qPrintable(q.lastError().text()));
+
+  int feedsCount = 0;
+  while (q.next()) {
+    ++feedsCount;
+    int id = q.value(0).toInt();
+    QVERIFY2(q.value(1).toInt() == q.value(4).toInt(),
+             qPrintable(QString("unread of %1: %2 != %3").
+                        arg(id).arg(q.value(1).toInt()).arg(q.value(4).toInt())));
+    QVERIFY2(q.value(2).toInt() == q.value(5).toInt(),
+             qPrintable(QString("newCount of %1: %2 != %3").
+                        arg(id).arg(q.value(2).toInt()).arg(q.value(5).toInt())));
+    QVERIFY2(q.value(3).toInt() == q.value(6).toInt(),
+             qPrintable(QString("undeleteCount of %1: %2 != %3").
+                        arg(id).arg(q.value(3).toInt()).arg(q.value(6).toInt())));
+  }
+  QVERIFY(feedsCount > 0);
+}
+
+void TestFeedCounters::createTriggers()
+{
+  // Same steps as Database::createCounterTriggers() on upgraded DB
+  exec(kResetFeedCountersQuery);
+  foreach (const QString &qStr, kCreateCounterTriggersQueries) {
+    exec(qStr);
+  }
+  exec(kCountFeedCountersQuery);
+  checkCounters();
+
+  QSqlQuery q;
+  QVERIFY(q.exec("SELECT unread, newCount, undeleteCount FROM feeds WHERE id==1"));
+  QVERIFY(q.first());
+  QCOMPARE(q.value(0).toInt(), 4);
+  QCOMPARE(q.value(1).toInt(), 4);
+  QCOMPARE(q.value(2).toInt(), 9);
+}
+
+void TestFeedCounters::insertNews()
+{
+  insertNews(3, 5, 1, 0);
+  insertNews(4, 2, 1, 0);
+  insertNews(5, 3, 0, 1);
+  insertNews(5, 2, 1, 0, 1);
+  checkCounters();
+}
+
+void TestFeedCounters::readNews()
+{
+  exec("UPDATE news SET read=1 WHERE feedId==3 AND id IN "
+       "(SELECT id FROM news WHERE feedId==3 AND read==0 LIMIT 3)");
+  exec("UPDATE news SET read=2 WHERE read==1");
+  exec("UPDATE news SET read=0 WHERE feedId==5");
+  checkCounters();
+}
+
+void TestFeedCounters::markNewsOld()
+{
+  exec("UPDATE news SET new=0 WHERE feedId==4 AND new==1");
+  checkCounters();
+  exec("UPDATE news SET new=0 WHERE new==1 AND deleted==0");
+  checkCounters();
+}
+
+void TestFeedCounters::deleteNews()
+{
+  exec("UPDATE news SET deleted=1 WHERE feedId==3 AND read==0");
+  exec("UPDATE news SET deleted=1, new=1 WHERE feedId==4 AND deleted==0 AND read==2");
+  checkCounters();
+}
+
+void TestFeedCounters::restoreNews()
+{
+  exec("UPDATE news SET deleted=0, new=1 WHERE feedId==3 AND deleted==1");
+  checkCounters();
+}
+
+void TestFeedCounters::moveNews()
+{
+  exec("UPDATE news SET feedId=5 WHERE feedId==3 AND new==1");
+  exec("UPDATE news SET feedId=4, deleted=0 WHERE feedId==5 AND deleted==1");
+  checkCounters();
+}
+
+void TestFeedCounters::removeNews()
+{
+  exec("DELETE FROM news WHERE feedId==5 AND read==0");
+  exec("DELETE FROM news WHERE deleted!=0");
+  checkCounters();
+}
+
+void TestFeedCounters::moveFeed()
+{
+  exec("UPDATE feeds SET parentId=2 WHERE id==4");
+  checkCounters();
+  exec("UPDATE feeds SET parentId=0 WHERE id==2");
+  checkCounters();
+  exec("UPDATE feeds SET parentId=1 WHERE id==5");
+  checkCounters();
+}
+
+void TestFeedCounters::removeFeed()
+{
+  // Feed is removed before its news, as MainWindow does
+  exec("DELETE FROM feeds WHERE id==3");
+  exec("DELETE FROM news WHERE feedId==3");
+  checkCounters();
+  exec("DELETE FROM feeds WHERE id==2 OR id==4");
+  exec("DELETE FROM news WHERE feedId==4");
+  checkCounters();
+}
+
+QTEST_GUILESS_MAIN(TestFeedCounters)
+#include "tst_feedcounters.moc"
@@ -0,0 +1,214 @@
+#include "feedparser.h"
+#include "legacyfeedparser.h"
+
+#include <QtTest>
+
+/** @brief Checks that FeedParser reads feeds the same as former QDomDocument parser
+ *
+ * Feeds of data/feeds are read by both parsers, feed and news items have to
+ * be equal. ttl, skipHours and skipDays are not compared, former parser
+ * did not read them.
+ *---------------------------------------------------------------------------*/
+class TestFeedParser : public QObject
+{
+  Q_OBJECT
+private slots:
+  void parse_data();
+  void parse();
+  void trailingContent_data();
+  void trailingContent();
+
+private:
+  static QStringList fields(const FeedItemStruct &item);
+  static QStringList fields(const NewsItemStruct &item);
+  static QString canonicalXml(const QString &text);
+};
+
+void TestFeedParser::parse_data()
+{
+  QTest::addColumn<QString>("fileName");
+  QTest::addColumn<QString>("feedUrl");
+  QTest::addColumn<bool>("valid");
+
+  QTest::newRow("RSS 2.0")
+      << "rss2.xml" << "http://example.com/rss.xml" << true;
+  QTest::newRow("RSS 2.0 windows-1251")
+      << "rss2-cp1251.xml" << "http://example.ru/rss" << true;
+  QTest::newRow("RSS 1.0")
+      << "rdf.xml" << "http://example.org/rss.rdf" << true;
+  QTest::newRow("RSS 1.0 prefixed")
+      << "rdf-prefixed.xml" << "http://example.net/rss.rdf" << true;
+  QTest::newRow("Atom xml:base")
+      << "atom-base.xml" << "http://example.org/feed.atom" << true;
+  QTest::newRow("Atom xhtml")
+      << "atom-xhtml.xml" << "http://example.com/feed.atom" << true;
+  QTest::newRow("RSS media")
+      << "media-rss.xml" << "http://media.example.com/rss" << true;
+  QTest::newRow("Atom media")
+      << "media-atom.xml"
+      << "https://www.youtube.com/feeds/videos.xml?channel_id=UC0000000000000000000000"
+      << true;
+  QTest::newRow("malformed")
+      << "malformed.xml" << "http://broken.example.com/rss" << false;
+  QTest::newRow("truncated")
+      << "truncated.xml" << "http://truncated.example.com/atom" << false;
+}
+
+void TestFeedParser::parse()
+{
+  QFETCH(QString, fileName);
+  QFETCH(QString, feedUrl);
+  QFETCH(bool, valid);
+
+  QString path = QFINDTESTDATA("data/feeds/" + fileName);
+  QFile file(path);
+  QVERIFY2(file.open(QFile::ReadOnly), qPrintable(fileName));
+  QByteArray xmlData = file.readAll();
+
+  FeedParser parser;
+  LegacyFeedParser legacyParser;
+  bool parsed = parser.parse(xmlData, feedUrl);
+  QCOMPARE(parsed, legacyParser.parse(xmlData, feedUrl));
+  QCOMPARE(parsed, valid);
+  if (!valid) {
+    QVERIFY(!parser.errorString().isEmpty());
+    return;
+  }
+
+  QCOMPARE(parser.feedType(), legacyParser.feedType());
+  QCOMPARE(fields(parser.feedItem()), fields(legacyParser.feedItem()));
+
+  QList<NewsItemStruct> newsList = parser.newsList();
+  QList<NewsItemStruct> legacyNewsList = legacyParser.newsList();
+  QCOMPARE(newsList.count(), legacyNewsList.count());
+  QVERIFY(!newsList.isEmpty());
+  for (int i = 0; i < newsList.count(); ++i)
+    QCOMPARE(fields(newsList.at(i)), fields(legacyNewsList.at(i)));
+}
+
+/** @brief Only whitespace, comments and processing instructions may follow feed
+ *---------------------------------------------------------------------------*/
+void TestFeedParser::trailingContent_data()
+{
+  QTest::addColumn<QByteArray>("trailer");
+  QTest::addColumn<bool>("valid");
+
+  QTest::newRow("none") << QByteArray() << true;
+  QTest::newRow("whitespace") << QByteArray("\n  \r\n\t") << true;
+  QTest::newRow("comment") << QByteArray("\n<!-- cached -->\n<?pi data?>\n") << true;
+  QTest::newRow("text") << QByteArray("\ngarbage") << false;
+  QTest::newRow("second document")
+      << QByteArray("<rss version=\"2.0\"><channel><title>B</title></channel></rss>")
+      << false;
+  QTest::newRow("html") << QByteArray("\n<html><body>Error</body></html>") << false;
+}
+
+void TestFeedParser::trailingContent()
+{
+  QFETCH(QByteArray, trailer);
+  QFETCH(bool, valid);
+
+  QByteArray xmlData("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                     "<rss version=\"2.0\"><channel><title>A</title>"
+                     "<item><title>News</title><link>http://example.com/1</link></item>"
+                     "</channel></rss>");
+  xmlData.append(trailer);
+
+  FeedParser parser;
+  QCOMPARE(parser.parse(xmlData, "http://example.com/rss"), valid);
+  if (valid) {
+    QCOMPARE(parser.feedItem().title, QString("A"));
+    QCOMPARE(parser.newsList().count(), 1);
+  } else {
+    QVERIFY(!parser.errorString().isEmpty());
+    QVERIFY(parser.newsList().isEmpty());
+  }
+}
+
+QStringList TestFeedParser::fields(const FeedItemStruct &item)
+{
+  QStringList list;
+  list << "title: " + item.title
+       << "updated: " + item.updated
+       << "link: " + item.link
+       << "linkBase: " + item.linkBase
+       << "language: " + item.language
+       << "author: " + item.author
+       << "authorUri: " + item.authorUri
+       << "authorEmail: " + item.authorEmail
+       << "description: " + canonicalXml(item.description);
+  return list;
+}
+
+QStringList TestFeedParser::fields(const NewsItemStruct &item)
+{
+  QStringList list;
+  list << "id: " + item.id
+       << "title: " + item.title
+       << "updated: " + item.updated
+       << "link: " + item.link
+       << "linkAlternate: " + item.linkAlternate
+       << "language: " + item.language
+       << "author: " + item.author
+       << "authorUri: " + item.authorUri
+       << "authorEmail: " + item.authorEmail
+       << "description: " + canonicalXml(item.description)
+       << "content: " + canonicalXml(item.content)
+       << "category: " + item.category
+       << "eUrl: " + item.eUrl
+       << "eType: " + item.eType
+       << "eLength: " + item.eLength
+       << "comments: " + item.comments;
+  return list;
+}
+
+/** @brief Return markup with sorted attributes and without indentation
+ *
+ * Former parser serialised element-only content with QDomNode::save(),
+ * which indents it. Text which is not markup is returned as is.
+ *---------------------------------------------------------------------------*/
+QString TestFeedParser::canonicalXml(const QString &text)
+{
+  if (!text.contains('<'))
+    return text;
+
+  QXmlStreamReader xml("<root>" + text + "</root>");
+  xml.setNamespaceProcessing(false);
+  QString result;
+  int depth = 0;
+  while (!xml.atEnd()) {
+    QXmlStreamReader::TokenType token = xml.readNext();
+    if (token == QXmlStreamReader::StartElement) {
+      if (depth++ == 0)
+        continue;
+      QStringList attributes;
+      foreach (const QXmlStreamAttribute &attr, xml.attributes())
+        attributes.append(attr.qualifiedName() % "=\"" % attr.value() % "\"");
+      foreach (const QXmlStreamNamespaceDeclaration &ns, xml.namespaceDeclarations()) {
+        QString name("xmlns");
+        if (!ns.prefix().isEmpty())
+          name.append(":" % ns.prefix());
+        attributes.append(name % "=\"" % ns.namespaceUri() % "\"");
+      }
+      attributes.sort();
+      result.append("<" % xml.qualifiedName());
+      foreach (const QString &attr, attributes)
+        result.append(" " % attr);
+      result.append(">");
+    } else if (token == QXmlStreamReader::EndElement) {
+      if (--depth == 0)
+        continue;
+      result.append("</" % xml.qualifiedName() % ">");
+    } else if (token == QXmlStreamReader::Characters) {
+      if (!xml.isWhitespace())
+        result.append(xml.text().toString().trimmed());
+    }
+  }
+  // Html which is not well-formed xml is compared as is
+  if (xml.hasError())
+    return text;
+  return result;
+}
+
+QTEST_GUILESS_MAIN(TestFeedParser)
+#include "tst_feedparser.moc"
@@ -0,0 +1,119 @@
+#include "databaseschema.h"
+#include "sqlitedriver.h"
+
+#include <QtSql>
+#include <QtTest>
+
+/** @brief Checks that hot news queries are served by news table indexes
+ *---------------------------------------------------------------------------*/
+class TestNewsIndexes : public QObject
+{
+  Q_OBJECT
+private slots:
+  void initTestCase();
+  void cleanupTestCase();
+  void queryPlan_data();
+  void queryPlan();
+
+private:
+  QStringList explainQueryPlan(const QString &query);
+};
+
+void TestNewsIndexes::initTestCase()
+{
+  SQLiteDriver *driver = new SQLiteDriver();
+  QSqlDatabase db = QSqlDatabase::addDatabase(driver);
+  db.setDatabaseName(":memory:");
+  QVERIFY(db.open());
+
+  QSqlQuery q(db);
+  QVERIFY2(q.exec(kCreateNewsTableQuery), qPrintable(q.lastError().text()));
+  foreach (const QString &qStr, kCreateNewsIndexesQueries) {
+    QVERIFY2(q.exec(qStr), qPrintable(q.lastError().text()));
+  }
+}
+
+void TestNewsIndexes::cleanupTestCase()
+{
+  QSqlDatabase::database().close();
+  QSqlDatabase::removeDatabase(QSqlDatabase::defaultConnection);
+}
+
+void TestNewsIndexes::queryPlan_data()
+{
+  QTest::addColumn<QString>("query");
+  QTest::addColumn<QString>("index");
+  QTest::addColumn<bool>("sorted");
+
+  QTest::newRow("feed unread")
+      << "SELECT id FROM news WHERE feedId=='1' AND deleted=0 AND read=0"
+      << "feedId_flags" << false;
+  QTest::newRow("feed undeleted count")
+      << "SELECT count(id) FROM news WHERE feedId=='1' AND deleted==0"
+      << "feedId_flags" << false;
+  QTest::newRow("feed reset new")
+      << "UPDATE news SET new=0 WHERE feedId=='1' AND new==1"
+      << "feedId_flags" << false;
+  QTest::newRow("feed by published")
+      << "SELECT id, published FROM news WHERE feedId=='1' ORDER BY published"
+      << "feedId_published" << true;
+  QTest::newRow("feed undeleted by published")
+      << "SELECT id FROM news WHERE feedId=='1' AND deleted=0 ORDER BY published DESC"
+      << "feedId_published" << true;
+  QTest::newRow("feed new notifications")
+      << "SELECT id, title FROM news WHERE new=1 AND feedId=='1' ORDER BY received DESC"
+      << "newNews" << false;
+  QTest::newRow("reset new")
+      << "UPDATE news SET new=0 WHERE new==1"
+      << "newNews" << false;
+  QTest::newRow("category starred")
+      << "SELECT id FROM news WHERE deleted=0 AND starred=1"
+      << "flags" << false;
+  QTest::newRow("category deleted count")
+      << "SELECT count(id) FROM news WHERE deleted=1"
+      << "flags" << false;
+}
+
+void TestNewsIndexes::queryPlan()
+{
+  QFETCH(QString, query);
+  QFETCH(QString, index);
+  QFETCH(bool, sorted);
+
+  QStringList plan = explainQueryPlan(query);
+  QVERIFY(!plan.isEmpty());
+
+  bool indexUsed = false;
+  bool tempTree = false;
+  foreach (const QString &detail, plan) {
+    // "SEARCH news USING [COVERING ]INDEX <index> (...)" or
+    // "SCAN news USING INDEX <index>"
+    if (detail.contains(QString("INDEX %1 ").arg(index)) ||
+        detail.endsWith(QString("INDEX %1").arg(index)))
+      indexUsed = true;
+    if (detail.contains("TEMP B-TREE"))
+      tempTree = true;
+  }
+  QVERIFY2(indexUsed, qPrintable(plan.join("; ")));
+  if (sorted)
+    QVERIFY2(!tempTree, qPrintable(plan.join("; ")));
+}
+
+/** @brief Return detail column of EXPLAIN QUERY PLAN for query
+ *---------------------------------------------------------------------------*/
+QStringList TestNewsIndexes::explainQueryPlan(const QString &query)
+{
+  QStringList plan;
+  QSqlQuery q;
+  q.setForwardOnly(true);
+  if (!q.exec("EXPLAIN QUERY PLAN " + query)) {
+    qWarning() << __PRETTY_FUNCTION__ << __LINE__ << q.lastError().text();
+    return plan;
+  }
+  while (q.next())
+    plan.append(q.value(q.record().count() - 1).toString());
+  return plan;
+}
+
+QTEST_GUILESS_MAIN(TestNewsIndexes)
+#include "tst_newsindexes.moc"